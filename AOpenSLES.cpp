@@ -12,8 +12,10 @@
 #include <android/log.h>
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
-#include "RingBuffer.h"
+#include "StreamCore.h"
 #include "Waveform.h"
+#include "Mixer.h"
+#include "ObjectCache.h"
 #include "AOpenSLES.h"
 
 //==============================================================================
@@ -72,6 +74,92 @@ SLInterfaceID AOpenSLES_SL_IID_PLAY;
 SLInterfaceID AOpenSLES_SL_IID_ENGINE;
 SLInterfaceID AOpenSLES_SL_IID_RECORD;
 //==============================================================================
+// OpenSL ES Engine
+//
+// One engine and output mix serve every stream in the process. Streams that
+// are destroyed park their realized player or recorder in a small cache keyed
+// by format, and each parked object keeps its own reference on the engine.
+//==============================================================================
+struct AOpenSLESEngine
+{
+    SLObjectItf engineObject;
+    SLEngineItf engineEngine;
+    SLObjectItf outputMixObject;
+};
+//------------------------------------------------------------------------------
+static void AOpenSLESEngineDestroy(void* object)
+{
+    AOpenSLESEngine& thiz = *(AOpenSLESEngine*)object;
+
+    if (thiz.outputMixObject != nullptr)
+    {
+        (*thiz.outputMixObject)->Destroy(thiz.outputMixObject);
+        thiz.outputMixObject = nullptr;
+    }
+
+    thiz.engineEngine = nullptr;
+
+    if (thiz.engineObject != nullptr)
+    {
+        (*thiz.engineObject)->Destroy(thiz.engineObject);
+        thiz.engineObject = nullptr;
+    }
+
+    delete &thiz;
+}
+//------------------------------------------------------------------------------
+static void* AOpenSLESEngineCreate()
+{
+    AOpenSLESEngine* engine = nullptr;
+
+    switch (0) case 0: default:
+    {
+        if (AOpenSLESAvailable == false)
+            break;
+
+        engine = new (std::nothrow) AOpenSLESEngine{};
+        if (engine == nullptr)
+            break;
+        AOpenSLESEngine& thiz = (*engine);
+
+        if (AOpenSLESCreateEngine(&thiz.engineObject, 0, nullptr, 0, nullptr, nullptr) != SL_RESULT_SUCCESS)
+            break;
+        if ((*thiz.engineObject)->Realize(thiz.engineObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
+            break;
+        if ((*thiz.engineObject)->GetInterface(thiz.engineObject, AOpenSLES_SL_IID_ENGINE, &thiz.engineEngine) != SL_RESULT_SUCCESS)
+            break;
+        if ((*thiz.engineEngine)->CreateOutputMix(thiz.engineEngine, &thiz.outputMixObject, 0, nullptr, nullptr) != SL_RESULT_SUCCESS)
+            break;
+        if ((*thiz.outputMixObject)->Realize(thiz.outputMixObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
+            break;
+
+        return engine;
+    }
+    if (engine)
+    {
+        AOpenSLESEngineDestroy(engine);
+    }
+
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+static ObjectShared AOpenSLESEngineShared(AOpenSLESEngineCreate, AOpenSLESEngineDestroy);
+//------------------------------------------------------------------------------
+static void AOpenSLESObjectDestroy(void* object)
+{
+    SLObjectItf item = (SLObjectItf)object;
+
+    (*item)->Destroy(item);
+    AOpenSLESEngineShared.Release();
+}
+//------------------------------------------------------------------------------
+static ObjectCache AOpenSLESObjectCache(AOpenSLESObjectDestroy);
+//------------------------------------------------------------------------------
+void AOpenSLESFlush()
+{
+    AOpenSLESObjectCache.Flush();
+}
+//==============================================================================
 // OpenSL ES Utility
 //==============================================================================
 struct AOpenSLES
@@ -92,24 +180,11 @@ struct AOpenSLES
     SLAndroidAutomaticGainControlItf recorderAGC;
     SLAndroidNoiseSuppressionItf recorderNS;
 
-    RingBuffer bufferQueue;
-    uint64_t bufferQueueSend;
-    uint64_t bufferQueuePick;
-    int64_t bufferQueueSendAdjust;
-    int64_t bufferQueuePickAdjust;
-
-    uint32_t channel;
-    uint32_t sampleRate;
-    uint32_t bytesPerSecond;
-
-    float volume;
+    StreamCore core;
 
     bool cancel;
-    bool ready;
-    bool go;
-    bool record;
+    bool park;
 
-    int bufferSize;
     short temp[8192];
 };
 //------------------------------------------------------------------------------
@@ -120,38 +195,73 @@ static void playerCallback(SLAndroidSimpleBufferQueueItf, void* context)
     if (thiz.cancel == false)
     {
         short* output = (short*)thiz.temp;
-        uint64_t outputSize = thiz.bufferSize;
-        if (thiz.go)
-        {
-            thiz.bufferQueuePick += thiz.bufferQueue.Gather(thiz.bufferQueuePick, output, outputSize, true);
-            scaleWaveform(output, outputSize, thiz.volume);
-        }
-        else
-        {
-            memset(output, 0, outputSize);
-        }
+        uint64_t outputSize = thiz.core.DeviceSize(thiz.core.bufferSize);
+        thiz.core.Play(output, outputSize);
 
         (*thiz.playerBufferQueue)->Enqueue(thiz.playerBufferQueue, output, outputSize);
 
         return;
     }
 
-    thiz.ready = false;
+    thiz.core.ready = false;
 }
 //------------------------------------------------------------------------------
 static void recorderCallback(SLAndroidSimpleBufferQueueItf, void* context)
 {
     AOpenSLES& thiz = *(AOpenSLES*)context;
+    if (thiz.cancel)
+        return;
 
     short* input = (short*)thiz.temp;
-    uint64_t inputSize = 1024 * sizeof(short) * thiz.channel;
-    scaleWaveform(input, inputSize, thiz.volume);
-    thiz.bufferQueueSend += thiz.bufferQueue.Scatter(thiz.bufferQueueSend, input, inputSize);
+    uint64_t inputSize = 1024 * sizeWaveform(thiz.core.deviceFormat) * thiz.core.deviceChannel;
+    thiz.core.Record(input, inputSize);
 
     (*thiz.recorderBufferQueue)->Enqueue(thiz.recorderBufferQueue, input, inputSize);
 }
 //------------------------------------------------------------------------------
-struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuffer, bool record)
+static void AOpenSLESStart(void* context)
+{
+    AOpenSLES& thiz = *(AOpenSLES*)context;
+
+    if (thiz.core.record)
+    {
+        (*thiz.recorderRecord)->SetRecordState(thiz.recorderRecord, SL_RECORDSTATE_RECORDING);
+        (*thiz.recorderBufferQueue)->Enqueue(thiz.recorderBufferQueue, thiz.temp, sizeWaveform(thiz.core.deviceFormat) * thiz.core.deviceChannel);
+    }
+    else
+    {
+        (*thiz.playerPlay)->SetPlayState(thiz.playerPlay, SL_PLAYSTATE_PLAYING);
+        (*thiz.playerBufferQueue)->Enqueue(thiz.playerBufferQueue, thiz.temp, sizeWaveform(thiz.core.deviceFormat) * thiz.core.deviceChannel);
+    }
+}
+//------------------------------------------------------------------------------
+// SL_SPEAKER bits are the speaker bits of Waveform, so the device layout goes
+// across as is.
+static void* AOpenSLESFormat(AOpenSLES& thiz, SLDataFormat_PCM& formatPCM, SLAndroidDataFormat_PCM_EX& formatFloat)
+{
+    formatPCM.numChannels = thiz.core.deviceChannel;
+    formatPCM.channelMask = thiz.core.deviceMask;
+    formatFloat.numChannels = formatPCM.numChannels;
+    formatFloat.channelMask = formatPCM.channelMask;
+
+    return (thiz.core.deviceFormat == WAVEFORM_F32) ? (void*)&formatFloat : (void*)&formatPCM;
+}
+//------------------------------------------------------------------------------
+// A parked object sits under the device channels and format it was created
+// with, after any fallback, and brings its own engine reference along.
+static SLObjectItf AOpenSLESObjectTake(AOpenSLES& thiz, int sampleRate, bool record)
+{
+    uint64_t key = ObjectCache::Key(thiz.core.deviceChannel, sampleRate, thiz.core.deviceFormat, record);
+    SLObjectItf cached = (SLObjectItf)AOpenSLESObjectCache.Take(key);
+    if (cached)
+    {
+        AOpenSLESEngineShared.Release();
+    }
+
+    return cached;
+}
+//------------------------------------------------------------------------------
+struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuffer, bool record, int format)
 {
     AOpenSLES* openSLES = nullptr;
 
@@ -160,50 +270,45 @@ struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuff
         if (AOpenSLESAvailable == false)
             break;
 
-        if (channel == 0)
-            break;
-        if (sampleRate == 0)
-            break;
-
         openSLES = new AOpenSLES{};
         if (openSLES == nullptr)
             break;
         AOpenSLES& thiz = (*openSLES);
 
-        if (thiz.bufferQueue.Startup(sampleRate * sizeof(int16_t) * channel * secondPerBuffer) == false)
+        if (thiz.core.Startup(channel, sampleRate, secondPerBuffer, record, format, AOpenSLESStart, openSLES) == false)
             break;
 
-        if (AOpenSLESCreateEngine(&thiz.engineObject, 0, nullptr, 0, nullptr, nullptr) != SL_RESULT_SUCCESS)
-            break;
-        if ((*thiz.engineObject)->Realize(thiz.engineObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
-            break;
-        if ((*thiz.engineObject)->GetInterface(thiz.engineObject, AOpenSLES_SL_IID_ENGINE, &thiz.engineEngine) != SL_RESULT_SUCCESS)
+        AOpenSLESEngine* engine = (AOpenSLESEngine*)AOpenSLESEngineShared.Acquire();
+        if (engine == nullptr)
             break;
+        thiz.engineObject = engine->engineObject;
+        thiz.engineEngine = engine->engineEngine;
+        thiz.outputMixObject = engine->outputMixObject;
+
+        // Buffer queues take float from Android 5.0 on. There is no low-aligned
+        // 24-bit container, so S24 converts to float as well. A layout or a
+        // format the engine refuses steps down to stereo and then to 16 bits.
+        thiz.core.deviceFormat = (format == WAVEFORM_S16) ? WAVEFORM_S16 : WAVEFORM_F32;
+
+        SLObjectItf cached = AOpenSLESObjectTake(thiz, sampleRate, record);
 
         SLDataLocator_AndroidSimpleBufferQueue locatorQueue = { SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, 2 };
         SLDataFormat_PCM formatPCM = { SL_DATAFORMAT_PCM, 2, SL_SAMPLINGRATE_44_1,
                                        SL_PCMSAMPLEFORMAT_FIXED_16, SL_PCMSAMPLEFORMAT_FIXED_16,
                                        SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN } ;
 
-        switch (channel)
-        {
-        case 1:
-            formatPCM.numChannels = 1;
-            formatPCM.channelMask = SL_SPEAKER_FRONT_CENTER;
-            break;
-        case 2:
-        default:
-            formatPCM.numChannels = 2;
-            formatPCM.channelMask = SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT;
-            break;
-        }
         formatPCM.samplesPerSec = sampleRate * 1000u;
 
+        SLAndroidDataFormat_PCM_EX formatFloat = { SL_ANDROID_DATAFORMAT_PCM_EX, formatPCM.numChannels, formatPCM.samplesPerSec,
+                                                   SL_PCMSAMPLEFORMAT_FIXED_32, SL_PCMSAMPLEFORMAT_FIXED_32,
+                                                   formatPCM.channelMask, SL_BYTEORDER_LITTLEENDIAN, SL_ANDROID_PCM_REPRESENTATION_FLOAT };
+        void* formatData = AOpenSLESFormat(thiz, formatPCM, formatFloat);
+
         if (record)
         {
             SLDataLocator_IODevice locIO = { SL_DATALOCATOR_IODEVICE, SL_IODEVICE_AUDIOINPUT, SL_DEFAULTDEVICEID_AUDIOINPUT, nullptr };
             SLDataSource audioSource = { &locIO, nullptr };
-            SLDataSink audioSink = { &locatorQueue, &formatPCM };
+            SLDataSink audioSink = { &locatorQueue, formatData };
             SLInterfaceID ids[] =
             {
                 AOpenSLES_SL_IID_ANDROIDACOUSTICECHOCANCELLATION,
@@ -222,14 +327,35 @@ struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuff
             };
             SLuint32 presetValue = SL_ANDROID_RECORDING_PRESET_VOICE_COMMUNICATION;
 
-            if ((*thiz.engineEngine)->CreateAudioRecorder(thiz.engineEngine, &thiz.recorderObject, &audioSource, &audioSink, 5, ids, req) != SL_RESULT_SUCCESS)
-                break;
-            if ((*thiz.recorderObject)->GetInterface(thiz.recorderObject, AOpenSLES_SL_IID_ANDROIDCONFIGURATION, &thiz.recorderConfig) != SL_RESULT_SUCCESS)
-                break;
-            if ((*thiz.recorderConfig)->SetConfiguration(thiz.recorderConfig, SL_ANDROID_KEY_RECORDING_PRESET, &presetValue, sizeof(SLuint32)) != SL_RESULT_SUCCESS)
-                break;
-            if ((*thiz.recorderObject)->Realize(thiz.recorderObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
-                break;
+            thiz.recorderObject = cached;
+            if (thiz.recorderObject == nullptr)
+            {
+                // A stream that fell back before parked under the key it fell
+                // back to, so each step looks in the cache again.
+                while ((*thiz.engineEngine)->CreateAudioRecorder(thiz.engineEngine, &thiz.recorderObject, &audioSource, &audioSink, 5, ids, req) != SL_RESULT_SUCCESS)
+                {
+                    thiz.recorderObject = nullptr;
+                    if (thiz.core.DeviceFallback() == false)
+                        break;
+                    audioSink.pFormat = AOpenSLESFormat(thiz, formatPCM, formatFloat);
+                    cached = AOpenSLESObjectTake(thiz, sampleRate, record);
+                    if (cached)
+                        break;
+                }
+                if (cached)
+                    thiz.recorderObject = cached;
+                if (thiz.recorderObject == nullptr)
+                    break;
+            }
+            if (cached == nullptr)
+            {
+                if ((*thiz.recorderObject)->GetInterface(thiz.recorderObject, AOpenSLES_SL_IID_ANDROIDCONFIGURATION, &thiz.recorderConfig) != SL_RESULT_SUCCESS)
+                    break;
+                if ((*thiz.recorderConfig)->SetConfiguration(thiz.recorderConfig, SL_ANDROID_KEY_RECORDING_PRESET, &presetValue, sizeof(SLuint32)) != SL_RESULT_SUCCESS)
+                    break;
+                if ((*thiz.recorderObject)->Realize(thiz.recorderObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
+                    break;
+            }
             if (AOpenSLES_SL_IID_ANDROIDACOUSTICECHOCANCELLATION)
                 (*thiz.recorderObject)->GetInterface(thiz.recorderObject, AOpenSLES_SL_IID_ANDROIDACOUSTICECHOCANCELLATION, &thiz.recorderAEC);
             if (AOpenSLES_SL_IID_ANDROIDAUTOMATICGAINCONTROL)
@@ -263,13 +389,8 @@ struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuff
         }
         else
         {
-            if ((*thiz.engineEngine)->CreateOutputMix(thiz.engineEngine, &thiz.outputMixObject, 0, nullptr, nullptr) != SL_RESULT_SUCCESS)
-                break;
-            if ((*thiz.outputMixObject)->Realize(thiz.outputMixObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
-                break;
-
             SLDataLocator_OutputMix locMix = { SL_DATALOCATOR_OUTPUTMIX, thiz.outputMixObject };
-            SLDataSource audioSource = { &locatorQueue, &formatPCM };
+            SLDataSource audioSource = { &locatorQueue, formatData };
             SLDataSink audioSink = { &locMix, nullptr };
             SLInterfaceID ids[1] =
             {
@@ -280,10 +401,29 @@ struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuff
                 SL_BOOLEAN_TRUE
             };
 
-            if ((*thiz.engineEngine)->CreateAudioPlayer(thiz.engineEngine, &thiz.playerObject, &audioSource, &audioSink, 1, ids, req) != SL_RESULT_SUCCESS)
-                break;
-            if ((*thiz.playerObject)->Realize(thiz.playerObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
-                break;
+            thiz.playerObject = cached;
+            if (thiz.playerObject == nullptr)
+            {
+                while ((*thiz.engineEngine)->CreateAudioPlayer(thiz.engineEngine, &thiz.playerObject, &audioSource, &audioSink, 1, ids, req) != SL_RESULT_SUCCESS)
+                {
+                    thiz.playerObject = nullptr;
+                    if (thiz.core.DeviceFallback() == false)
+                        break;
+                    audioSource.pFormat = AOpenSLESFormat(thiz, formatPCM, formatFloat);
+                    cached = AOpenSLESObjectTake(thiz, sampleRate, record);
+                    if (cached)
+                        break;
+                }
+                if (cached)
+                    thiz.playerObject = cached;
+                if (thiz.playerObject == nullptr)
+                    break;
+            }
+            if (cached == nullptr)
+            {
+                if ((*thiz.playerObject)->Realize(thiz.playerObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
+                    break;
+            }
             if ((*thiz.playerObject)->GetInterface(thiz.playerObject, AOpenSLES_SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &thiz.playerBufferQueue) != SL_RESULT_SUCCESS)
                 break;
             if ((*thiz.playerObject)->GetInterface(thiz.playerObject, AOpenSLES_SL_IID_PLAY, &thiz.playerPlay) != SL_RESULT_SUCCESS)
@@ -294,11 +434,7 @@ struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuff
                 break;
         }
 
-        thiz.channel = channel;
-        thiz.sampleRate = sampleRate;
-        thiz.bytesPerSecond = sampleRate * sizeof(int16_t) * channel;
-        thiz.volume = record ? 1.0f : 0.0f;
-        thiz.record = record;
+        thiz.park = true;
 
         return openSLES;
     }
@@ -307,57 +443,76 @@ struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuff
     return nullptr;
 }
 //------------------------------------------------------------------------------
-uint64_t AOpenSLESQueue(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+size_t AOpenSLESQueueReserve(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2])
 {
     if (openSLES == nullptr)
         return 0;
     AOpenSLES& thiz = (*openSLES);
-    if (thiz.record)
-        return 0;
-    if (bufferSize == 0)
+
+    return thiz.core.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize);
+}
+//------------------------------------------------------------------------------
+uint64_t AOpenSLESQueueCommit(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int gap)
+{
+    if (openSLES == nullptr)
         return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-    if (thiz.ready)
-    {
-        if (thiz.bufferQueueSend < thiz.bufferQueuePick || thiz.bufferQueueSend > thiz.bufferQueuePick + thiz.bytesPerSecond / 2)
-        {
-            thiz.bufferQueueSend = 0;
-            timestamp = now + thiz.bufferQueuePickAdjust;
-        }
-    }
+    return thiz.core.QueueCommit(now, timestamp, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t AOpenSLESQueue(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    if (openSLES == nullptr)
+        return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-    if (thiz.bufferQueueSend == 0 || thiz.bufferQueueSendAdjust != adjust)
-    {
-        thiz.bufferQueueSend = (timestamp + adjust) * thiz.bytesPerSecond / 1000000;
-        thiz.bufferQueueSend = thiz.bufferQueueSend - (thiz.bufferQueueSend % bufferSize);
-        thiz.bufferQueueSendAdjust = adjust;
-    }
-    thiz.bufferQueueSend += thiz.bufferQueue.Scatter(thiz.bufferQueueSend, buffer, bufferSize);
+    return thiz.core.Queue(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t AOpenSLESQueuePlanar(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    if (openSLES == nullptr)
+        return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-    if (thiz.ready == false)
-    {
-        thiz.ready = true;
+    return thiz.core.QueuePlanar(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t AOpenSLESQueueBatch(struct AOpenSLES* openSLES, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap)
+{
+    if (openSLES == nullptr)
+        return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-        adjust = 0;
-        if (now > timestamp)
-        {
-            adjust = timestamp - now;
-        }
+    return thiz.core.QueueBatch(now, adjust, packet, count, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t AOpenSLESQueueSilence(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    if (openSLES == nullptr)
+        return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-        thiz.bufferSize = bufferSize;
-        thiz.bufferQueuePick = (now + adjust) * thiz.bytesPerSecond / 1000000 - bufferSize * gap;
-        thiz.bufferQueuePick = thiz.bufferQueuePick - (thiz.bufferQueuePick % bufferSize);
-        thiz.bufferQueuePickAdjust = adjust;
+    return thiz.core.QueueSilence(now, timestamp, adjust, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+size_t AOpenSLESDequeuePeek(struct AOpenSLES* openSLES, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop)
+{
+    if (openSLES == nullptr)
+        return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-        (*thiz.playerPlay)->SetPlayState(thiz.playerPlay, SL_PLAYSTATE_PLAYING);
-        (*thiz.playerBufferQueue)->Enqueue(thiz.playerBufferQueue, thiz.temp, sizeof(short) * thiz.channel);
-    }
-    else
-    {
-        thiz.go = true;
-    }
+    return thiz.core.DequeuePeek(span, spanSize, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+void AOpenSLESDequeueRelease(struct AOpenSLES* openSLES, size_t bufferSize)
+{
+    if (openSLES == nullptr)
+        return;
+    AOpenSLES& thiz = (*openSLES);
 
-    return thiz.bufferQueuePick * 1000000 / thiz.bytesPerSecond;
+    thiz.core.DequeueRelease(bufferSize);
 }
 //------------------------------------------------------------------------------
 size_t AOpenSLESDequeue(struct AOpenSLES* openSLES, void* buffer, size_t bufferSize, bool drop)
@@ -365,32 +520,130 @@ size_t AOpenSLESDequeue(struct AOpenSLES* openSLES, void* buffer, size_t bufferS
     if (openSLES == nullptr)
         return 0;
     AOpenSLES& thiz = (*openSLES);
-    if (thiz.record == false)
-        return 0;
 
-    if (thiz.ready == false)
-    {
-        thiz.ready = true;
+    return thiz.core.Dequeue(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+size_t AOpenSLESDequeuePlanar(struct AOpenSLES* openSLES, void* const* buffer, size_t bufferSize, bool drop)
+{
+    if (openSLES == nullptr)
+        return 0;
+    AOpenSLES& thiz = (*openSLES);
 
-        (*thiz.recorderRecord)->SetRecordState(thiz.recorderRecord, SL_RECORDSTATE_RECORDING);
-        (*thiz.recorderBufferQueue)->Enqueue(thiz.recorderBufferQueue, thiz.temp, sizeof(short) * thiz.channel);
-    }
+    return thiz.core.DequeuePlanar(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESMixer(struct AOpenSLES* openSLES, struct Mixer* mixer)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+    if (thiz.core.record)
+        return false;
 
-    if (drop)
+    // Detaching stops the player before the core forgets the mixer.
+    if (mixer == nullptr)
     {
-        uint64_t available = thiz.bufferQueueSend - thiz.bufferQueuePick;
-        while (available > thiz.bytesPerSecond)
-        {
-            thiz.bufferQueuePick += thiz.bytesPerSecond;
-            available = thiz.bufferQueueSend - thiz.bufferQueuePick;
-        }
+        AOpenSLESReset(openSLES);
     }
 
-    if (thiz.bufferQueueSend < thiz.bufferQueuePick + bufferSize)
-        return 0;
-    thiz.bufferQueuePick += thiz.bufferQueue.Gather(thiz.bufferQueuePick, buffer, bufferSize, true);
+    return thiz.core.Attach(mixer, sizeof(thiz.temp));
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESConvert(struct AOpenSLES* openSLES, int sampleRate)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.Convert(sampleRate);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESDrift(struct AOpenSLES* openSLES, bool enable)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.EnableDrift(enable);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESConceal(struct AOpenSLES* openSLES, bool enable)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.EnableConceal(enable);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESPlayout(struct AOpenSLES* openSLES, bool enable)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.EnablePlayout(enable);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESVoice(struct AOpenSLES* openSLES, bool enable, bool collapse)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.EnableVoice(enable, collapse);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESSpeech(struct AOpenSLES* openSLES, uint64_t* collapsed)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.Speech(collapsed);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESMeter(struct AOpenSLES* openSLES, bool enable)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    return thiz.core.EnableMeter(enable);
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESTelemetry(struct AOpenSLES* openSLES, struct TelemetrySnapshot* snapshot)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    thiz.core.telemetry.Read(snapshot);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESLayout(struct AOpenSLES* openSLES, uint32_t channelMask, uint32_t* deviceMask)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
+
+    if (thiz.core.Layout(channelMask) == false)
+        return false;
+    if (deviceMask)
+        (*deviceMask) = thiz.core.deviceMask;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool AOpenSLESMatrix(struct AOpenSLES* openSLES, const float* matrix)
+{
+    if (openSLES == nullptr)
+        return false;
+    AOpenSLES& thiz = (*openSLES);
 
-    return bufferSize;
+    return thiz.core.Matrix(matrix);
 }
 //------------------------------------------------------------------------------
 void AOpenSLESReset(struct AOpenSLES* openSLES)
@@ -399,18 +652,16 @@ void AOpenSLESReset(struct AOpenSLES* openSLES)
         return;
     AOpenSLES& thiz = (*openSLES);
 
-    if (thiz.record)
+    if (thiz.core.record)
     {
         (*thiz.recorderRecord)->SetRecordState(thiz.recorderRecord, SL_RECORDSTATE_STOPPED);
-        thiz.ready = false;
-        thiz.go = false;
     }
     else
     {
         (*thiz.playerPlay)->SetPlayState(thiz.playerPlay, SL_PLAYSTATE_STOPPED);
-        thiz.ready = false;
-        thiz.go = false;
     }
+
+    thiz.core.Reset();
 }
 //------------------------------------------------------------------------------
 void AOpenSLESVolume(struct AOpenSLES* openSLES, float volume)
@@ -419,14 +670,7 @@ void AOpenSLESVolume(struct AOpenSLES* openSLES, float volume)
         return;
     AOpenSLES& thiz = (*openSLES);
 
-    if (thiz.record)
-    {
-        thiz.volume = volume;
-    }
-    else
-    {
-        thiz.volume = volume;
-    }
+    thiz.core.volume = volume;
 }
 //------------------------------------------------------------------------------
 void AOpenSLESDestroy(struct AOpenSLES* openSLES)
@@ -437,9 +681,24 @@ void AOpenSLESDestroy(struct AOpenSLES* openSLES)
 
     thiz.cancel = true;
 
+    // Only a stream that finished Create parks its object; the engine
+    // reference moves into the cache along with it.
+    bool park = thiz.park;
+    uint64_t key = ObjectCache::Key(thiz.core.deviceChannel, thiz.core.sampleRate, thiz.core.deviceFormat, thiz.core.record);
+
     if (thiz.playerObject != nullptr)
     {
-        (*thiz.playerObject)->Destroy(thiz.playerObject);
+        if (park)
+        {
+            (*thiz.playerPlay)->SetPlayState(thiz.playerPlay, SL_PLAYSTATE_STOPPED);
+            (*thiz.playerBufferQueue)->Clear(thiz.playerBufferQueue);
+            (*thiz.playerBufferQueue)->RegisterCallback(thiz.playerBufferQueue, nullptr, nullptr);
+            AOpenSLESObjectCache.Give(key, (void*)thiz.playerObject);
+        }
+        else
+        {
+            (*thiz.playerObject)->Destroy(thiz.playerObject);
+        }
         thiz.playerObject = nullptr;
         thiz.playerPlay = nullptr;
         thiz.playerBufferQueue = nullptr;
@@ -447,25 +706,32 @@ void AOpenSLESDestroy(struct AOpenSLES* openSLES)
 
     if (thiz.recorderObject != nullptr)
     {
-        (*thiz.recorderObject)->Destroy(thiz.recorderObject);
+        if (park)
+        {
+            (*thiz.recorderRecord)->SetRecordState(thiz.recorderRecord, SL_RECORDSTATE_STOPPED);
+            (*thiz.recorderBufferQueue)->Clear(thiz.recorderBufferQueue);
+            (*thiz.recorderBufferQueue)->RegisterCallback(thiz.recorderBufferQueue, nullptr, nullptr);
+            AOpenSLESObjectCache.Give(key, (void*)thiz.recorderObject);
+        }
+        else
+        {
+            (*thiz.recorderObject)->Destroy(thiz.recorderObject);
+        }
         thiz.recorderObject = nullptr;
         thiz.recorderRecord = nullptr;
         thiz.recorderBufferQueue = nullptr;
         thiz.recorderConfig = nullptr;
     }
 
-    if (thiz.outputMixObject != nullptr)
-    {
-        (*thiz.outputMixObject)->Destroy(thiz.outputMixObject);
-        thiz.outputMixObject = nullptr;
-    }
-
-    thiz.engineEngine = nullptr;
-
     if (thiz.engineObject != nullptr)
     {
-        (*thiz.engineObject)->Destroy(thiz.engineObject);
+        if (park == false)
+        {
+            AOpenSLESEngineShared.Release();
+        }
         thiz.engineObject = nullptr;
+        thiz.engineEngine = nullptr;
+        thiz.outputMixObject = nullptr;
     }
 
     delete openSLES;
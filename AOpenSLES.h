@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "Waveform.h"
 
 #ifndef STREAMAL_EXPORT
 #define STREAMAL_EXPORT
@@ -32,9 +33,29 @@ STREAMAL_EXPORT extern SLInterfaceID AOpenSLES_SL_IID_RECORD;
 //==============================================================================
 // OpenSL ES Utility
 //==============================================================================
-STREAMAL_EXPORT struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuffer, bool record = false);
+STREAMAL_EXPORT struct AOpenSLES* AOpenSLESCreate(int channel, int sampleRate, int secondPerBuffer, bool record = false, int format = WAVEFORM_S16);
 STREAMAL_EXPORT uint64_t AOpenSLESQueue(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t AOpenSLESQueuePlanar(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t AOpenSLESQueueBatch(struct AOpenSLES* openSLES, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap);
+STREAMAL_EXPORT uint64_t AOpenSLESQueueSilence(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+STREAMAL_EXPORT size_t AOpenSLESQueueReserve(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2]);
+STREAMAL_EXPORT uint64_t AOpenSLESQueueCommit(struct AOpenSLES* openSLES, uint64_t now, uint64_t timestamp, int gap);
 STREAMAL_EXPORT size_t AOpenSLESDequeue(struct AOpenSLES* openSLES, void* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t AOpenSLESDequeuePlanar(struct AOpenSLES* openSLES, void* const* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t AOpenSLESDequeuePeek(struct AOpenSLES* openSLES, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT void AOpenSLESDequeueRelease(struct AOpenSLES* openSLES, size_t bufferSize);
+STREAMAL_EXPORT bool AOpenSLESMixer(struct AOpenSLES* openSLES, struct Mixer* mixer);
+STREAMAL_EXPORT bool AOpenSLESConvert(struct AOpenSLES* openSLES, int sampleRate);
+STREAMAL_EXPORT bool AOpenSLESDrift(struct AOpenSLES* openSLES, bool enable);
+STREAMAL_EXPORT bool AOpenSLESConceal(struct AOpenSLES* openSLES, bool enable);
+STREAMAL_EXPORT bool AOpenSLESPlayout(struct AOpenSLES* openSLES, bool enable);
+STREAMAL_EXPORT bool AOpenSLESVoice(struct AOpenSLES* openSLES, bool enable, bool collapse = false);
+STREAMAL_EXPORT bool AOpenSLESSpeech(struct AOpenSLES* openSLES, uint64_t* collapsed = nullptr);
+STREAMAL_EXPORT bool AOpenSLESMeter(struct AOpenSLES* openSLES, bool enable);
+STREAMAL_EXPORT bool AOpenSLESTelemetry(struct AOpenSLES* openSLES, struct TelemetrySnapshot* snapshot);
+STREAMAL_EXPORT bool AOpenSLESLayout(struct AOpenSLES* openSLES, uint32_t channelMask, uint32_t* deviceMask = nullptr);
+STREAMAL_EXPORT bool AOpenSLESMatrix(struct AOpenSLES* openSLES, const float* matrix);
 STREAMAL_EXPORT void AOpenSLESReset(struct AOpenSLES* openSLES);
 STREAMAL_EXPORT void AOpenSLESVolume(struct AOpenSLES* openSLES, float volume);
 STREAMAL_EXPORT void AOpenSLESDestroy(struct AOpenSLES* openSLES);
+STREAMAL_EXPORT void AOpenSLESFlush();
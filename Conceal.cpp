@@ -0,0 +1,251 @@
+//==============================================================================
+// Conceal
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <string.h>
+#include <new>
+#include "Waveform.h"
+#include "Conceal.h"
+
+//==============================================================================
+// Conceal
+//==============================================================================
+static size_t ConcealFrames(uint32_t sampleRate, int microseconds)
+{
+    size_t frames = size_t(uint64_t(sampleRate) * microseconds / 1000000);
+    return frames ? frames : 1;
+}
+//------------------------------------------------------------------------------
+// Normalized correlation of the last window against the window lag frames
+// earlier, squared so the sign of a negative match survives the compare.
+//------------------------------------------------------------------------------
+static double ConcealScore(const Conceal& thiz, const float* history, size_t lag)
+{
+    size_t end = thiz.historyFrames - lag;
+    const float* recent = history + (thiz.historyFrames - thiz.window) * thiz.channel;
+    const float* before = history + (end - thiz.window) * thiz.channel;
+
+    double power = thiz.energy[end] - thiz.energy[end - thiz.window];
+    if (power <= 0.0)
+        return 0.0;
+
+    double match = correlateWaveform(recent, before, thiz.window * thiz.channel);
+    if (match <= 0.0)
+        return 0.0;
+
+    return match * match / power;
+}
+//------------------------------------------------------------------------------
+Conceal::Conceal() : channel(0), sampleRate(0), historyFrames(0), pitchMin(0), pitchMax(0), window(0), overlapMax(0), hold(0), fade(0), history(nullptr), cycle(nullptr), energy(nullptr), pitch(0), overlap(0), phase(0), recovered(0), lost(0), active(false)
+{
+}
+//------------------------------------------------------------------------------
+Conceal::~Conceal()
+{
+    Shutdown();
+}
+//------------------------------------------------------------------------------
+bool Conceal::Startup(int channel, int sampleRate)
+{
+    Conceal& thiz = (*this);
+    if (channel <= 0 || channel > WAVEFORM_CHANNEL_MAX || sampleRate <= 0)
+        return false;
+    if (thiz.history && thiz.channel == (uint32_t)channel && thiz.sampleRate == (uint32_t)sampleRate)
+    {
+        thiz.Reset();
+        return true;
+    }
+
+    thiz.Shutdown();
+    thiz.channel = channel;
+    thiz.sampleRate = sampleRate;
+    thiz.pitchMin = ConcealFrames(sampleRate, CONCEAL_PITCH_MIN);
+    thiz.pitchMax = ConcealFrames(sampleRate, CONCEAL_PITCH_MAX);
+    thiz.window = ConcealFrames(sampleRate, CONCEAL_WINDOW);
+    thiz.overlapMax = ConcealFrames(sampleRate, CONCEAL_OVERLAP);
+    thiz.hold = ConcealFrames(sampleRate, CONCEAL_HOLD);
+    thiz.fade = ConcealFrames(sampleRate, CONCEAL_FADE);
+    thiz.historyFrames = thiz.pitchMax + thiz.window + 1;
+
+    thiz.history = new (std::nothrow) float[thiz.historyFrames * channel];
+    thiz.cycle = new (std::nothrow) float[thiz.pitchMax * channel];
+    thiz.energy = new (std::nothrow) double[thiz.historyFrames + 1];
+    if (thiz.history == nullptr || thiz.cycle == nullptr || thiz.energy == nullptr)
+    {
+        thiz.Shutdown();
+        return false;
+    }
+    thiz.Reset();
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void Conceal::Shutdown()
+{
+    Conceal& thiz = (*this);
+
+    delete[] thiz.history;
+    delete[] thiz.cycle;
+    delete[] thiz.energy;
+    thiz.history = nullptr;
+    thiz.cycle = nullptr;
+    thiz.energy = nullptr;
+    thiz.historyFrames = 0;
+    thiz.active = false;
+}
+//------------------------------------------------------------------------------
+void Conceal::Reset()
+{
+    Conceal& thiz = (*this);
+
+    thiz.pitch = 0;
+    thiz.overlap = 0;
+    thiz.phase = 0;
+    thiz.recovered = 0;
+    thiz.lost = 0;
+    thiz.active = false;
+}
+//------------------------------------------------------------------------------
+void Conceal::Begin(const float* history)
+{
+    Conceal& thiz = (*this);
+    if (thiz.historyFrames == 0)
+        return;
+    size_t channel = thiz.channel;
+
+    // Running energy per frame, so the power of any lagged window is one
+    // subtraction.
+    thiz.energy[0] = 0.0;
+    for (size_t i = 0; i < thiz.historyFrames; ++i)
+    {
+        const float* frame = history + i * channel;
+        double power = 0.0;
+        for (size_t c = 0; c < channel; ++c)
+            power += frame[c] * frame[c];
+        thiz.energy[i + 1] = thiz.energy[i] + power;
+    }
+
+    // Every other lag first, then the neighbours of the best one.
+    size_t best = thiz.pitchMax;
+    double bestScore = 0.0;
+    for (size_t lag = thiz.pitchMin; lag <= thiz.pitchMax; lag += 2)
+    {
+        double score = ConcealScore(thiz, history, lag);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = lag;
+        }
+    }
+    size_t around = best;
+    for (size_t lag = around - 1; lag <= around + 1; lag += 2)
+    {
+        if (lag < thiz.pitchMin || lag > thiz.pitchMax)
+            continue;
+        double score = ConcealScore(thiz, history, lag);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = lag;
+        }
+    }
+
+    // One period, with its last quarter crossfaded into the frames that led
+    // up to its first one.
+    size_t pitch = best;
+    size_t overlap = pitch / 4 < thiz.overlapMax ? pitch / 4 : thiz.overlapMax;
+    if (overlap == 0)
+        overlap = 1;
+    const float* period = history + (thiz.historyFrames - pitch) * channel;
+    const float* before = period - overlap * channel;
+    memcpy(thiz.cycle, period, pitch * channel * sizeof(float));
+    for (size_t i = 0; i < overlap; ++i)
+    {
+        float in = (i + 0.5f) / overlap;
+        float out = 1.0f - in;
+        float* sample = thiz.cycle + (pitch - overlap + i) * channel;
+        const float* lead = before + i * channel;
+        for (size_t c = 0; c < channel; ++c)
+            sample[c] = sample[c] * out + lead[c] * in;
+    }
+
+    thiz.pitch = pitch;
+    thiz.overlap = overlap;
+    thiz.phase = 0;
+    thiz.recovered = 0;
+    thiz.lost = 0;
+    thiz.active = true;
+}
+//------------------------------------------------------------------------------
+void Conceal::Generate(float* output, size_t frames)
+{
+    Conceal& thiz = (*this);
+    size_t channel = thiz.channel;
+
+    if (thiz.active == false || thiz.Faded())
+    {
+        memset(output, 0, frames * channel * sizeof(float));
+        thiz.lost += frames;
+        return;
+    }
+
+    for (size_t i = 0; i < frames; ++i)
+    {
+        float gain = 1.0f;
+        if (thiz.lost >= thiz.hold + thiz.fade)
+            gain = 0.0f;
+        else if (thiz.lost > thiz.hold)
+            gain = 1.0f - float(thiz.lost - thiz.hold) / thiz.fade;
+
+        const float* sample = thiz.cycle + thiz.phase * channel;
+        for (size_t c = 0; c < channel; ++c)
+            output[c] = sample[c] * gain;
+        output += channel;
+
+        thiz.phase = thiz.phase + 1 < thiz.pitch ? thiz.phase + 1 : 0;
+        thiz.lost++;
+    }
+}
+//------------------------------------------------------------------------------
+size_t Conceal::Recover(float* output, size_t frames)
+{
+    Conceal& thiz = (*this);
+    if (thiz.active == false)
+        return 0;
+    size_t channel = thiz.channel;
+
+    float carry[128 * WAVEFORM_CHANNEL_MAX];
+    size_t count = thiz.overlap - thiz.recovered;
+    if (count > frames)
+        count = frames;
+    if (count > sizeof(carry) / sizeof(float) / channel)
+        count = sizeof(carry) / sizeof(float) / channel;
+
+    thiz.Generate(carry, count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float in = (thiz.recovered + i + 0.5f) / thiz.overlap;
+        float out = 1.0f - in;
+        float* sample = output + i * channel;
+        const float* synth = carry + i * channel;
+        for (size_t c = 0; c < channel; ++c)
+            sample[c] = sample[c] * in + synth[c] * out;
+    }
+
+    thiz.recovered += count;
+    if (thiz.recovered >= thiz.overlap)
+    {
+        thiz.Reset();
+    }
+
+    return count;
+}
+//------------------------------------------------------------------------------
+bool Conceal::Faded() const
+{
+    const Conceal& thiz = (*this);
+
+    return thiz.lost >= thiz.hold + thiz.fade;
+}
@@ -0,0 +1,78 @@
+//==============================================================================
+// Conceal
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//------------------------------------------------------------------------------
+// Packet loss concealment by pitch period repetition
+//
+// Begin looks for the pitch of what played last, as the lag of best
+// normalized correlation, and keeps one period of it with its tail blended
+// into the samples a period earlier, so the cycle loops without a step.
+// Generate repeats that cycle, at full level for CONCEAL_HOLD and then
+// fading out over CONCEAL_FADE. Recover crossfades the first real samples
+// after a loss with the cycle carried on. Times are in microseconds, and
+// samples are interleaved float frames.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT Conceal
+{
+    Conceal();
+    ~Conceal();
+
+    enum
+    {
+        CONCEAL_PITCH_MIN = 2500,
+        CONCEAL_PITCH_MAX = 15000,
+        CONCEAL_WINDOW = 5000,
+        CONCEAL_OVERLAP = 2500,
+        CONCEAL_HOLD = 10000,
+        CONCEAL_FADE = 50000,
+    };
+
+    bool Startup(int channel, int sampleRate);
+    void Shutdown();
+    void Reset();
+
+    // history holds the historyFrames frames that played right before the
+    // loss, and may be the history buffer itself.
+    void Begin(const float* history);
+    void Generate(float* output, size_t frames);
+
+    // Blend up to frames real frames with the cycle, and return how many
+    // were blended. The loss is over once the overlap has been blended.
+    size_t Recover(float* output, size_t frames);
+
+    // A loss that has faded out completely generates only zeros.
+    bool Faded() const;
+
+    uint32_t channel;
+    uint32_t sampleRate;
+    size_t historyFrames;
+    size_t pitchMin;
+    size_t pitchMax;
+    size_t window;
+    size_t overlapMax;
+    size_t hold;
+    size_t fade;
+
+    float* history;
+    float* cycle;
+    double* energy;
+
+    size_t pitch;
+    size_t overlap;
+    size_t phase;
+    size_t recovered;
+    uint64_t lost;
+    bool active;
+};
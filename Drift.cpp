@@ -0,0 +1,87 @@
+//==============================================================================
+// Drift
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include "Drift.h"
+
+// Proportional trim per microsecond of level error, and integral trim per
+// microsecond of error per second. A 10 ms excess asks for 500 ppm at once.
+#define DRIFT_P 0.05
+#define DRIFT_I 0.02
+
+//==============================================================================
+// Drift
+//==============================================================================
+Drift::Drift() : bytesPerSecond(0), limit(0), begin(0), last(0), level(0.0), target(0.0), integral(0.0), ppm(0)
+{
+}
+//------------------------------------------------------------------------------
+void Drift::Startup(uint32_t bytesPerSecond, int limit)
+{
+    Drift& thiz = (*this);
+
+    thiz.bytesPerSecond = bytesPerSecond;
+    thiz.limit = limit;
+    thiz.Reset();
+}
+//------------------------------------------------------------------------------
+void Drift::Reset()
+{
+    Drift& thiz = (*this);
+
+    thiz.begin = 0;
+    thiz.last = 0;
+    thiz.level = 0.0;
+    thiz.target = 0.0;
+    thiz.integral = 0.0;
+    thiz.ppm = 0;
+}
+//------------------------------------------------------------------------------
+int Drift::Update(uint64_t now, uint64_t fill)
+{
+    Drift& thiz = (*this);
+    if (thiz.bytesPerSecond == 0)
+        return 0;
+
+    double sample = double(fill) * 1000000.0 / thiz.bytesPerSecond;
+    if (thiz.last == 0)
+    {
+        thiz.begin = now;
+        thiz.last = now;
+        thiz.level = sample;
+        return 0;
+    }
+    if (now <= thiz.last)
+        return thiz.ppm;
+
+    double elapsed = double(now - thiz.last) / 1000000.0;
+    thiz.last = now;
+    thiz.level += (sample - thiz.level) * (1.0 - exp(-elapsed * 1000000.0 / DRIFT_SMOOTH));
+
+    if (thiz.target == 0.0)
+    {
+        if (now - thiz.begin >= DRIFT_WARMUP)
+            thiz.target = thiz.level;
+        return 0;
+    }
+
+    double error = thiz.level - thiz.target;
+    thiz.integral += error * elapsed * DRIFT_I;
+    if (thiz.integral < -thiz.limit)
+        thiz.integral = -thiz.limit;
+    if (thiz.integral > thiz.limit)
+        thiz.integral = thiz.limit;
+
+    double trim = error * DRIFT_P + thiz.integral;
+    if (trim < -thiz.limit)
+        trim = -thiz.limit;
+    if (trim > thiz.limit)
+        trim = thiz.limit;
+    thiz.ppm = int(lrint(trim));
+
+    return thiz.ppm;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+//==============================================================================
+// Drift
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//------------------------------------------------------------------------------
+// Clock drift estimator
+//
+// Follows the smoothed fill level of a ring (send - pick) between a producer
+// on one clock and a device on another. The level seen during the first
+// DRIFT_WARMUP microseconds becomes the target, and from then on Update
+// returns a ratio trim in parts per million that steers the level back to
+// it, positive when the ring holds too much.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT Drift
+{
+    Drift();
+
+    enum
+    {
+        DRIFT_WARMUP = 1000000,
+        DRIFT_SMOOTH = 500000,
+    };
+
+    void Startup(uint32_t bytesPerSecond, int limit);
+    void Reset();
+    int Update(uint64_t now, uint64_t fill);
+
+    uint32_t bytesPerSecond;
+    int limit;
+
+    uint64_t begin;
+    uint64_t last;
+    double level;
+    double target;
+    double integral;
+    int ppm;
+};
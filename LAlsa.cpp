@@ -0,0 +1,540 @@
+//==============================================================================
+// Linux ALSA Wrapper
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <alsa/asoundlib.h>
+#include "StreamCore.h"
+#include "LAlsa.h"
+
+#define LALSA_POLL_MAX 8
+
+//------------------------------------------------------------------------------
+struct LAlsa
+{
+    snd_pcm_t* pcm;
+    snd_pcm_uframes_t periodFrames;
+    snd_pcm_uframes_t bufferFrames;
+    char device[64];
+    int wake[2];
+
+    StreamCore core;
+
+    std::atomic<bool> cancel;
+
+    std::thread thread;
+};
+//------------------------------------------------------------------------------
+static bool LAlsaOpen(LAlsa& thiz, snd_pcm_uframes_t periodFrames, snd_pcm_uframes_t bufferFrames)
+{
+    snd_pcm_hw_params_t* hw = nullptr;
+    snd_pcm_sw_params_t* sw = nullptr;
+    bool result = false;
+
+    switch (0) case 0: default:
+    {
+        snd_pcm_stream_t stream = thiz.core.record ? SND_PCM_STREAM_CAPTURE : SND_PCM_STREAM_PLAYBACK;
+        if (snd_pcm_open(&thiz.pcm, thiz.device, stream, SND_PCM_NONBLOCK) < 0)
+            break;
+
+        if (snd_pcm_hw_params_malloc(&hw) < 0)
+            break;
+        if (snd_pcm_hw_params_any(thiz.pcm, hw) < 0)
+            break;
+        if (snd_pcm_hw_params_set_access(thiz.pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0)
+            break;
+        // Take the stream format as is when the device has it, so Transfer
+        // moves samples without a conversion.
+        static const snd_pcm_format_t formats[WAVEFORM_FORMAT_COUNT] = { SND_PCM_FORMAT_S16, SND_PCM_FORMAT_S24, SND_PCM_FORMAT_FLOAT };
+        thiz.core.deviceFormat = thiz.core.format;
+        if (snd_pcm_hw_params_test_format(thiz.pcm, hw, formats[thiz.core.deviceFormat]) < 0)
+            thiz.core.deviceFormat = WAVEFORM_S16;
+        if (snd_pcm_hw_params_set_format(thiz.pcm, hw, formats[thiz.core.deviceFormat]) < 0)
+            break;
+        // ALSA puts the rear pair ahead of the center in 5.1 and 7.1. A device
+        // that grants another channel count runs behind a remix.
+        static const uint32_t surround[WAVEFORM_CHANNEL_MAX] =
+        {
+            WAVEFORM_FRONT_LEFT, WAVEFORM_FRONT_RIGHT, WAVEFORM_BACK_LEFT, WAVEFORM_BACK_RIGHT,
+            WAVEFORM_FRONT_CENTER, WAVEFORM_LOW_FREQUENCY, WAVEFORM_SIDE_LEFT, WAVEFORM_SIDE_RIGHT,
+        };
+        unsigned int channel = thiz.core.channel;
+        if (snd_pcm_hw_params_set_channels_near(thiz.pcm, hw, &channel) < 0)
+            break;
+        if (thiz.core.DeviceLayout(channel, channel == 6 || channel == 8 ? surround : nullptr) == false)
+            break;
+        if (snd_pcm_hw_params_set_rate_resample(thiz.pcm, hw, 1) < 0)
+            break;
+        if (snd_pcm_hw_params_set_rate(thiz.pcm, hw, thiz.core.sampleRate, 0) < 0)
+            break;
+        if (snd_pcm_hw_params_set_period_size_near(thiz.pcm, hw, &periodFrames, nullptr) < 0)
+            break;
+        if (snd_pcm_hw_params_set_buffer_size_near(thiz.pcm, hw, &bufferFrames) < 0)
+            break;
+        if (snd_pcm_hw_params(thiz.pcm, hw) < 0)
+            break;
+        snd_pcm_hw_params_get_period_size(hw, &thiz.periodFrames, nullptr);
+        snd_pcm_hw_params_get_buffer_size(hw, &thiz.bufferFrames);
+
+        // Start by hand once the first periods are in place.
+        snd_pcm_uframes_t boundary = 0;
+        if (snd_pcm_sw_params_malloc(&sw) < 0)
+            break;
+        if (snd_pcm_sw_params_current(thiz.pcm, sw) < 0)
+            break;
+        if (snd_pcm_sw_params_get_boundary(sw, &boundary) < 0)
+            break;
+        if (snd_pcm_sw_params_set_avail_min(thiz.pcm, sw, thiz.periodFrames) < 0)
+            break;
+        if (snd_pcm_sw_params_set_start_threshold(thiz.pcm, sw, boundary) < 0)
+            break;
+        if (snd_pcm_sw_params(thiz.pcm, sw) < 0)
+            break;
+        if (snd_pcm_prepare(thiz.pcm) < 0)
+            break;
+
+        result = true;
+    }
+
+    if (sw)
+        snd_pcm_sw_params_free(sw);
+    if (hw)
+        snd_pcm_hw_params_free(hw);
+
+    if (result == false && thiz.pcm)
+    {
+        snd_pcm_close(thiz.pcm);
+        thiz.pcm = nullptr;
+    }
+
+    return result;
+}
+//------------------------------------------------------------------------------
+static bool LAlsaRecover(LAlsa& thiz, int error)
+{
+    if (snd_pcm_recover(thiz.pcm, error, 1) < 0)
+        return false;
+
+    // Playback starts again from Transfer after the next fill.
+    if (thiz.core.record)
+    {
+        snd_pcm_start(thiz.pcm);
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static void LAlsaTransfer(LAlsa& thiz)
+{
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(thiz.pcm);
+    if (avail < 0)
+    {
+        LAlsaRecover(thiz, (int)avail);
+        return;
+    }
+
+    size_t frame = sizeWaveform(thiz.core.deviceFormat) * thiz.core.deviceChannel;
+    while (avail >= (snd_pcm_sframes_t)thiz.periodFrames)
+    {
+        const snd_pcm_channel_area_t* areas = nullptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t frames = thiz.periodFrames;
+        int error = snd_pcm_mmap_begin(thiz.pcm, &areas, &offset, &frames);
+        if (error < 0)
+        {
+            LAlsaRecover(thiz, error);
+            return;
+        }
+
+        // Interleaved access keeps every channel in the first area, and a
+        // chunk can come back short where the DMA buffer wraps.
+        char* area = (char*)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+        size_t size = frames * frame;
+        if (thiz.core.record)
+        {
+            thiz.core.Record(area, size);
+        }
+        else
+        {
+            thiz.core.Play(area, size);
+        }
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(thiz.pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames)
+        {
+            LAlsaRecover(thiz, committed < 0 ? (int)committed : -EPIPE);
+            return;
+        }
+        avail -= frames;
+    }
+
+    if (thiz.core.record == false && snd_pcm_state(thiz.pcm) == SND_PCM_STATE_PREPARED)
+    {
+        snd_pcm_start(thiz.pcm);
+    }
+}
+//------------------------------------------------------------------------------
+static void LAlsaThread(LAlsa& thiz)
+{
+    struct pollfd fds[LALSA_POLL_MAX + 1];
+    int count = snd_pcm_poll_descriptors_count(thiz.pcm);
+    if (count <= 0 || count > LALSA_POLL_MAX)
+        return;
+    snd_pcm_poll_descriptors(thiz.pcm, fds, count);
+    fds[count].fd = thiz.wake[0];
+    fds[count].events = POLLIN;
+    fds[count].revents = 0;
+
+    if (thiz.core.record)
+    {
+        snd_pcm_start(thiz.pcm);
+    }
+    else
+    {
+        LAlsaTransfer(thiz);
+    }
+
+    while (thiz.cancel == false)
+    {
+        if (poll(fds, count + 1, -1) < 0 && errno != EINTR)
+            break;
+        if (thiz.cancel)
+            break;
+
+        unsigned short revents = 0;
+        snd_pcm_poll_descriptors_revents(thiz.pcm, fds, count, &revents);
+        if (revents & POLLERR)
+        {
+            if (LAlsaRecover(thiz, -EPIPE) == false)
+                break;
+        }
+        if (revents & (POLLIN | POLLOUT | POLLERR))
+        {
+            LAlsaTransfer(thiz);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static void LAlsaStart(void* context)
+{
+    LAlsa& thiz = *(LAlsa*)context;
+    if (thiz.pcm == nullptr)
+        return;
+    if (thiz.thread.joinable())
+        return;
+
+    if (thiz.core.record)
+    {
+        thiz.core.bufferQueue.StoreSend(0);
+        thiz.core.bufferQueue.StorePick(0);
+    }
+
+    thiz.thread = std::thread(LAlsaThread, std::ref(thiz));
+}
+//------------------------------------------------------------------------------
+struct LAlsa* LAlsaCreate(int channel, int sampleRate, int secondPerBuffer, bool record, const char* device, int format)
+{
+    LAlsa* alsa = nullptr;
+
+    switch (0) case 0: default:
+    {
+        alsa = new (std::nothrow) LAlsa{};
+        if (alsa == nullptr)
+            break;
+        LAlsa& thiz = (*alsa);
+        thiz.wake[0] = -1;
+        thiz.wake[1] = -1;
+
+        if (thiz.core.Startup(channel, sampleRate, secondPerBuffer, record, format, LAlsaStart, alsa) == false)
+            break;
+
+        strncpy(thiz.device, device ? device : "default", sizeof(thiz.device) - 1);
+        if (LAlsaOpen(thiz, sampleRate / 100, sampleRate / 100 * 4) == false)
+            break;
+
+        if (pipe(thiz.wake) != 0)
+            break;
+
+        return alsa;
+    }
+    LAlsaDestroy(alsa);
+
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+size_t LAlsaQueueReserve(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2])
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize);
+}
+//------------------------------------------------------------------------------
+uint64_t LAlsaQueueCommit(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int gap)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.QueueCommit(now, timestamp, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t LAlsaQueue(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.Queue(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t LAlsaQueuePlanar(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.QueuePlanar(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t LAlsaQueueBatch(struct LAlsa* alsa, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.QueueBatch(now, adjust, packet, count, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t LAlsaQueueSilence(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.QueueSilence(now, timestamp, adjust, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+size_t LAlsaDequeuePeek(struct LAlsa* alsa, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.DequeuePeek(span, spanSize, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+void LAlsaDequeueRelease(struct LAlsa* alsa, size_t bufferSize)
+{
+    if (alsa == nullptr)
+        return;
+    LAlsa& thiz = (*alsa);
+
+    thiz.core.DequeueRelease(bufferSize);
+}
+//------------------------------------------------------------------------------
+size_t LAlsaDequeue(struct LAlsa* alsa, void* buffer, size_t bufferSize, bool drop)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.Dequeue(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+size_t LAlsaDequeuePlanar(struct LAlsa* alsa, void* const* buffer, size_t bufferSize, bool drop)
+{
+    if (alsa == nullptr)
+        return 0;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.DequeuePlanar(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+bool LAlsaMixer(struct LAlsa* alsa, struct Mixer* mixer)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.Attach(mixer, 0);
+}
+//------------------------------------------------------------------------------
+bool LAlsaConvert(struct LAlsa* alsa, int sampleRate)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.Convert(sampleRate);
+}
+//------------------------------------------------------------------------------
+bool LAlsaDrift(struct LAlsa* alsa, bool enable)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.EnableDrift(enable);
+}
+//------------------------------------------------------------------------------
+bool LAlsaConceal(struct LAlsa* alsa, bool enable)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.EnableConceal(enable);
+}
+//------------------------------------------------------------------------------
+bool LAlsaPlayout(struct LAlsa* alsa, bool enable)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.EnablePlayout(enable);
+}
+//------------------------------------------------------------------------------
+bool LAlsaVoice(struct LAlsa* alsa, bool enable, bool collapse)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.EnableVoice(enable, collapse);
+}
+//------------------------------------------------------------------------------
+bool LAlsaSpeech(struct LAlsa* alsa, uint64_t* collapsed)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.Speech(collapsed);
+}
+//------------------------------------------------------------------------------
+bool LAlsaMeter(struct LAlsa* alsa, bool enable)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.EnableMeter(enable);
+}
+//------------------------------------------------------------------------------
+bool LAlsaTelemetry(struct LAlsa* alsa, struct TelemetrySnapshot* snapshot)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    thiz.core.telemetry.Read(snapshot);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool LAlsaLayout(struct LAlsa* alsa, uint32_t channelMask, uint32_t* deviceMask)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    if (thiz.core.Layout(channelMask) == false)
+        return false;
+    if (deviceMask)
+        (*deviceMask) = thiz.core.deviceMask;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool LAlsaMatrix(struct LAlsa* alsa, const float* matrix)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+
+    return thiz.core.Matrix(matrix);
+}
+//------------------------------------------------------------------------------
+void LAlsaReset(struct LAlsa* alsa)
+{
+    if (alsa == nullptr)
+        return;
+    LAlsa& thiz = (*alsa);
+
+    thiz.core.Reset();
+}
+//------------------------------------------------------------------------------
+void LAlsaVolume(struct LAlsa* alsa, float volume)
+{
+    if (alsa == nullptr)
+        return;
+    LAlsa& thiz = (*alsa);
+
+    thiz.core.volume = volume;
+}
+//------------------------------------------------------------------------------
+bool LAlsaPeriod(struct LAlsa* alsa, int* periodFrames, int* bufferFrames)
+{
+    if (alsa == nullptr)
+        return false;
+    LAlsa& thiz = (*alsa);
+    if (thiz.thread.joinable())
+        return false;
+    if (periodFrames == nullptr || bufferFrames == nullptr)
+        return false;
+    if ((*periodFrames) <= 0 || (*bufferFrames) < (*periodFrames) * 2)
+        return false;
+
+    if (thiz.pcm)
+    {
+        snd_pcm_close(thiz.pcm);
+        thiz.pcm = nullptr;
+    }
+    if (LAlsaOpen(thiz, (*periodFrames), (*bufferFrames)) == false)
+        return false;
+
+    (*periodFrames) = (int)thiz.periodFrames;
+    (*bufferFrames) = (int)thiz.bufferFrames;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void LAlsaDestroy(struct LAlsa* alsa)
+{
+    if (alsa == nullptr)
+        return;
+    LAlsa& thiz = (*alsa);
+
+    if (thiz.thread.joinable())
+    {
+        thiz.cancel = true;
+        ssize_t wake = write(thiz.wake[1], "", 1);
+        (void)wake;
+        thiz.thread.join();
+    }
+
+    if (thiz.pcm)
+    {
+        snd_pcm_drop(thiz.pcm);
+        snd_pcm_close(thiz.pcm);
+        thiz.pcm = nullptr;
+    }
+
+    if (thiz.wake[0] >= 0)
+        close(thiz.wake[0]);
+    if (thiz.wake[1] >= 0)
+        close(thiz.wake[1]);
+
+    delete &thiz;
+}
+//------------------------------------------------------------------------------
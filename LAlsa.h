@@ -0,0 +1,55 @@
+//==============================================================================
+// Linux ALSA Wrapper
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Waveform.h"
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//==============================================================================
+// ALSA Utility
+//
+// Opens the PCM named by device, "default" when none is given, in mmap
+// interleaved mode. A poll() driven thread moves each period straight between
+// the ring and the device DMA area. The software "null" PCM and the snd-aloop
+// "hw:Loopback" card both work for machines without sound hardware. A device
+// that refuses the stream format runs in 16 bits behind a conversion.
+//==============================================================================
+STREAMAL_EXPORT struct LAlsa* LAlsaCreate(int channel, int sampleRate, int secondPerBuffer, bool record = false, const char* device = nullptr, int format = WAVEFORM_S16);
+STREAMAL_EXPORT uint64_t LAlsaQueue(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t LAlsaQueuePlanar(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t LAlsaQueueBatch(struct LAlsa* alsa, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap);
+STREAMAL_EXPORT uint64_t LAlsaQueueSilence(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+STREAMAL_EXPORT size_t LAlsaQueueReserve(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2]);
+STREAMAL_EXPORT uint64_t LAlsaQueueCommit(struct LAlsa* alsa, uint64_t now, uint64_t timestamp, int gap);
+STREAMAL_EXPORT size_t LAlsaDequeue(struct LAlsa* alsa, void* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t LAlsaDequeuePlanar(struct LAlsa* alsa, void* const* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t LAlsaDequeuePeek(struct LAlsa* alsa, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT void LAlsaDequeueRelease(struct LAlsa* alsa, size_t bufferSize);
+STREAMAL_EXPORT bool LAlsaMixer(struct LAlsa* alsa, struct Mixer* mixer);
+STREAMAL_EXPORT bool LAlsaConvert(struct LAlsa* alsa, int sampleRate);
+STREAMAL_EXPORT bool LAlsaDrift(struct LAlsa* alsa, bool enable);
+STREAMAL_EXPORT bool LAlsaConceal(struct LAlsa* alsa, bool enable);
+STREAMAL_EXPORT bool LAlsaPlayout(struct LAlsa* alsa, bool enable);
+STREAMAL_EXPORT bool LAlsaVoice(struct LAlsa* alsa, bool enable, bool collapse = false);
+STREAMAL_EXPORT bool LAlsaSpeech(struct LAlsa* alsa, uint64_t* collapsed = nullptr);
+STREAMAL_EXPORT bool LAlsaMeter(struct LAlsa* alsa, bool enable);
+STREAMAL_EXPORT bool LAlsaTelemetry(struct LAlsa* alsa, struct TelemetrySnapshot* snapshot);
+STREAMAL_EXPORT bool LAlsaLayout(struct LAlsa* alsa, uint32_t channelMask, uint32_t* deviceMask = nullptr);
+STREAMAL_EXPORT bool LAlsaMatrix(struct LAlsa* alsa, const float* matrix);
+STREAMAL_EXPORT void LAlsaReset(struct LAlsa* alsa);
+STREAMAL_EXPORT void LAlsaVolume(struct LAlsa* alsa, float volume);
+STREAMAL_EXPORT void LAlsaDestroy(struct LAlsa* alsa);
+
+// Asks for period and buffer sizes in frames and reports what the device
+// granted. The PCM is reopened, so this only works before the stream starts.
+// The default is a 10 ms period and four periods of buffer.
+STREAMAL_EXPORT bool LAlsaPeriod(struct LAlsa* alsa, int* periodFrames, int* bufferFrames);
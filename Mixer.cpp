@@ -0,0 +1,309 @@
+//==============================================================================
+// Software Mixer
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <thread>
+#include "StreamCore.h"
+#include "Waveform.h"
+#include "Mixer.h"
+
+#define MIXER_STREAM_MAX 32
+
+//==============================================================================
+// Mixer Utility
+//==============================================================================
+struct Mixer
+{
+    std::atomic<struct MixerStream*> streams[MIXER_STREAM_MAX];
+    std::atomic<int> streamCount;
+    std::atomic<uint32_t> rendering;
+
+    uint32_t channel;
+    uint32_t sampleRate;
+    uint32_t bytesPerSecond;
+};
+//------------------------------------------------------------------------------
+struct MixerStream
+{
+    struct Mixer* mixer;
+    int slot;
+
+    StreamCore core;
+};
+//------------------------------------------------------------------------------
+struct Mixer* MixerCreate(int channel, int sampleRate)
+{
+    Mixer* mixer = nullptr;
+
+    switch (0) case 0: default:
+    {
+        if (channel == 0)
+            break;
+        if (sampleRate == 0)
+            break;
+
+        mixer = new (std::nothrow) Mixer{};
+        if (mixer == nullptr)
+            break;
+        Mixer& thiz = (*mixer);
+
+        thiz.channel = channel;
+        thiz.sampleRate = sampleRate;
+        thiz.bytesPerSecond = sampleRate * sizeof(int16_t) * channel;
+
+        return mixer;
+    }
+    MixerDestroy(mixer);
+
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+size_t MixerRender(struct Mixer* mixer, void* buffer, size_t bufferSize, float volume)
+{
+    if (mixer == nullptr)
+        return 0;
+    Mixer& thiz = (*mixer);
+
+    thiz.rendering.fetch_add(1);
+
+    bool silence = true;
+    int count = thiz.streamCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i)
+    {
+        MixerStream* stream = thiz.streams[i].load(std::memory_order_acquire);
+        if (stream == nullptr)
+            continue;
+        StreamCore& core = stream->core;
+        if (core.go.load(std::memory_order_acquire) == false)
+            continue;
+
+        uint64_t pick = core.bufferQueue.LoadPick();
+        core.Period(pick, bufferSize);
+        float scale = core.volume.load(std::memory_order_relaxed) * volume;
+        if (scale > 0.0f)
+        {
+            // With concealment on, what lies past send is mixed in by
+            // Underrun rather than read from the ring.
+            size_t size = bufferSize;
+            if (core.concealEnable && core.concealSend < pick + size)
+                size = core.concealSend > pick ? size_t(core.concealSend - pick) : 0;
+
+            if (silence)
+            {
+                core.bufferQueue.GatherScaled(pick, buffer, size, scale);
+                memset((char*)buffer + size, 0, bufferSize - size);
+                silence = false;
+            }
+            else
+            {
+                core.bufferQueue.GatherMixed(pick, buffer, size, scale);
+            }
+            core.Underrun(pick, buffer, WAVEFORM_S16, bufferSize / sizeof(int16_t), scale, true, nullptr);
+        }
+        core.bufferQueue.StorePick(pick + bufferSize);
+    }
+    if (silence)
+    {
+        memset(buffer, 0, bufferSize);
+    }
+
+    thiz.rendering.fetch_add(1, std::memory_order_release);
+
+    return bufferSize;
+}
+//------------------------------------------------------------------------------
+bool MixerFormat(struct Mixer* mixer, int* channel, int* sampleRate)
+{
+    if (mixer == nullptr)
+        return false;
+    Mixer& thiz = (*mixer);
+
+    if (channel)
+        (*channel) = thiz.channel;
+    if (sampleRate)
+        (*sampleRate) = thiz.sampleRate;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void MixerDestroy(struct Mixer* mixer)
+{
+    if (mixer == nullptr)
+        return;
+    Mixer& thiz = (*mixer);
+
+    for (int i = 0; i < MIXER_STREAM_MAX; ++i)
+    {
+        MixerStream* stream = thiz.streams[i].load(std::memory_order_acquire);
+        if (stream)
+        {
+            MixerStreamDestroy(stream);
+        }
+    }
+
+    delete mixer;
+}
+//==============================================================================
+// Mixer Stream Utility
+//==============================================================================
+struct MixerStream* MixerStreamCreate(struct Mixer* mixer, int secondPerBuffer, int sampleRate)
+{
+    MixerStream* stream = nullptr;
+
+    switch (0) case 0: default:
+    {
+        if (mixer == nullptr)
+            break;
+
+        stream = new (std::nothrow) MixerStream{};
+        if (stream == nullptr)
+            break;
+        MixerStream& thiz = (*stream);
+
+        thiz.slot = -1;
+        if (thiz.core.Startup(mixer->channel, mixer->sampleRate, secondPerBuffer, false, WAVEFORM_S16, nullptr, nullptr) == false)
+            break;
+        if (thiz.core.Convert(sampleRate) == false)
+            break;
+        thiz.core.volume = 1.0f;
+
+        for (int i = 0; i < MIXER_STREAM_MAX; ++i)
+        {
+            MixerStream* empty = nullptr;
+            if (mixer->streams[i].compare_exchange_strong(empty, stream, std::memory_order_acq_rel))
+            {
+                thiz.slot = i;
+                break;
+            }
+        }
+        if (thiz.slot < 0)
+            break;
+        thiz.mixer = mixer;
+
+        int count = mixer->streamCount.load(std::memory_order_relaxed);
+        while (count <= thiz.slot && mixer->streamCount.compare_exchange_weak(count, thiz.slot + 1, std::memory_order_acq_rel) == false)
+            continue;
+
+        return stream;
+    }
+    MixerStreamDestroy(stream);
+
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+uint64_t MixerStreamQueue(struct MixerStream* stream, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    if (stream == nullptr)
+        return 0;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.Queue(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t MixerStreamQueuePlanar(struct MixerStream* stream, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    if (stream == nullptr)
+        return 0;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.QueuePlanar(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t MixerStreamQueueBatch(struct MixerStream* stream, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap)
+{
+    if (stream == nullptr)
+        return 0;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.QueueBatch(now, adjust, packet, count, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t MixerStreamQueueSilence(struct MixerStream* stream, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    if (stream == nullptr)
+        return 0;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.QueueSilence(now, timestamp, adjust, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+void MixerStreamReset(struct MixerStream* stream)
+{
+    if (stream == nullptr)
+        return;
+    MixerStream& thiz = (*stream);
+
+    thiz.core.Reset();
+}
+//------------------------------------------------------------------------------
+bool MixerStreamDrift(struct MixerStream* stream, bool enable)
+{
+    if (stream == nullptr)
+        return false;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.EnableDrift(enable);
+}
+//------------------------------------------------------------------------------
+bool MixerStreamConceal(struct MixerStream* stream, bool enable)
+{
+    if (stream == nullptr)
+        return false;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.EnableConceal(enable);
+}
+//------------------------------------------------------------------------------
+bool MixerStreamPlayout(struct MixerStream* stream, bool enable)
+{
+    if (stream == nullptr)
+        return false;
+    MixerStream& thiz = (*stream);
+
+    return thiz.core.EnablePlayout(enable);
+}
+//------------------------------------------------------------------------------
+bool MixerStreamTelemetry(struct MixerStream* stream, struct TelemetrySnapshot* snapshot)
+{
+    if (stream == nullptr)
+        return false;
+    MixerStream& thiz = (*stream);
+
+    thiz.core.telemetry.Read(snapshot);
+    return true;
+}
+//------------------------------------------------------------------------------
+void MixerStreamVolume(struct MixerStream* stream, float volume)
+{
+    if (stream == nullptr)
+        return;
+    MixerStream& thiz = (*stream);
+
+    thiz.core.volume.store(volume, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+void MixerStreamDestroy(struct MixerStream* stream)
+{
+    if (stream == nullptr)
+        return;
+    MixerStream& thiz = (*stream);
+
+    if (thiz.mixer && thiz.slot >= 0)
+    {
+        Mixer& mixer = (*thiz.mixer);
+        mixer.streams[thiz.slot].store(nullptr);
+
+        // Wait for a render that may still hold the stream.
+        uint32_t rendering = mixer.rendering.load();
+        while ((rendering & 1) && rendering == mixer.rendering.load())
+            std::this_thread::yield();
+    }
+
+    delete stream;
+}
+//------------------------------------------------------------------------------
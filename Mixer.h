@@ -0,0 +1,46 @@
+//==============================================================================
+// Software Mixer
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//==============================================================================
+// Mixer Utility
+//
+// One mixer feeds one output device. Each stream keeps the Queue semantics
+// of the device wrappers (timestamp, adjust, gap) with its own ring, and
+// MixerRender sums every playing stream into the device period.
+//==============================================================================
+STREAMAL_EXPORT struct Mixer* MixerCreate(int channel, int sampleRate);
+STREAMAL_EXPORT size_t MixerRender(struct Mixer* mixer, void* buffer, size_t bufferSize, float volume = 1.0f);
+STREAMAL_EXPORT bool MixerFormat(struct Mixer* mixer, int* channel, int* sampleRate);
+STREAMAL_EXPORT void MixerDestroy(struct Mixer* mixer);
+//==============================================================================
+// Mixer Stream Utility
+//==============================================================================
+// A sampleRate other than the mixer rate converts each queued buffer to the
+// mixer rate before it enters the stream ring.
+STREAMAL_EXPORT struct MixerStream* MixerStreamCreate(struct Mixer* mixer, int secondPerBuffer, int sampleRate = 0);
+STREAMAL_EXPORT uint64_t MixerStreamQueue(struct MixerStream* stream, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t MixerStreamQueuePlanar(struct MixerStream* stream, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t MixerStreamQueueBatch(struct MixerStream* stream, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap);
+STREAMAL_EXPORT uint64_t MixerStreamQueueSilence(struct MixerStream* stream, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+STREAMAL_EXPORT void MixerStreamReset(struct MixerStream* stream);
+
+// Trim the stream ratio by up to 0.5% to hold the ring at the level it settled
+// at, instead of resyncing when the sender clock drifts from the device.
+STREAMAL_EXPORT bool MixerStreamDrift(struct MixerStream* stream, bool enable);
+STREAMAL_EXPORT bool MixerStreamConceal(struct MixerStream* stream, bool enable);
+STREAMAL_EXPORT bool MixerStreamPlayout(struct MixerStream* stream, bool enable);
+STREAMAL_EXPORT bool MixerStreamTelemetry(struct MixerStream* stream, struct TelemetrySnapshot* snapshot);
+STREAMAL_EXPORT void MixerStreamVolume(struct MixerStream* stream, float volume);
+STREAMAL_EXPORT void MixerStreamDestroy(struct MixerStream* stream);
@@ -0,0 +1,537 @@
+//==============================================================================
+// Headless Null Audio Device
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+#include "RingBuffer.h"
+#include "StreamCore.h"
+#include "NullAudio.h"
+
+//------------------------------------------------------------------------------
+// The cable is indexed by clock position in bytes, so the player writes each
+// period where it starts playing and the recorder reads latency behind it.
+// Both ends hold a reference, and whichever is destroyed last frees it.
+//------------------------------------------------------------------------------
+struct NullAudioCable
+{
+    RingBuffer ring;
+    uint64_t latency;
+    std::atomic<int> reference;
+};
+//------------------------------------------------------------------------------
+struct NullAudio
+{
+    StreamCore core;
+
+    std::atomic<bool> cancel;
+
+    NullAudioCable* cable;
+    size_t periodFrames;
+
+    uint64_t (*clock)(void* context);
+    void* clockContext;
+    void (*sink)(void* context, void* buffer, size_t bufferSize);
+    void* sinkContext;
+
+    bool stepped;
+    uint64_t stepTime;
+    uint64_t stepTick;
+
+    std::thread thread;
+
+    short temp[8192];
+};
+//------------------------------------------------------------------------------
+static uint64_t NullAudioMonotonic(void*)
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+static void NullAudioCableRelease(NullAudioCable* cable)
+{
+    if (cable == nullptr)
+        return;
+
+    if (cable->reference.fetch_sub(1) == 1)
+        delete cable;
+}
+//------------------------------------------------------------------------------
+// position is the clock in bytes where the period starts. A recorder period
+// holds what the cable carried during the period that just ended.
+static size_t NullAudioRender(NullAudio& thiz, uint64_t position)
+{
+    short* buffer = thiz.temp;
+    size_t frame = sizeWaveform(thiz.core.format) * thiz.core.channel;
+    size_t bufferSize = thiz.periodFrames ? thiz.periodFrames * frame : thiz.core.bufferSize.load();
+    if (bufferSize > sizeof(thiz.temp))
+        bufferSize = sizeof(thiz.temp) - sizeof(thiz.temp) % frame;
+
+    if (thiz.core.record)
+    {
+        if (thiz.cable && position >= thiz.cable->latency + bufferSize)
+        {
+            thiz.cable->ring.Gather(position - thiz.cable->latency - bufferSize, buffer, bufferSize, true);
+        }
+        else if (thiz.sink && thiz.cable == nullptr)
+        {
+            thiz.sink(thiz.sinkContext, buffer, bufferSize);
+        }
+        else
+        {
+            memset(buffer, 0, bufferSize);
+        }
+        thiz.core.Record(buffer, bufferSize);
+        return bufferSize;
+    }
+
+    thiz.core.Play(buffer, bufferSize);
+    if (thiz.cable)
+    {
+        thiz.cable->ring.Scatter(position, buffer, bufferSize);
+    }
+    if (thiz.sink)
+    {
+        thiz.sink(thiz.sinkContext, buffer, bufferSize);
+    }
+    return bufferSize;
+}
+//------------------------------------------------------------------------------
+static uint64_t NullAudioPosition(NullAudio& thiz, uint64_t time)
+{
+    size_t frame = sizeWaveform(thiz.core.format) * thiz.core.channel;
+    uint64_t position = time * thiz.core.bytesPerSecond / 1000000;
+
+    return position - position % frame;
+}
+//------------------------------------------------------------------------------
+static void NullAudioThread(NullAudio& thiz)
+{
+    uint64_t start = thiz.clock(thiz.clockContext);
+    uint64_t origin = NullAudioPosition(thiz, start);
+    uint64_t tick = 0;
+
+    while (thiz.cancel == false)
+    {
+        uint64_t now = thiz.clock(thiz.clockContext);
+        if (thiz.core.ready == false || thiz.core.bufferSize == 0)
+        {
+            start = now;
+            origin = NullAudioPosition(thiz, start);
+            tick = 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // A period is pulled when it starts playing, as a device would.
+        uint64_t due = start + tick * 1000000 / thiz.core.bytesPerSecond;
+        if (now < due)
+        {
+            uint64_t wait = due - now;
+            std::this_thread::sleep_for(std::chrono::microseconds(wait < 1000 ? wait : 1000));
+            continue;
+        }
+
+        tick += NullAudioRender(thiz, origin + tick);
+    }
+}
+//------------------------------------------------------------------------------
+static void NullAudioStart(void* context)
+{
+    NullAudio& thiz = *(NullAudio*)context;
+    if (thiz.thread.joinable())
+        return;
+
+    if (thiz.core.record)
+    {
+        thiz.core.bufferQueue.StoreSend(0);
+        thiz.core.bufferQueue.StorePick(0);
+    }
+
+    if (thiz.stepped)
+        return;
+    thiz.thread = std::thread(NullAudioThread, std::ref(thiz));
+}
+//------------------------------------------------------------------------------
+static void NullAudioStop(NullAudio& thiz)
+{
+    if (thiz.thread.joinable() == false)
+        return;
+
+    thiz.cancel = true;
+    thiz.thread.join();
+    thiz.cancel = false;
+}
+//------------------------------------------------------------------------------
+struct NullAudio* NullAudioCreate(int channel, int sampleRate, int secondPerBuffer, bool record, int format)
+{
+    NullAudio* nullAudio = nullptr;
+
+    switch (0) case 0: default:
+    {
+        nullAudio = new (std::nothrow) NullAudio{};
+        if (nullAudio == nullptr)
+            break;
+        NullAudio& thiz = (*nullAudio);
+
+        if (thiz.core.Startup(channel, sampleRate, secondPerBuffer, record, format, NullAudioStart, nullAudio) == false)
+            break;
+
+        thiz.clock = NullAudioMonotonic;
+
+        return nullAudio;
+    }
+    NullAudioDestroy(nullAudio);
+
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+size_t NullAudioQueueReserve(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2])
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize);
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioQueueCommit(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int gap)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.QueueCommit(now, timestamp, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioQueue(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.Queue(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioQueuePlanar(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.QueuePlanar(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioQueueBatch(struct NullAudio* nullAudio, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.QueueBatch(now, adjust, packet, count, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioQueueSilence(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.QueueSilence(now, timestamp, adjust, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+size_t NullAudioDequeuePeek(struct NullAudio* nullAudio, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.DequeuePeek(span, spanSize, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+void NullAudioDequeueRelease(struct NullAudio* nullAudio, size_t bufferSize)
+{
+    if (nullAudio == nullptr)
+        return;
+    NullAudio& thiz = (*nullAudio);
+
+    thiz.core.DequeueRelease(bufferSize);
+}
+//------------------------------------------------------------------------------
+size_t NullAudioDequeue(struct NullAudio* nullAudio, void* buffer, size_t bufferSize, bool drop)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.Dequeue(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+size_t NullAudioDequeuePlanar(struct NullAudio* nullAudio, void* const* buffer, size_t bufferSize, bool drop)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.DequeuePlanar(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+bool NullAudioMixer(struct NullAudio* nullAudio, struct Mixer* mixer)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.Attach(mixer, sizeof(thiz.temp));
+}
+//------------------------------------------------------------------------------
+bool NullAudioConvert(struct NullAudio* nullAudio, int sampleRate)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.Convert(sampleRate);
+}
+//------------------------------------------------------------------------------
+bool NullAudioDrift(struct NullAudio* nullAudio, bool enable)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.EnableDrift(enable);
+}
+//------------------------------------------------------------------------------
+bool NullAudioConceal(struct NullAudio* nullAudio, bool enable)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.EnableConceal(enable);
+}
+//------------------------------------------------------------------------------
+bool NullAudioPlayout(struct NullAudio* nullAudio, bool enable)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.EnablePlayout(enable);
+}
+//------------------------------------------------------------------------------
+bool NullAudioVoice(struct NullAudio* nullAudio, bool enable, bool collapse)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.EnableVoice(enable, collapse);
+}
+//------------------------------------------------------------------------------
+bool NullAudioSpeech(struct NullAudio* nullAudio, uint64_t* collapsed)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.Speech(collapsed);
+}
+//------------------------------------------------------------------------------
+bool NullAudioMeter(struct NullAudio* nullAudio, bool enable)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.EnableMeter(enable);
+}
+//------------------------------------------------------------------------------
+bool NullAudioTelemetry(struct NullAudio* nullAudio, struct TelemetrySnapshot* snapshot)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    thiz.core.telemetry.Read(snapshot);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool NullAudioLayout(struct NullAudio* nullAudio, uint32_t channelMask, uint32_t* deviceMask)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    if (thiz.core.Layout(channelMask) == false)
+        return false;
+    if (deviceMask)
+        (*deviceMask) = thiz.core.deviceMask;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool NullAudioMatrix(struct NullAudio* nullAudio, const float* matrix)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+
+    return thiz.core.Matrix(matrix);
+}
+//------------------------------------------------------------------------------
+void NullAudioReset(struct NullAudio* nullAudio)
+{
+    if (nullAudio == nullptr)
+        return;
+    NullAudio& thiz = (*nullAudio);
+
+    thiz.core.Reset();
+}
+//------------------------------------------------------------------------------
+void NullAudioVolume(struct NullAudio* nullAudio, float volume)
+{
+    if (nullAudio == nullptr)
+        return;
+    NullAudio& thiz = (*nullAudio);
+
+    thiz.core.volume = volume;
+}
+//------------------------------------------------------------------------------
+bool NullAudioClock(struct NullAudio* nullAudio, uint64_t (*clock)(void* context), void* context)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+    if (thiz.thread.joinable())
+        return false;
+
+    thiz.clock = clock ? clock : NullAudioMonotonic;
+    thiz.clockContext = context;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool NullAudioSink(struct NullAudio* nullAudio, void (*sink)(void* context, void* buffer, size_t bufferSize), void* context)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+    if (thiz.thread.joinable())
+        return false;
+
+    thiz.sink = sink;
+    thiz.sinkContext = context;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool NullAudioPeriod(struct NullAudio* nullAudio, int periodFrames)
+{
+    if (nullAudio == nullptr)
+        return false;
+    NullAudio& thiz = (*nullAudio);
+    if (thiz.thread.joinable() || periodFrames < 0)
+        return false;
+
+    size_t frame = sizeWaveform(thiz.core.format) * thiz.core.channel;
+    if (periodFrames * frame > sizeof(thiz.temp))
+        return false;
+    thiz.periodFrames = periodFrames;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool NullAudioLoopback(struct NullAudio* player, struct NullAudio* recorder, uint64_t latency)
+{
+    if (player == nullptr || recorder == nullptr)
+        return false;
+    NullAudio& source = (*player);
+    NullAudio& target = (*recorder);
+    if (source.core.record || target.core.record == false)
+        return false;
+    if (source.core.channel != target.core.channel || source.core.sampleRate != target.core.sampleRate || source.core.format != target.core.format)
+        return false;
+    if (source.thread.joinable() || target.thread.joinable())
+        return false;
+
+    NullAudioCable* cable = new (std::nothrow) NullAudioCable;
+    if (cable == nullptr)
+        return false;
+    cable->latency = NullAudioPosition(source, latency);
+    cable->reference = 2;
+
+    // A second of headroom past the latency covers any period size.
+    if (cable->ring.Startup(source.core.bytesPerSecond + cable->latency, true) == false)
+    {
+        delete cable;
+        return false;
+    }
+
+    NullAudioCableRelease(source.cable);
+    NullAudioCableRelease(target.cable);
+    source.cable = cable;
+    target.cable = cable;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioStep(struct NullAudio* nullAudio, uint64_t microsecond)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    if (thiz.stepped == false)
+    {
+        NullAudioStop(thiz);
+        thiz.stepped = true;
+    }
+
+    thiz.stepTime += microsecond;
+    uint64_t origin = NullAudioPosition(thiz, NULLAUDIO_EPOCH);
+    uint64_t target = NullAudioPosition(thiz, thiz.stepTime);
+    while (thiz.stepTick <= target)
+    {
+        if (thiz.core.ready == false || thiz.core.bufferSize == 0)
+        {
+            thiz.stepTick = target;
+            break;
+        }
+
+        thiz.stepTick += NullAudioRender(thiz, origin + thiz.stepTick);
+    }
+
+    return NULLAUDIO_EPOCH + thiz.stepTime;
+}
+//------------------------------------------------------------------------------
+uint64_t NullAudioNow(struct NullAudio* nullAudio)
+{
+    if (nullAudio == nullptr)
+        return 0;
+    NullAudio& thiz = (*nullAudio);
+
+    if (thiz.stepped)
+        return NULLAUDIO_EPOCH + thiz.stepTime;
+
+    return thiz.clock(thiz.clockContext);
+}
+//------------------------------------------------------------------------------
+void NullAudioDestroy(struct NullAudio* nullAudio)
+{
+    if (nullAudio == nullptr)
+        return;
+    NullAudio& thiz = (*nullAudio);
+
+    NullAudioStop(thiz);
+    NullAudioCableRelease(thiz.cable);
+
+    delete &thiz;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+//==============================================================================
+// Headless Null Audio Device
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Waveform.h"
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//==============================================================================
+// Null Audio Utility
+//
+// A device without hardware that runs the same Queue / Dequeue timing as the
+// platform backends. Periods are paced by a timer thread that follows a
+// clock in microseconds, the system monotonic clock unless one is given.
+// Calling NullAudioStep turns the timer off for good and makes the clock
+// virtual: it then only moves inside Step, which renders every period that
+// falls due as fast as the CPU allows.
+//
+// A player hands each rendered period to the sink. A recorder asks the sink
+// to fill each period before it enters the ring, and records silence when
+// there is no sink. Periods reach the sink in the stream format.
+//==============================================================================
+STREAMAL_EXPORT struct NullAudio* NullAudioCreate(int channel, int sampleRate, int secondPerBuffer, bool record = false, int format = WAVEFORM_S16);
+STREAMAL_EXPORT uint64_t NullAudioQueue(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t NullAudioQueuePlanar(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t NullAudioQueueBatch(struct NullAudio* nullAudio, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap);
+STREAMAL_EXPORT uint64_t NullAudioQueueSilence(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+STREAMAL_EXPORT size_t NullAudioQueueReserve(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2]);
+STREAMAL_EXPORT uint64_t NullAudioQueueCommit(struct NullAudio* nullAudio, uint64_t now, uint64_t timestamp, int gap);
+STREAMAL_EXPORT size_t NullAudioDequeue(struct NullAudio* nullAudio, void* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t NullAudioDequeuePlanar(struct NullAudio* nullAudio, void* const* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t NullAudioDequeuePeek(struct NullAudio* nullAudio, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT void NullAudioDequeueRelease(struct NullAudio* nullAudio, size_t bufferSize);
+STREAMAL_EXPORT bool NullAudioMixer(struct NullAudio* nullAudio, struct Mixer* mixer);
+STREAMAL_EXPORT bool NullAudioDrift(struct NullAudio* nullAudio, bool enable);
+STREAMAL_EXPORT bool NullAudioConceal(struct NullAudio* nullAudio, bool enable);
+STREAMAL_EXPORT bool NullAudioPlayout(struct NullAudio* nullAudio, bool enable);
+STREAMAL_EXPORT bool NullAudioVoice(struct NullAudio* nullAudio, bool enable, bool collapse = false);
+STREAMAL_EXPORT bool NullAudioSpeech(struct NullAudio* nullAudio, uint64_t* collapsed = nullptr);
+STREAMAL_EXPORT bool NullAudioMeter(struct NullAudio* nullAudio, bool enable);
+STREAMAL_EXPORT bool NullAudioTelemetry(struct NullAudio* nullAudio, struct TelemetrySnapshot* snapshot);
+STREAMAL_EXPORT bool NullAudioLayout(struct NullAudio* nullAudio, uint32_t channelMask, uint32_t* deviceMask = nullptr);
+STREAMAL_EXPORT bool NullAudioMatrix(struct NullAudio* nullAudio, const float* matrix);
+STREAMAL_EXPORT void NullAudioReset(struct NullAudio* nullAudio);
+STREAMAL_EXPORT void NullAudioVolume(struct NullAudio* nullAudio, float volume);
+STREAMAL_EXPORT void NullAudioDestroy(struct NullAudio* nullAudio);
+
+// Set before the first Queue or Dequeue, the timer does not pick up changes.
+STREAMAL_EXPORT bool NullAudioClock(struct NullAudio* nullAudio, uint64_t (*clock)(void* context), void* context);
+STREAMAL_EXPORT bool NullAudioSink(struct NullAudio* nullAudio, void (*sink)(void* context, void* buffer, size_t bufferSize), void* context);
+
+// A device period of periodFrames, or 0 to follow the first buffer size seen
+// by Queue or Dequeue as the other backends do.
+STREAMAL_EXPORT bool NullAudioPeriod(struct NullAudio* nullAudio, int periodFrames);
+
+// Queue takes buffers at sampleRate, or a recorder's Dequeue hands them out
+// at it, through a resampler to and from the rate the device was created
+// with. 0 or the device rate turns it off. 16 bits only, and set before the
+// stream starts.
+STREAMAL_EXPORT bool NullAudioConvert(struct NullAudio* nullAudio, int sampleRate);
+
+// A virtual cable from a player to a recorder of the same format. What the
+// player renders is captured latency microseconds after it starts playing,
+// and the recorder takes it from the cable instead of its sink. Both ends
+// must follow the same clock, the same clock function or the same steps, and
+// the cable stays until both are destroyed. With virtual clocks, step the
+// player first.
+STREAMAL_EXPORT bool NullAudioLoopback(struct NullAudio* player, struct NullAudio* recorder, uint64_t latency);
+
+// Advances the virtual clock by microsecond and returns the new time. The
+// virtual clock starts at NULLAUDIO_EPOCH so that the first Queue has room
+// to look back gap buffers.
+#define NULLAUDIO_EPOCH 10000000
+STREAMAL_EXPORT uint64_t NullAudioStep(struct NullAudio* nullAudio, uint64_t microsecond);
+STREAMAL_EXPORT uint64_t NullAudioNow(struct NullAudio* nullAudio);
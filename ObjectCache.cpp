@@ -0,0 +1,175 @@
+//==============================================================================
+// ObjectCache
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include "ObjectCache.h"
+
+//==============================================================================
+// ObjectShared
+//==============================================================================
+ObjectShared::ObjectShared(CreateCallback create, DestroyCallback destroy) : object(nullptr), count(0), create(create), destroy(destroy)
+{
+}
+//------------------------------------------------------------------------------
+ObjectShared::~ObjectShared()
+{
+    if (object && destroy)
+    {
+        destroy(object);
+    }
+}
+//------------------------------------------------------------------------------
+void* ObjectShared::Acquire()
+{
+    ObjectShared& thiz = (*this);
+    std::lock_guard<std::mutex> guard(thiz.lock);
+
+    if (thiz.count == 0)
+    {
+        thiz.object = thiz.create();
+        if (thiz.object == nullptr)
+            return nullptr;
+    }
+    thiz.count++;
+
+    return thiz.object;
+}
+//------------------------------------------------------------------------------
+void ObjectShared::Release()
+{
+    ObjectShared& thiz = (*this);
+    std::lock_guard<std::mutex> guard(thiz.lock);
+
+    if (thiz.count == 0)
+        return;
+    thiz.count--;
+
+    if (thiz.count == 0)
+    {
+        thiz.destroy(thiz.object);
+        thiz.object = nullptr;
+    }
+}
+//------------------------------------------------------------------------------
+int ObjectShared::Count()
+{
+    ObjectShared& thiz = (*this);
+    std::lock_guard<std::mutex> guard(thiz.lock);
+
+    return thiz.count;
+}
+//==============================================================================
+// ObjectCache
+//==============================================================================
+ObjectCache::ObjectCache(DestroyCallback destroy) : entries(), age(0), destroy(destroy)
+{
+}
+//------------------------------------------------------------------------------
+ObjectCache::~ObjectCache()
+{
+    Flush();
+}
+//------------------------------------------------------------------------------
+uint64_t ObjectCache::Key(int channel, int sampleRate, int format, bool record)
+{
+    return (uint64_t)channel << 40 | (uint64_t)sampleRate << 8 | (uint64_t)format << 1 | (record ? 1 : 0);
+}
+//------------------------------------------------------------------------------
+void* ObjectCache::Take(uint64_t key)
+{
+    ObjectCache& thiz = (*this);
+    std::lock_guard<std::mutex> guard(thiz.lock);
+
+    // Most recently parked first, so the warmest object is reused.
+    Entry* found = nullptr;
+    for (Entry& entry : thiz.entries)
+    {
+        if (entry.object == nullptr || entry.key != key)
+            continue;
+        if (found == nullptr || found->age < entry.age)
+            found = &entry;
+    }
+    if (found == nullptr)
+        return nullptr;
+
+    void* object = found->object;
+    (*found) = {};
+
+    return object;
+}
+//------------------------------------------------------------------------------
+void ObjectCache::Give(uint64_t key, void* object)
+{
+    if (object == nullptr)
+        return;
+    ObjectCache& thiz = (*this);
+
+    void* evict = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(thiz.lock);
+
+        Entry* slot = &thiz.entries[0];
+        for (Entry& entry : thiz.entries)
+        {
+            if (entry.object == nullptr)
+            {
+                slot = &entry;
+                break;
+            }
+            if (slot->age > entry.age)
+                slot = &entry;
+        }
+        evict = slot->object;
+
+        slot->key = key;
+        slot->age = ++thiz.age;
+        slot->object = object;
+    }
+
+    if (evict)
+    {
+        thiz.destroy(evict);
+    }
+}
+//------------------------------------------------------------------------------
+void ObjectCache::Flush()
+{
+    ObjectCache& thiz = (*this);
+
+    Entry entries[CAPACITY];
+    {
+        std::lock_guard<std::mutex> guard(thiz.lock);
+
+        for (int i = 0; i < CAPACITY; ++i)
+        {
+            entries[i] = thiz.entries[i];
+            thiz.entries[i] = {};
+        }
+    }
+
+    for (Entry& entry : entries)
+    {
+        if (entry.object)
+        {
+            thiz.destroy(entry.object);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+int ObjectCache::Count()
+{
+    ObjectCache& thiz = (*this);
+    std::lock_guard<std::mutex> guard(thiz.lock);
+
+    int count = 0;
+    for (Entry& entry : thiz.entries)
+    {
+        if (entry.object)
+            count++;
+    }
+
+    return count;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,80 @@
+//==============================================================================
+// ObjectCache
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//------------------------------------------------------------------------------
+// Reference-counted process-wide object
+//
+// The first Acquire creates the object and the last Release destroys it.
+// Both callbacks run under the lock, so they must not call back into it.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT ObjectShared
+{
+    typedef void* (*CreateCallback)();
+    typedef void (*DestroyCallback)(void* object);
+
+    ObjectShared(CreateCallback create, DestroyCallback destroy);
+    ~ObjectShared();
+
+    void* Acquire();
+    void Release();
+    int Count();
+
+    std::mutex lock;
+    void* object;
+    int count;
+    CreateCallback create;
+    DestroyCallback destroy;
+};
+//------------------------------------------------------------------------------
+// Warm object cache
+//
+// Keeps up to CAPACITY idle objects keyed by an integer. Take hands back an
+// idle object with the same key, or nullptr. Give parks an object and evicts
+// the least recently parked one when full; evicted objects and everything
+// left at Flush go through destroy outside the lock.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT ObjectCache
+{
+    typedef void (*DestroyCallback)(void* object);
+
+    enum
+    {
+        CAPACITY = 4,
+    };
+
+    ObjectCache(DestroyCallback destroy);
+    ~ObjectCache();
+
+    // The key of a device object opened with these parameters.
+    static uint64_t Key(int channel, int sampleRate, int format, bool record);
+
+    void* Take(uint64_t key);
+    void Give(uint64_t key, void* object);
+    void Flush();
+    int Count();
+
+    struct Entry
+    {
+        uint64_t key;
+        uint64_t age;
+        void* object;
+    };
+
+    std::mutex lock;
+    Entry entries[CAPACITY];
+    uint64_t age;
+    DestroyCallback destroy;
+};
@@ -0,0 +1,103 @@
+//==============================================================================
+// Playout
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include "Playout.h"
+
+// Jitter gain of RFC 3550, and how many jitters of headroom the target keeps.
+// Lateness spread evenly over a range has a mean difference of a third of
+// it, so three jitters cover the range without stacking a margin on top.
+#define PLAYOUT_GAIN 0.0625
+#define PLAYOUT_K 3.0
+
+//==============================================================================
+// Playout
+//==============================================================================
+Playout::Playout() : arrivals(0), last(0), transit(0), excess(0), floor(0.0), jitter(0.0), target(0.0)
+{
+}
+//------------------------------------------------------------------------------
+void Playout::Startup()
+{
+    Playout& thiz = (*this);
+
+    thiz.Reset();
+    thiz.arrivals = 0;
+    thiz.jitter = 0.0;
+    thiz.target = 0.0;
+}
+//------------------------------------------------------------------------------
+void Playout::Reset()
+{
+    Playout& thiz = (*this);
+
+    thiz.last = 0;
+    thiz.transit = 0;
+    thiz.excess = 0;
+    thiz.floor = 0.0;
+}
+//------------------------------------------------------------------------------
+void Playout::Seed(uint64_t delay)
+{
+    Playout& thiz = (*this);
+
+    thiz.target = double(delay < uint64_t(PLAYOUT_MAX) ? delay : uint64_t(PLAYOUT_MAX));
+}
+//------------------------------------------------------------------------------
+uint64_t Playout::Update(uint64_t now, uint64_t timestamp, uint64_t duration)
+{
+    Playout& thiz = (*this);
+
+    int64_t transit = int64_t(now - timestamp);
+    if (thiz.last == 0)
+    {
+        thiz.last = now;
+        thiz.transit = transit;
+        thiz.floor = double(transit);
+    }
+
+    if (now > thiz.last)
+    {
+        thiz.floor += double(now - thiz.last) * PLAYOUT_CREEP / 1000000.0;
+        thiz.last = now;
+    }
+
+    // A packet later than the target could ever cover starts a new timeline
+    // rather than pushing the target to its limit.
+    if (thiz.floor > double(transit) || double(transit) - thiz.floor > PLAYOUT_MAX)
+    {
+        thiz.floor = double(transit);
+    }
+
+    double difference = fabs(double(transit - thiz.transit));
+    thiz.jitter += (difference - thiz.jitter) * PLAYOUT_GAIN;
+    thiz.transit = transit;
+    thiz.excess = uint64_t(double(transit) - thiz.floor);
+    thiz.arrivals++;
+
+    double need = double(thiz.excess);
+    if (need < thiz.jitter * PLAYOUT_K)
+        need = thiz.jitter * PLAYOUT_K;
+    need += double(duration);
+    if (need > PLAYOUT_MAX)
+        need = PLAYOUT_MAX;
+
+    if (need > thiz.target)
+        thiz.target = need;
+    else
+        thiz.target += (need - thiz.target) * (1.0 - exp(-double(duration) / PLAYOUT_RELEASE));
+
+    return uint64_t(thiz.target);
+}
+//------------------------------------------------------------------------------
+uint64_t Playout::Delay() const
+{
+    const Playout& thiz = (*this);
+
+    uint64_t target = uint64_t(thiz.target);
+    return target > thiz.excess ? target - thiz.excess : 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,63 @@
+//==============================================================================
+// Playout
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//------------------------------------------------------------------------------
+// Adaptive playout delay estimator
+//
+// Takes the (now, timestamp) pair of every packet. The transit time now -
+// timestamp of the fastest packets is the floor, which creeps up by
+// PLAYOUT_CREEP per second so that a sender on a slower clock does not look
+// later and later. Excess is how far a packet's transit lies above the floor,
+// and jitter is the smoothed difference of consecutive transits.
+//
+// The target is the playout delay an on-time packet should find ahead of it:
+// one packet plus the larger of the excess and a multiple of the jitter. It
+// rises at once when a packet needs more and falls towards the need with a
+// time constant of PLAYOUT_RELEASE of media, so a pause does not shrink it.
+// Times are in microseconds.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT Playout
+{
+    Playout();
+
+    enum
+    {
+        PLAYOUT_MAX = 400000,
+        PLAYOUT_SLACK = 2000,
+        PLAYOUT_CREEP = 200,
+        PLAYOUT_RELEASE = 8000000,
+    };
+
+    void Startup();
+
+    // Forget the floor for a new timeline, keep what the target learned.
+    void Reset();
+
+    // Start the target at the delay a stream was made ready with.
+    void Seed(uint64_t delay);
+    uint64_t Update(uint64_t now, uint64_t timestamp, uint64_t duration);
+
+    // The delay the last packet should have found ahead of it, the target
+    // less its excess.
+    uint64_t Delay() const;
+
+    uint64_t arrivals;
+    uint64_t last;
+    int64_t transit;
+    uint64_t excess;
+    double floor;
+    double jitter;
+    double target;
+};
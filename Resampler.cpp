@@ -0,0 +1,408 @@
+//==============================================================================
+// Resampler
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include <limits.h>
+#include <string.h>
+#include <new>
+#include "Waveform.h"
+#include "Resampler.h"
+
+#define RESAMPLER_BLOCK 256
+#define RESAMPLER_TAPS_MAX 1024
+#define RESAMPLER_PPM 1000000
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//==============================================================================
+// Resampler Utility
+//
+// Output frame n sits at input position base + taps / 2 - 1 + frac / D,
+// where D is L * RESAMPLER_PPM, L is the output rate and M the input rate,
+// both divided by their greatest common divisor. Each output frame advances
+// the position by M * (RESAMPLER_PPM + ppm) / D.
+//==============================================================================
+struct Resampler
+{
+    const WaveformKernel* kernel;
+
+    int channel;
+    int taps;
+    int phases;
+    bool exact;
+
+    uint64_t L;
+    uint64_t M;
+    uint64_t denominator;
+    uint64_t stepWhole;
+    uint64_t stepFrac;
+    int ppm;
+
+    size_t base;
+    uint64_t frac;
+
+    int16_t* filter;
+    int16_t* history;
+    size_t historySize;
+    size_t historyCapacity;
+
+    int16_t* convert;
+    size_t convertFrames;
+};
+//------------------------------------------------------------------------------
+static uint64_t ResamplerDivisor(uint64_t a, uint64_t b)
+{
+    while (b)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+//------------------------------------------------------------------------------
+static void ResamplerDesign(Resampler& thiz, double cutoff)
+{
+    int taps = thiz.taps;
+    double half = taps / 2;
+
+    for (int p = 0; p <= thiz.phases; ++p)
+    {
+        double f = double(p) / thiz.phases;
+        double row[RESAMPLER_TAPS_MAX];
+        double sum = 0.0;
+        for (int j = 0; j < taps; ++j)
+        {
+            double d = f + half - 1 - j;
+            double x = M_PI * cutoff * d;
+            double sinc = (x == 0.0) ? 1.0 : sin(x) / x;
+            double w = fabs(d) >= half ? 0.0 : 0.42 + 0.5 * cos(M_PI * d / half) + 0.08 * cos(2.0 * M_PI * d / half);
+            row[j] = sinc * w;
+            sum += row[j];
+        }
+
+        // Unity gain at DC for every phase.
+        int16_t* coef = thiz.filter + p * taps;
+        for (int j = 0; j < taps; ++j)
+        {
+            coef[j] = int16_t(lrint(row[j] / sum * 32768.0));
+        }
+    }
+}
+//------------------------------------------------------------------------------
+struct Resampler* ResamplerCreate(int channel, int inputRate, int outputRate, int quality)
+{
+    Resampler* resampler = nullptr;
+
+    switch (0) case 0: default:
+    {
+        if (channel <= 0)
+            break;
+        if (inputRate <= 0 || outputRate <= 0)
+            break;
+
+        resampler = new (std::nothrow) Resampler{};
+        if (resampler == nullptr)
+            break;
+        Resampler& thiz = (*resampler);
+
+        thiz.kernel = waveformKernel();
+        thiz.channel = channel;
+
+        uint64_t divisor = ResamplerDivisor(inputRate, outputRate);
+        thiz.L = outputRate / divisor;
+        thiz.M = inputRate / divisor;
+        thiz.denominator = thiz.L * RESAMPLER_PPM;
+        ResamplerDrift(resampler, 0);
+
+        int taps = 32;
+        int phases = 256;
+        double rolloff = 0.90;
+        switch (quality)
+        {
+        case RESAMPLER_LOW:
+            taps = 16;
+            phases = 64;
+            rolloff = 0.80;
+            break;
+        case RESAMPLER_HIGH:
+            taps = 64;
+            phases = 512;
+            rolloff = 0.95;
+            break;
+        default:
+            break;
+        }
+
+        // Downsampling lowers the cutoff, so the kernel widens to keep the
+        // same transition band in output samples.
+        double ratio = double(thiz.L) / double(thiz.M);
+        if (ratio < 1.0)
+        {
+            taps = int(ceil(taps / ratio));
+        }
+        taps = (taps + 7) & ~7;
+        if (taps > RESAMPLER_TAPS_MAX)
+            taps = RESAMPLER_TAPS_MAX;
+
+        thiz.taps = taps;
+        // Exact ratios keep a multiple of L phases, so the drift trim still
+        // has enough phases to interpolate between.
+        thiz.exact = (thiz.L <= RESAMPLER_PHASE_EXACT);
+        thiz.phases = thiz.exact ? int(thiz.L * ((phases + thiz.L - 1) / thiz.L)) : phases;
+
+        thiz.filter = new (std::nothrow) int16_t[(thiz.phases + 1) * taps];
+        if (thiz.filter == nullptr)
+            break;
+        ResamplerDesign(thiz, rolloff * (ratio < 1.0 ? ratio : 1.0));
+
+        thiz.historyCapacity = taps + RESAMPLER_BLOCK;
+        thiz.history = new (std::nothrow) int16_t[thiz.historyCapacity * channel];
+        if (thiz.history == nullptr)
+            break;
+        ResamplerReset(resampler);
+
+        return resampler;
+    }
+    ResamplerDestroy(resampler);
+
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+// Exactly one of input and planes is given. The history is kept planar, so
+// planes are copied in as they are and input is split on the way.
+static size_t ResamplerRun(Resampler& thiz, const int16_t* input, const int16_t* const* planes, size_t inputFrames, int16_t* output, size_t outputFrames, size_t* inputUsed)
+{
+    int channel = thiz.channel;
+    int taps = thiz.taps;
+    int32_t (*dot)(const int16_t*, const int16_t*, size_t) = thiz.kernel->dot;
+
+    size_t produced = 0;
+    size_t used = 0;
+    for (;;)
+    {
+        while (produced < outputFrames && thiz.base + taps <= thiz.historySize)
+        {
+            uint64_t scaled = thiz.frac * thiz.phases;
+            uint64_t phase = scaled / thiz.denominator;
+            int64_t weight = int64_t((scaled % thiz.denominator) * 32768 / thiz.denominator);
+            const int16_t* coef = thiz.filter + phase * taps;
+
+            int16_t* frame = output + produced * channel;
+            for (int c = 0; c < channel; ++c)
+            {
+                const int16_t* history = thiz.history + c * thiz.historyCapacity + thiz.base;
+                int64_t sum = dot(history, coef, taps);
+                if (weight)
+                {
+                    int64_t next = dot(history, coef + taps, taps);
+                    sum += ((next - sum) * weight) >> 15;
+                }
+                sum = (sum + 0x4000) >> 15;
+                frame[c] = int16_t(sum < SHRT_MIN ? SHRT_MIN : sum > SHRT_MAX ? SHRT_MAX : sum);
+            }
+            produced++;
+
+            thiz.base += thiz.stepWhole;
+            thiz.frac += thiz.stepFrac;
+            if (thiz.frac >= thiz.denominator)
+            {
+                thiz.frac -= thiz.denominator;
+                thiz.base++;
+            }
+        }
+        if (produced == outputFrames || used == inputFrames)
+            break;
+
+        // Drop the frames behind the window, skipping input the window has
+        // already stepped over when downsampling.
+        size_t drop = thiz.base < thiz.historySize ? thiz.base : thiz.historySize;
+        size_t keep = thiz.historySize - drop;
+        for (int c = 0; c < channel; ++c)
+        {
+            int16_t* history = thiz.history + c * thiz.historyCapacity;
+            memmove(history, history + drop, keep * sizeof(int16_t));
+        }
+        thiz.historySize = keep;
+        thiz.base -= drop;
+        if (thiz.base)
+        {
+            size_t skip = inputFrames - used;
+            if (skip > thiz.base)
+                skip = thiz.base;
+            used += skip;
+            thiz.base -= skip;
+            if (thiz.base)
+                break;
+        }
+
+        size_t count = thiz.historyCapacity - thiz.historySize;
+        if (count > inputFrames - used)
+            count = inputFrames - used;
+        for (int c = 0; c < channel; ++c)
+        {
+            int16_t* history = thiz.history + c * thiz.historyCapacity + thiz.historySize;
+            if (planes)
+            {
+                memcpy(history, planes[c] + used, count * sizeof(int16_t));
+                continue;
+            }
+            const int16_t* frame = input + used * channel;
+            for (size_t i = 0; i < count; ++i)
+            {
+                history[i] = frame[i * channel + c];
+            }
+        }
+        thiz.historySize += count;
+        used += count;
+    }
+
+    if (inputUsed)
+        (*inputUsed) = used;
+    return produced;
+}
+//------------------------------------------------------------------------------
+size_t ResamplerProcess(struct Resampler* resampler, const int16_t* input, size_t inputFrames, int16_t* output, size_t outputFrames, size_t* inputUsed)
+{
+    if (inputUsed)
+        (*inputUsed) = 0;
+    if (resampler == nullptr)
+        return 0;
+    Resampler& thiz = (*resampler);
+
+    return ResamplerRun(thiz, input, nullptr, inputFrames, output, outputFrames, inputUsed);
+}
+//------------------------------------------------------------------------------
+size_t ResamplerProcessPlanar(struct Resampler* resampler, const int16_t* const* input, size_t inputFrames, int16_t* output, size_t outputFrames, size_t* inputUsed)
+{
+    if (inputUsed)
+        (*inputUsed) = 0;
+    if (resampler == nullptr)
+        return 0;
+    Resampler& thiz = (*resampler);
+
+    return ResamplerRun(thiz, nullptr, input, inputFrames, output, outputFrames, inputUsed);
+}
+//------------------------------------------------------------------------------
+size_t ResamplerOutputFrames(struct Resampler* resampler, size_t inputFrames)
+{
+    if (resampler == nullptr)
+        return 0;
+    Resampler& thiz = (*resampler);
+
+    uint64_t step = thiz.stepWhole * thiz.denominator + thiz.stepFrac;
+    return size_t((inputFrames + thiz.taps) * thiz.denominator / step + 1);
+}
+//------------------------------------------------------------------------------
+static bool ResamplerStorage(Resampler& thiz, size_t frames)
+{
+    if (thiz.convertFrames < frames)
+    {
+        int16_t* convert = new (std::nothrow) int16_t[frames * thiz.channel];
+        if (convert == nullptr)
+            return false;
+        delete[] thiz.convert;
+        thiz.convert = convert;
+        thiz.convertFrames = frames;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+const int16_t* ResamplerConvert(struct Resampler* resampler, const int16_t* input, size_t inputFrames, size_t* outputFrames)
+{
+    if (outputFrames)
+        (*outputFrames) = 0;
+    if (resampler == nullptr)
+        return nullptr;
+    Resampler& thiz = (*resampler);
+
+    size_t frames = ResamplerOutputFrames(resampler, inputFrames);
+    if (ResamplerStorage(thiz, frames) == false)
+        return nullptr;
+
+    size_t used = 0;
+    size_t produced = ResamplerRun(thiz, input, nullptr, inputFrames, thiz.convert, frames, &used);
+    if (outputFrames)
+        (*outputFrames) = produced;
+
+    return thiz.convert;
+}
+//------------------------------------------------------------------------------
+const int16_t* ResamplerConvertPlanar(struct Resampler* resampler, const int16_t* const* input, size_t inputFrames, size_t* outputFrames)
+{
+    if (outputFrames)
+        (*outputFrames) = 0;
+    if (resampler == nullptr)
+        return nullptr;
+    Resampler& thiz = (*resampler);
+
+    size_t frames = ResamplerOutputFrames(resampler, inputFrames);
+    if (ResamplerStorage(thiz, frames) == false)
+        return nullptr;
+
+    size_t used = 0;
+    size_t produced = ResamplerRun(thiz, nullptr, input, inputFrames, thiz.convert, frames, &used);
+    if (outputFrames)
+        (*outputFrames) = produced;
+
+    return thiz.convert;
+}
+//------------------------------------------------------------------------------
+void ResamplerDrift(struct Resampler* resampler, int ppm)
+{
+    if (resampler == nullptr)
+        return;
+    Resampler& thiz = (*resampler);
+
+    if (ppm < -RESAMPLER_DRIFT_MAX)
+        ppm = -RESAMPLER_DRIFT_MAX;
+    if (ppm > RESAMPLER_DRIFT_MAX)
+        ppm = RESAMPLER_DRIFT_MAX;
+
+    uint64_t step = thiz.M * (RESAMPLER_PPM + ppm);
+    thiz.stepWhole = step / thiz.denominator;
+    thiz.stepFrac = step % thiz.denominator;
+    thiz.ppm = ppm;
+}
+//------------------------------------------------------------------------------
+size_t ResamplerLatency(struct Resampler* resampler)
+{
+    if (resampler == nullptr)
+        return 0;
+    Resampler& thiz = (*resampler);
+
+    return thiz.taps / 2;
+}
+//------------------------------------------------------------------------------
+void ResamplerReset(struct Resampler* resampler)
+{
+    if (resampler == nullptr)
+        return;
+    Resampler& thiz = (*resampler);
+
+    // Leading silence fills the window, so the first input frame produces
+    // output at once and N frames in give N frames out at unity ratio.
+    memset(thiz.history, 0, thiz.historyCapacity * thiz.channel * sizeof(int16_t));
+    thiz.historySize = thiz.taps - 1;
+    thiz.base = 0;
+    thiz.frac = 0;
+}
+//------------------------------------------------------------------------------
+void ResamplerDestroy(struct Resampler* resampler)
+{
+    if (resampler == nullptr)
+        return;
+    Resampler& thiz = (*resampler);
+
+    delete[] thiz.filter;
+    delete[] thiz.history;
+    delete[] thiz.convert;
+    delete resampler;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,58 @@
+//==============================================================================
+// Resampler
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//==============================================================================
+// Resampler Utility
+//
+// Streaming polyphase FIR converter for interleaved 16-bit frames. Ratios
+// that reduce to at most RESAMPLER_PHASE_EXACT phases use one exact filter
+// per phase, other ratios and any drift trim interpolate between
+// neighbouring phases. The filter delays the signal by ResamplerLatency
+// input frames, and the window starts filled with silence.
+//==============================================================================
+enum ResamplerQuality
+{
+    RESAMPLER_LOW,      // 16 taps
+    RESAMPLER_MEDIUM,   // 32 taps
+    RESAMPLER_HIGH,     // 64 taps
+};
+
+#define RESAMPLER_PHASE_EXACT 1024
+#define RESAMPLER_DRIFT_MAX 5000
+
+STREAMAL_EXPORT struct Resampler* ResamplerCreate(int channel, int inputRate, int outputRate, int quality = RESAMPLER_MEDIUM);
+
+// Consumes up to inputFrames and produces up to outputFrames, returning the
+// number of frames produced. inputUsed reports how many frames were taken;
+// frames that are not taken must be offered again on the next call.
+STREAMAL_EXPORT size_t ResamplerProcess(struct Resampler* resampler, const int16_t* input, size_t inputFrames, int16_t* output, size_t outputFrames, size_t* inputUsed);
+
+// Converts all of input into storage owned by the resampler, valid until the
+// next call.
+STREAMAL_EXPORT const int16_t* ResamplerConvert(struct Resampler* resampler, const int16_t* input, size_t inputFrames, size_t* outputFrames);
+
+// The same with one plane per channel. Output stays interleaved.
+STREAMAL_EXPORT size_t ResamplerProcessPlanar(struct Resampler* resampler, const int16_t* const* input, size_t inputFrames, int16_t* output, size_t outputFrames, size_t* inputUsed);
+STREAMAL_EXPORT const int16_t* ResamplerConvertPlanar(struct Resampler* resampler, const int16_t* const* input, size_t inputFrames, size_t* outputFrames);
+
+// Upper bound of frames produced from inputFrames.
+STREAMAL_EXPORT size_t ResamplerOutputFrames(struct Resampler* resampler, size_t inputFrames);
+
+// Trim the ratio by ppm parts per million, clamped to RESAMPLER_DRIFT_MAX.
+// A positive trim consumes input faster and produces fewer frames.
+STREAMAL_EXPORT void ResamplerDrift(struct Resampler* resampler, int ppm);
+STREAMAL_EXPORT size_t ResamplerLatency(struct Resampler* resampler);
+STREAMAL_EXPORT void ResamplerReset(struct Resampler* resampler);
+STREAMAL_EXPORT void ResamplerDestroy(struct Resampler* resampler);
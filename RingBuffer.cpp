@@ -6,10 +6,381 @@
 //==============================================================================
 #include <stdlib.h>
 #include <string.h>
+#include <new>
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#elif defined(__APPLE__)
+#   include <mach/mach.h>
+#elif defined(__linux__)
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
 #include "RingBuffer.h"
+#include "Waveform.h"
 
+//==============================================================================
+// Mirrored mapping
+//==============================================================================
+static size_t MirrorGranularity()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#elif defined(__APPLE__)
+    return vm_page_size;
+#elif defined(__linux__)
+    return sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+//------------------------------------------------------------------------------
+static char* MirrorAllocate(size_t size)
+{
+#if defined(_WIN32)
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+    if (mapping == nullptr)
+        return nullptr;
+
+    char* buffer = nullptr;
+    for (int retry = 0; retry < 16 && buffer == nullptr; ++retry)
+    {
+        char* base = (char*)VirtualAlloc(nullptr, size * 2, MEM_RESERVE, PAGE_NOACCESS);
+        if (base == nullptr)
+            break;
+        VirtualFree(base, 0, MEM_RELEASE);
+
+        char* first = (char*)MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base);
+        char* second = (char*)MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base + size);
+        if (first == base && second == base + size)
+        {
+            buffer = base;
+            break;
+        }
+        if (first)
+            UnmapViewOfFile(first);
+        if (second)
+            UnmapViewOfFile(second);
+    }
+    CloseHandle(mapping);
+
+    return buffer;
+#elif defined(__APPLE__)
+    vm_address_t base = 0;
+    if (vm_allocate(mach_task_self(), &base, size * 2, VM_FLAGS_ANYWHERE) != KERN_SUCCESS)
+        return nullptr;
+    if (vm_deallocate(mach_task_self(), base + size, size) != KERN_SUCCESS)
+    {
+        vm_deallocate(mach_task_self(), base, size);
+        return nullptr;
+    }
+
+    vm_address_t second = base + size;
+    vm_prot_t current = VM_PROT_NONE;
+    vm_prot_t maximum = VM_PROT_NONE;
+    if (vm_remap(mach_task_self(), &second, size, 0, VM_FLAGS_FIXED, mach_task_self(), base, FALSE, &current, &maximum, VM_INHERIT_COPY) != KERN_SUCCESS || second != base + size)
+    {
+        vm_deallocate(mach_task_self(), base, size);
+        return nullptr;
+    }
+
+    return (char*)base;
+#elif defined(__linux__) && (defined(SYS_memfd_create) || defined(__NR_memfd_create))
+#   if !defined(SYS_memfd_create)
+#       define SYS_memfd_create __NR_memfd_create
+#   endif
+    int fd = (int)syscall(SYS_memfd_create, "RingBuffer", 0);
+    if (fd < 0)
+        return nullptr;
+
+    char* buffer = nullptr;
+    if (ftruncate(fd, size) == 0)
+    {
+        char* base = (char*)mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED)
+        {
+            void* first = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            void* second = mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            if (first == base && second == base + size)
+            {
+                buffer = base;
+            }
+            else
+            {
+                munmap(base, size * 2);
+            }
+        }
+    }
+    close(fd);
+
+    return buffer;
+#else
+    return nullptr;
+#endif
+}
+//------------------------------------------------------------------------------
+static void MirrorFree(char* buffer, size_t size)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(buffer);
+    UnmapViewOfFile(buffer + size);
+#elif defined(__APPLE__)
+    vm_deallocate(mach_task_self(), (vm_address_t)buffer, size * 2);
+#elif defined(__linux__)
+    munmap(buffer, size * 2);
+#endif
+}
+//==============================================================================
+// RingBuffer
+//==============================================================================
+// Laps use the low 31 bits of a stamp, the top bit marks a silent block.
+static const uint32_t RING_LAP_MASK = 0x7FFFFFFF;
+static const uint32_t RING_SILENT = 0x80000000;
+//------------------------------------------------------------------------------
+static inline uint64_t RingOffset(const RingBuffer& thiz, uint64_t index)
+{
+    if (thiz.bufferMask)
+        return index & thiz.bufferMask;
+    return index % thiz.bufferSize;
+}
+//------------------------------------------------------------------------------
+static inline uint32_t RingLap(const RingBuffer& thiz, uint64_t index)
+{
+    if (thiz.bufferMask)
+        return (uint32_t(index >> thiz.bufferShift) + 1) & RING_LAP_MASK;
+    return (uint32_t(index / thiz.bufferSize) + 1) & RING_LAP_MASK;
+}
+//------------------------------------------------------------------------------
+static inline std::atomic<uint32_t>& RingStamp(const RingBuffer& thiz, uint64_t index)
+{
+    return thiz.bufferStamp[RingOffset(thiz, index) >> RingBuffer::BLOCK_SHIFT];
+}
+//------------------------------------------------------------------------------
+static inline bool RingWritten(const RingBuffer& thiz, uint64_t index)
+{
+    return RingStamp(thiz, index).load(std::memory_order_acquire) == RingLap(thiz, index);
+}
+//------------------------------------------------------------------------------
+static inline int RingState(const RingBuffer& thiz, uint64_t index)
+{
+    uint32_t stamp = RingStamp(thiz, index).load(std::memory_order_acquire);
+    uint32_t lap = RingLap(thiz, index);
+    if (stamp == lap)
+        return RingBuffer::BLOCK_PRESENT;
+    if (stamp == (lap | RING_SILENT))
+        return RingBuffer::BLOCK_SILENT;
+    return RingBuffer::BLOCK_MISSING;
+}
+//------------------------------------------------------------------------------
+static void RingRead(const RingBuffer& thiz, uint64_t index, void* data, size_t dataSize)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        memcpy(data, thiz.buffer + offset, size);
+
+        data = (char*)data + size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    memcpy(data, thiz.buffer + offset, size);
+}
+//------------------------------------------------------------------------------
+static void RingWrite(const RingBuffer& thiz, uint64_t index, const void* data, size_t dataSize)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        memcpy(thiz.buffer + offset, data, size);
+
+        data = (char*)data + size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    memcpy(thiz.buffer + offset, data, size);
+}
+//------------------------------------------------------------------------------
+static void RingReadScaled(const RingBuffer& thiz, uint64_t index, void* data, size_t dataSize, float scale)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        scaleWaveform((int16_t*)data, (int16_t*)(thiz.buffer + offset), size, scale);
+
+        data = (char*)data + size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    scaleWaveform((int16_t*)data, (int16_t*)(thiz.buffer + offset), size, scale);
+}
+//------------------------------------------------------------------------------
+static void RingWriteScaled(const RingBuffer& thiz, uint64_t index, const void* data, size_t dataSize, float scale)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        scaleWaveform((int16_t*)(thiz.buffer + offset), (int16_t*)data, size, scale);
+
+        data = (char*)data + size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    scaleWaveform((int16_t*)(thiz.buffer + offset), (int16_t*)data, size, scale);
+}
+//------------------------------------------------------------------------------
+static void RingWriteActivity(const RingBuffer& thiz, uint64_t index, const void* data, size_t dataSize, float scale, size_t channels, WaveformActivity* activity)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        scaleWaveform((int16_t*)(thiz.buffer + offset), (int16_t*)data, size, scale, channels, activity);
+
+        data = (char*)data + size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    scaleWaveform((int16_t*)(thiz.buffer + offset), (int16_t*)data, size, scale, channels, activity);
+}
+//------------------------------------------------------------------------------
+// A run may start inside a frame. Its meter is then taken with the run's
+// first sample as channel 0 and turned to the channels of the ring.
+static void RingScaleMeter(int16_t* output, const int16_t* input, size_t size, float scale, uint64_t index, size_t channels, WaveformMeter* meter)
+{
+    size_t phase = size_t(index / sizeof(int16_t) % channels);
+    if (phase == 0)
+    {
+        scaleWaveform(output, input, size, scale, channels, meter);
+        return;
+    }
+
+    WaveformMeter part = {};
+    scaleWaveform(output, input, size, scale, channels, &part);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        size_t channel = (c + phase) % channels;
+        if (meter->peak[channel] < part.peak[c])
+            meter->peak[channel] = part.peak[c];
+        meter->energy[channel] += part.energy[c];
+    }
+    meter->samples += part.samples;
+}
 //------------------------------------------------------------------------------
-RingBuffer::RingBuffer() : buffer(nullptr), bufferSize(0)
+static void RingReadMeter(const RingBuffer& thiz, uint64_t index, void* data, size_t dataSize, float scale, size_t channels, WaveformMeter* meter)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        RingScaleMeter((int16_t*)data, (int16_t*)(thiz.buffer + offset), size, scale, index, channels, meter);
+
+        data = (char*)data + size;
+        index += size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    RingScaleMeter((int16_t*)data, (int16_t*)(thiz.buffer + offset), size, scale, index, channels, meter);
+}
+//------------------------------------------------------------------------------
+static void RingWriteMeter(const RingBuffer& thiz, uint64_t index, const void* data, size_t dataSize, float scale, size_t channels, WaveformMeter* meter)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        RingScaleMeter((int16_t*)(thiz.buffer + offset), (int16_t*)data, size, scale, index, channels, meter);
+
+        data = (char*)data + size;
+        index += size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    RingScaleMeter((int16_t*)(thiz.buffer + offset), (int16_t*)data, size, scale, index, channels, meter);
+}
+//------------------------------------------------------------------------------
+static void RingReadMixed(const RingBuffer& thiz, uint64_t index, void* data, size_t dataSize, float scale)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    uint64_t size = dataSize;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        size = thiz.bufferSize - offset;
+        mixWaveform((int16_t*)data, (int16_t*)(thiz.buffer + offset), size, scale);
+
+        data = (char*)data + size;
+        offset = 0;
+        size = dataSize - size;
+    }
+    mixWaveform((int16_t*)data, (int16_t*)(thiz.buffer + offset), size, scale);
+}
+//------------------------------------------------------------------------------
+static void RingReadConverted(const RingBuffer& thiz, uint64_t index, int format, void* data, int dataFormat, size_t samples, float scale)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    size_t count = samples;
+    if (thiz.bufferMirror == false && count * sizeWaveform(format) > thiz.bufferSize - offset)
+    {
+        count = size_t(thiz.bufferSize - offset) / sizeWaveform(format);
+        convertWaveform(data, dataFormat, thiz.buffer + offset, format, count, scale);
+
+        data = (char*)data + count * sizeWaveform(dataFormat);
+        offset = 0;
+        count = samples - count;
+    }
+    convertWaveform(data, dataFormat, thiz.buffer + offset, format, count, scale);
+}
+//------------------------------------------------------------------------------
+static void RingWriteConverted(const RingBuffer& thiz, uint64_t index, int format, const void* data, int dataFormat, size_t samples, float scale)
+{
+    uint64_t offset = RingOffset(thiz, index);
+    size_t count = samples;
+    if (thiz.bufferMirror == false && count * sizeWaveform(format) > thiz.bufferSize - offset)
+    {
+        count = size_t(thiz.bufferSize - offset) / sizeWaveform(format);
+        convertWaveform(thiz.buffer + offset, format, data, dataFormat, count, scale);
+
+        data = (char*)data + count * sizeWaveform(dataFormat);
+        offset = 0;
+        count = samples - count;
+    }
+    convertWaveform(thiz.buffer + offset, format, data, dataFormat, count, scale);
+}
+//------------------------------------------------------------------------------
+// Walk [index, index + size) as runs of blocks that were / were not written in
+// the lap of their position. Each run is reported as (index, size, written).
+//------------------------------------------------------------------------------
+template<class F>
+static void RingRuns(const RingBuffer& thiz, uint64_t index, size_t size, F run)
+{
+    uint64_t end = index + size;
+    while (index < end)
+    {
+        bool written = RingWritten(thiz, index);
+        uint64_t next = (index | RingBuffer::BLOCK_MASK) + 1;
+        while (next < end && RingWritten(thiz, next) == written)
+            next += RingBuffer::BLOCK_SIZE;
+        if (next > end)
+            next = end;
+        run(index, size_t(next - index), written);
+        index = next;
+    }
+}
+//------------------------------------------------------------------------------
+RingBuffer::RingBuffer() : buffer(nullptr), bufferSize(0), bufferMask(0), bufferShift(0), bufferMirror(false), bufferStamp(nullptr)
 {
 }
 //------------------------------------------------------------------------------
@@ -18,17 +389,45 @@ RingBuffer::~RingBuffer()
     Shutdown();
 }
 //------------------------------------------------------------------------------
-bool RingBuffer::Startup(size_t size)
+bool RingBuffer::Startup(size_t size, bool mirror)
 {
     RingBuffer& thiz = (*this);
 
-    thiz.bufferSize = 0;
-    thiz.buffer = (char*)realloc(thiz.buffer, size);
+    thiz.Shutdown();
+
+    size = (size + BLOCK_MASK) & ~size_t(BLOCK_MASK);
+    if (mirror)
+    {
+        size_t capacity = MirrorGranularity();
+        while (capacity < size)
+            capacity <<= 1;
+        size = capacity;
+
+        thiz.buffer = MirrorAllocate(size);
+        thiz.bufferMirror = (thiz.buffer != nullptr);
+    }
     if (thiz.buffer == nullptr)
+    {
+        thiz.buffer = (char*)calloc(size, 1);
+        if (thiz.buffer == nullptr)
+            return false;
+    }
+
+    thiz.bufferStamp = new (std::nothrow) std::atomic<uint32_t>[size >> BLOCK_SHIFT]();
+    if (thiz.bufferStamp == nullptr)
+    {
+        thiz.Shutdown();
         return false;
+    }
+
     thiz.bufferSize = size;
+    if ((size & (size - 1)) == 0)
+    {
+        thiz.bufferMask = size - 1;
+        while ((size_t(1) << thiz.bufferShift) < size)
+            thiz.bufferShift++;
+    }
 
-    memset(thiz.buffer, 0, size);
     return true;
 }
 //------------------------------------------------------------------------------
@@ -36,63 +435,353 @@ void RingBuffer::Shutdown()
 {
     RingBuffer& thiz = (*this);
 
-    free(thiz.buffer);
+    if (thiz.bufferMirror)
+    {
+        MirrorFree(thiz.buffer, thiz.bufferSize);
+    }
+    else
+    {
+        free(thiz.buffer);
+    }
+    delete[] thiz.bufferStamp;
     thiz.buffer = nullptr;
     thiz.bufferSize = 0;
+    thiz.bufferMask = 0;
+    thiz.bufferShift = 0;
+    thiz.bufferMirror = false;
+    thiz.bufferStamp = nullptr;
 }
 //------------------------------------------------------------------------------
 uint64_t RingBuffer::Gather(uint64_t index, void* data, size_t dataSize, bool clear)
 {
     RingBuffer& thiz = (*this);
 
-    if (thiz.bufferSize == 0)
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
         return 0;
-    uint64_t offset = index % thiz.bufferSize;
-    uint64_t size = dataSize;
-    if (size > thiz.bufferSize - offset)
+    if (clear == false)
     {
-        size = thiz.bufferSize - offset;
-        memcpy(data, thiz.buffer + offset, size);
-        if (clear)
+        RingRead(thiz, index, data, dataSize);
+        return dataSize;
+    }
+
+    char* output = (char*)data;
+    uint64_t begin = index;
+    RingRuns(thiz, index, dataSize, [&](uint64_t index, size_t size, bool written)
+    {
+        if (written)
         {
-            memset(thiz.buffer + offset, 0, size);
+            RingRead(thiz, index, output + (index - begin), size);
         }
-        index += size;
+        else
+        {
+            memset(output + (index - begin), 0, size);
+        }
+    });
 
-        data = (char*)data + size;
-        offset = index % thiz.bufferSize;
-        size = dataSize - size;
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::Scatter(uint64_t index, const void* data, size_t dataSize)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+    RingWrite(thiz, index, data, dataSize);
+    thiz.Mark(index, dataSize);
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::GatherScaled(uint64_t index, void* data, size_t dataSize, float scale)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+
+    char* output = (char*)data;
+    uint64_t begin = index;
+    RingRuns(thiz, index, dataSize, [&](uint64_t index, size_t size, bool written)
+    {
+        if (written)
+        {
+            RingReadScaled(thiz, index, output + (index - begin), size, scale);
+        }
+        else
+        {
+            memset(output + (index - begin), 0, size);
+        }
+    });
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::ScatterScaled(uint64_t index, const void* data, size_t dataSize, float scale)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+    RingWriteScaled(thiz, index, data, dataSize, scale);
+    thiz.Mark(index, dataSize);
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::ScatterActivity(uint64_t index, const void* data, size_t dataSize, float scale, size_t channels, WaveformActivity* activity)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+    RingWriteActivity(thiz, index, data, dataSize, scale, channels, activity);
+    thiz.Mark(index, dataSize);
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::GatherMeter(uint64_t index, void* data, size_t dataSize, float scale, size_t channels, WaveformMeter* meter)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+
+    char* output = (char*)data;
+    uint64_t begin = index;
+    RingRuns(thiz, index, dataSize, [&](uint64_t index, size_t size, bool written)
+    {
+        if (written)
+        {
+            RingReadMeter(thiz, index, output + (index - begin), size, scale, channels, meter);
+        }
+        else
+        {
+            memset(output + (index - begin), 0, size);
+            meter->samples += size / sizeof(int16_t);
+        }
+    });
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::ScatterMeter(uint64_t index, const void* data, size_t dataSize, float scale, size_t channels, WaveformMeter* meter)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+    RingWriteMeter(thiz, index, data, dataSize, scale, channels, meter);
+    thiz.Mark(index, dataSize);
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::GatherConverted(uint64_t index, int format, void* data, int dataFormat, size_t samples, float scale)
+{
+    RingBuffer& thiz = (*this);
+
+    size_t size = samples * sizeWaveform(format);
+    if (thiz.bufferSize == 0 || size == 0 || size > thiz.bufferSize)
+        return 0;
+
+    char* output = (char*)data;
+    uint64_t begin = index;
+    RingRuns(thiz, index, size, [&](uint64_t index, size_t size, bool written)
+    {
+        char* run = output + (index - begin) / sizeWaveform(format) * sizeWaveform(dataFormat);
+        size_t count = size / sizeWaveform(format);
+        if (written)
+        {
+            RingReadConverted(thiz, index, format, run, dataFormat, count, scale);
+        }
+        else
+        {
+            memset(run, 0, count * sizeWaveform(dataFormat));
+        }
+    });
+
+    return size;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::ScatterConverted(uint64_t index, int format, const void* data, int dataFormat, size_t samples, float scale)
+{
+    RingBuffer& thiz = (*this);
+
+    size_t size = samples * sizeWaveform(format);
+    if (thiz.bufferSize == 0 || size == 0 || size > thiz.bufferSize)
+        return 0;
+    RingWriteConverted(thiz, index, format, data, dataFormat, samples, scale);
+    thiz.Mark(index, size);
+
+    return size;
+}
+//------------------------------------------------------------------------------
+uint64_t RingBuffer::GatherMixed(uint64_t index, void* data, size_t dataSize, float scale)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || dataSize > thiz.bufferSize)
+        return 0;
+
+    char* output = (char*)data;
+    uint64_t begin = index;
+    RingRuns(thiz, index, dataSize, [&](uint64_t index, size_t size, bool written)
+    {
+        if (written)
+        {
+            RingReadMixed(thiz, index, output + (index - begin), size, scale);
+        }
+    });
+
+    return dataSize;
+}
+//------------------------------------------------------------------------------
+void RingBuffer::Mark(uint64_t index, size_t size)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || size == 0)
+        return;
+
+    uint64_t end = index + size;
+    for (uint64_t block = index & ~uint64_t(BLOCK_MASK); block < end; block += BLOCK_SIZE)
+    {
+        std::atomic<uint32_t>& stamp = RingStamp(thiz, block);
+        uint32_t lap = RingLap(thiz, block);
+        if (stamp.load(std::memory_order_relaxed) != lap)
+        {
+            char* base = thiz.buffer + RingOffset(thiz, block);
+            if (block < index)
+            {
+                memset(base, 0, size_t(index - block));
+            }
+            if (block + BLOCK_SIZE > end)
+            {
+                memset(base + (end - block), 0, size_t(block + BLOCK_SIZE - end));
+            }
+        }
+        stamp.store(lap, std::memory_order_release);
     }
-    memcpy(data, thiz.buffer + offset, size);
-    if (clear)
+}
+//------------------------------------------------------------------------------
+bool RingBuffer::Written(uint64_t index, size_t size)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || size > thiz.bufferSize)
+        return false;
+
+    uint64_t end = index + size;
+    for (uint64_t block = index & ~uint64_t(BLOCK_MASK); block < end; block += BLOCK_SIZE)
     {
-        memset(thiz.buffer + offset, 0, size);
+        if (RingWritten(thiz, block) == false)
+            return false;
     }
 
-    return dataSize;
+    return true;
 }
 //------------------------------------------------------------------------------
-uint64_t RingBuffer::Scatter(uint64_t index, const void* data, size_t dataSize)
+void RingBuffer::Silence(uint64_t index, size_t size)
 {
     RingBuffer& thiz = (*this);
 
-    if (thiz.bufferSize == 0)
+    if (thiz.bufferSize == 0 || size > thiz.bufferSize)
+        return;
+
+    RingRuns(thiz, index, size, [&](uint64_t index, size_t size, bool written)
+    {
+        if (written == false)
+        {
+            uint64_t offset = RingOffset(thiz, index);
+            if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+            {
+                memset(thiz.buffer + offset, 0, size_t(thiz.bufferSize - offset));
+                size -= size_t(thiz.bufferSize - offset);
+                offset = 0;
+            }
+            memset(thiz.buffer + offset, 0, size);
+        }
+    });
+}
+//------------------------------------------------------------------------------
+void RingBuffer::MarkSilence(uint64_t index, size_t size)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || size == 0 || size > thiz.bufferSize)
+        return;
+
+    uint64_t end = index + size;
+    for (uint64_t block = index & ~uint64_t(BLOCK_MASK); block < end; block += BLOCK_SIZE)
+    {
+        if (block >= index && block + BLOCK_SIZE <= end)
+        {
+            RingStamp(thiz, block).store(RingLap(thiz, block) | RING_SILENT, std::memory_order_release);
+            continue;
+        }
+
+        uint64_t begin = block > index ? block : index;
+        uint64_t stop = block + BLOCK_SIZE < end ? block + BLOCK_SIZE : end;
+        memset(thiz.buffer + RingOffset(thiz, begin), 0, size_t(stop - begin));
+        thiz.Mark(begin, size_t(stop - begin));
+    }
+}
+//------------------------------------------------------------------------------
+size_t RingBuffer::Map(uint64_t index, size_t size, uint8_t* state, size_t count)
+{
+    RingBuffer& thiz = (*this);
+
+    if (thiz.bufferSize == 0 || size == 0 || size > thiz.bufferSize)
         return 0;
-    uint64_t offset = index % thiz.bufferSize;
-    uint64_t size = dataSize;
-    if (size > thiz.bufferSize - offset)
+
+    uint64_t end = index + size;
+    size_t blocks = 0;
+    for (uint64_t block = index & ~uint64_t(BLOCK_MASK); block < end; block += BLOCK_SIZE)
     {
-        size = thiz.bufferSize - offset;
-        memcpy(thiz.buffer + offset, data, size);
-        index += size;
+        if (blocks < count)
+        {
+            state[blocks] = uint8_t(RingState(thiz, block));
+        }
+        blocks++;
+    }
 
-        data = (char*)data + size;
-        offset = index % thiz.bufferSize;
-        size = dataSize - size;
+    return blocks;
+}
+//------------------------------------------------------------------------------
+size_t RingBuffer::Missing(uint64_t index, size_t size, size_t* silence)
+{
+    RingBuffer& thiz = (*this);
+
+    if (silence)
+    {
+        (*silence) = 0;
     }
-    memcpy(thiz.buffer + offset, data, size);
+    if (thiz.bufferSize == 0 || size == 0 || size > thiz.bufferSize)
+        return 0;
 
-    return dataSize;
+    uint64_t end = index + size;
+    size_t missing = 0;
+    for (uint64_t block = index & ~uint64_t(BLOCK_MASK); block < end; block += BLOCK_SIZE)
+    {
+        uint64_t begin = block > index ? block : index;
+        uint64_t stop = block + BLOCK_SIZE < end ? block + BLOCK_SIZE : end;
+        switch (RingState(thiz, block))
+        {
+        case BLOCK_MISSING:
+            missing += size_t(stop - begin);
+            break;
+        case BLOCK_SILENT:
+            if (silence)
+            {
+                (*silence) += size_t(stop - begin);
+            }
+            break;
+        }
+    }
+
+    return missing;
 }
 //------------------------------------------------------------------------------
 char* RingBuffer::Address(uint64_t index, size_t* size)
@@ -108,15 +797,117 @@ char* RingBuffer::Address(uint64_t index, size_t* size)
         return nullptr;
     }
 
-    uint64_t offset = index % thiz.bufferSize;
+    uint64_t offset = RingOffset(thiz, index);
     if (size)
     {
-        if ((*size) > thiz.bufferSize - offset)
+        size_t limit = thiz.bufferMirror ? thiz.bufferSize : thiz.bufferSize - offset;
+        if ((*size) > limit)
         {
-            (*size) = thiz.bufferSize - offset;
+            (*size) = limit;
         }
     }
 
     return thiz.buffer + offset;
 }
 //------------------------------------------------------------------------------
+size_t RingBuffer::Span(uint64_t index, size_t size, char* span[2], size_t spanSize[2])
+{
+    RingBuffer& thiz = (*this);
+
+    span[0] = span[1] = nullptr;
+    spanSize[0] = spanSize[1] = 0;
+    if (thiz.bufferSize == 0 || size > thiz.bufferSize)
+        return 0;
+
+    uint64_t offset = RingOffset(thiz, index);
+    span[0] = thiz.buffer + offset;
+    spanSize[0] = size;
+    if (thiz.bufferMirror == false && size > thiz.bufferSize - offset)
+    {
+        spanSize[0] = thiz.bufferSize - offset;
+        span[1] = thiz.buffer;
+        spanSize[1] = size - spanSize[0];
+    }
+
+    return size;
+}
+//------------------------------------------------------------------------------
+RingQueue::RingQueue() : send(0), reserve(0), reserveSize(0), pick(0)
+{
+}
+//------------------------------------------------------------------------------
+uint64_t RingQueue::Available() const
+{
+    const RingQueue& thiz = (*this);
+
+    uint64_t pick = thiz.LoadPick();
+    uint64_t send = thiz.LoadSend();
+    if (send < pick)
+        return 0;
+
+    return send - pick;
+}
+//------------------------------------------------------------------------------
+uint64_t RingQueue::Free() const
+{
+    const RingQueue& thiz = (*this);
+
+    uint64_t available = thiz.Available();
+    if (available > thiz.bufferSize)
+        return 0;
+
+    return thiz.bufferSize - available;
+}
+//------------------------------------------------------------------------------
+size_t RingQueue::Reserve(uint64_t index, size_t size, char* span[2], size_t spanSize[2])
+{
+    RingQueue& thiz = (*this);
+
+    size = thiz.Span(index, size, span, spanSize);
+    thiz.reserve = index;
+    thiz.reserveSize = size;
+
+    return size;
+}
+//------------------------------------------------------------------------------
+void RingQueue::Commit()
+{
+    RingQueue& thiz = (*this);
+
+    thiz.Mark(thiz.reserve, thiz.reserveSize);
+    thiz.StoreSend(thiz.reserve + thiz.reserveSize);
+    thiz.reserveSize = 0;
+}
+//------------------------------------------------------------------------------
+void RingQueue::CommitSilence()
+{
+    RingQueue& thiz = (*this);
+
+    thiz.MarkSilence(thiz.reserve, thiz.reserveSize);
+    thiz.StoreSend(thiz.reserve + thiz.reserveSize);
+    thiz.reserveSize = 0;
+}
+//------------------------------------------------------------------------------
+size_t RingQueue::Peek(size_t size, char* span[2], size_t spanSize[2])
+{
+    RingQueue& thiz = (*this);
+
+    uint64_t pick = thiz.LoadPick();
+    uint64_t send = thiz.LoadSend();
+    if (send < pick + size)
+    {
+        span[0] = span[1] = nullptr;
+        spanSize[0] = spanSize[1] = 0;
+        return 0;
+    }
+
+    return thiz.Span(pick, size, span, spanSize);
+}
+//------------------------------------------------------------------------------
+void RingQueue::Release(size_t size)
+{
+    RingQueue& thiz = (*this);
+
+    thiz.StorePick(thiz.LoadPick() + size);
+}
+//------------------------------------------------------------------------------
@@ -8,24 +8,140 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <atomic>
 
 #ifndef STREAMAL_EXPORT
 #define STREAMAL_EXPORT
 #endif
 
+#ifndef STREAMAL_CACHELINE
+#if defined(__APPLE__) && (defined(__aarch64__) || defined(__arm64__))
+#define STREAMAL_CACHELINE 128
+#else
+#define STREAMAL_CACHELINE 64
+#endif
+#endif
+
 struct STREAMAL_EXPORT RingBuffer
 {
     RingBuffer();
     ~RingBuffer();
 
+    // Each block remembers the lap it was last written in. A block whose
+    // stamp is not the lap of the position being read holds stale data.
+    // A block stamped silent in its lap reads as zeros without its samples
+    // ever being written.
+    enum
+    {
+        BLOCK_SHIFT = 8,
+        BLOCK_SIZE = 1 << BLOCK_SHIFT,
+        BLOCK_MASK = BLOCK_SIZE - 1,
+    };
+    enum
+    {
+        BLOCK_MISSING = 0,
+        BLOCK_PRESENT = 1,
+        BLOCK_SILENT = 2,
+    };
+
     char* buffer;
     size_t bufferSize;
+    size_t bufferMask;
+    int bufferShift;
+    bool bufferMirror;
+    std::atomic<uint32_t>* bufferStamp;
 
-    bool Startup(size_t size);
+    // With mirror, the capacity is rounded up to a power of two and the same
+    // pages are mapped twice back-to-back, so any span of up to bufferSize
+    // bytes is contiguous. Falls back to a plain power-of-two allocation when
+    // the platform refuses the mapping.
+    bool Startup(size_t size, bool mirror = false);
     void Shutdown();
 
+    // With clear, blocks not written in the current lap read as silence.
     uint64_t Gather(uint64_t index, void* data, size_t dataSize, bool clear);
     uint64_t Scatter(uint64_t index, const void* data, size_t dataSize);
 
+    // Copy with saturating gain in one pass over 16-bit samples.
+    uint64_t GatherScaled(uint64_t index, void* data, size_t dataSize, float scale);
+    uint64_t ScatterScaled(uint64_t index, const void* data, size_t dataSize, float scale);
+
+    // ScatterScaled that adds the activity of what it wrote, in frames of
+    // channels samples, in the same pass.
+    uint64_t ScatterActivity(uint64_t index, const void* data, size_t dataSize, float scale, size_t channels, struct WaveformActivity* activity);
+
+    // GatherScaled and ScatterScaled that add the levels of what they moved
+    // to meter, in frames of channels samples counted from index 0. Stale
+    // blocks meter as the silence they read as.
+    uint64_t GatherMeter(uint64_t index, void* data, size_t dataSize, float scale, size_t channels, struct WaveformMeter* meter);
+    uint64_t ScatterMeter(uint64_t index, const void* data, size_t dataSize, float scale, size_t channels, struct WaveformMeter* meter);
+
+    // The same with the ring holding samples in format and data in
+    // dataFormat, converted in the same pass. Returns the ring bytes moved.
+    uint64_t GatherConverted(uint64_t index, int format, void* data, int dataFormat, size_t samples, float scale);
+    uint64_t ScatterConverted(uint64_t index, int format, const void* data, int dataFormat, size_t samples, float scale);
+
+    // Saturating accumulate into data; stale blocks contribute nothing.
+    uint64_t GatherMixed(uint64_t index, void* data, size_t dataSize, float scale);
+
+    // Stamp [index, index + size) as written in the current lap. Parts of a
+    // stale block outside the range are zeroed so the block reads as silence.
+    void Mark(uint64_t index, size_t size);
+    bool Written(uint64_t index, size_t size);
+    void Silence(uint64_t index, size_t size);
+
+    // Stamp the blocks inside [index, index + size) silent in the current
+    // lap. Blocks the range only partly covers get zeros for that part and
+    // are marked as written.
+    void MarkSilence(uint64_t index, size_t size);
+
+    // One BLOCK_ state per block touched by [index, index + size), at most
+    // count of them. Returns the number of blocks in the range.
+    size_t Map(uint64_t index, size_t size, uint8_t* state, size_t count);
+
+    // Bytes of [index, index + size) in blocks that are neither written nor
+    // silent, and with silence, the bytes in silent blocks.
+    size_t Missing(uint64_t index, size_t size, size_t* silence = nullptr);
+
     char* Address(uint64_t index, size_t* size);
+
+    // Resolve [index, index + size) into at most two spans. The second span
+    // is empty unless the range wraps a ring that is not mirrored.
+    size_t Span(uint64_t index, size_t size, char* span[2], size_t spanSize[2]);
+};
+//------------------------------------------------------------------------------
+// Single-producer / single-consumer ring
+//
+// The producer is the only writer of send and the consumer is the only writer
+// of pick. Each cursor sits on its own cache line, and is published with
+// release and observed with acquire, so the data written before a store is
+// visible to the other side after the matching load.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT RingQueue : public RingBuffer
+{
+    RingQueue();
+
+    uint64_t LoadSend() const { return send.load(std::memory_order_acquire); }
+    uint64_t LoadPick() const { return pick.load(std::memory_order_acquire); }
+    void StoreSend(uint64_t index) { send.store(index, std::memory_order_release); }
+    void StorePick(uint64_t index) { pick.store(index, std::memory_order_release); }
+
+    uint64_t Available() const;
+    uint64_t Free() const;
+
+    // Producer side : write straight into the ring at index, then publish.
+    size_t Reserve(uint64_t index, size_t size, char* span[2], size_t spanSize[2]);
+    void Commit();
+
+    // Publish the reservation as silence, with nothing copied into it.
+    void CommitSilence();
+
+    // Consumer side : read straight from the ring at pick, then retire.
+    size_t Peek(size_t size, char* span[2], size_t spanSize[2]);
+    void Release(size_t size);
+
+    alignas(STREAMAL_CACHELINE) std::atomic<uint64_t> send;
+    uint64_t reserve;
+    size_t reserveSize;
+    alignas(STREAMAL_CACHELINE) std::atomic<uint64_t> pick;
 };
@@ -0,0 +1,1385 @@
+//==============================================================================
+// Stream Core
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <string.h>
+#include <new>
+#include "Resampler.h"
+#include "Waveform.h"
+#include "Mixer.h"
+#include "StreamCore.h"
+
+//==============================================================================
+// Stream Core
+//==============================================================================
+// Steer the fill level with a fine ratio trim, so the hard resync in Reserve
+// only fires when the trim cannot keep up.
+static void StreamSteer(StreamCore& thiz, uint64_t now)
+{
+    if (thiz.driftEnable == false || thiz.go == false)
+        return;
+
+    uint64_t send = thiz.bufferQueue.LoadSend();
+    uint64_t pick = thiz.bufferQueue.LoadPick();
+    if (send >= pick)
+    {
+        ResamplerDrift(thiz.resampler, thiz.drift.Update(now, send - pick));
+    }
+}
+//------------------------------------------------------------------------------
+// A span of an unmirrored ring ends on a sample but not always on a frame, so
+// the frame that straddles the wrap is moved a sample at a time.
+static void StreamInterleave(StreamCore& thiz, void* span[2], size_t spanSize[2], const void* const* planes)
+{
+    size_t size = sizeWaveform(thiz.format);
+    size_t frame = size * thiz.channel;
+    size_t frames = spanSize[0] / frame;
+    interleaveWaveform(span[0], planes, 0, thiz.channel, frames, thiz.format);
+    if (spanSize[1] == 0)
+        return;
+
+    size_t split = spanSize[0] % frame / size;
+    for (size_t c = 0; c < thiz.channel; ++c)
+    {
+        char* output = c < split ? (char*)span[0] + frames * frame + c * size : (char*)span[1] + (c - split) * size;
+        memcpy(output, (char*)planes[c] + frames * size, size);
+    }
+    size_t head = (thiz.channel - split) * size;
+    interleaveWaveform((char*)span[1] + head, planes, frames + 1, thiz.channel, (spanSize[1] - head) / frame, thiz.format);
+}
+//------------------------------------------------------------------------------
+static void StreamDeinterleave(StreamCore& thiz, void* const* planes, const void* span[2], size_t spanSize[2])
+{
+    size_t size = sizeWaveform(thiz.format);
+    size_t frame = size * thiz.channel;
+    size_t frames = spanSize[0] / frame;
+    deinterleaveWaveform(planes, 0, span[0], thiz.channel, frames, thiz.format);
+    if (spanSize[1] == 0)
+        return;
+
+    size_t split = spanSize[0] % frame / size;
+    for (size_t c = 0; c < thiz.channel; ++c)
+    {
+        const char* input = c < split ? (char*)span[0] + frames * frame + c * size : (char*)span[1] + (c - split) * size;
+        memcpy((char*)planes[c] + frames * size, input, size);
+    }
+    size_t head = (thiz.channel - split) * size;
+    deinterleaveWaveform(planes, frames + 1, (char*)span[1] + head, thiz.channel, (spanSize[1] - head) / frame, thiz.format);
+}
+//------------------------------------------------------------------------------
+// Gains in mask order come from Matrix or matrixWaveform, then the device side
+// moves to device order. The matrix is left out when it would copy frames.
+static void StreamRemix(StreamCore& thiz)
+{
+    float gain[WAVEFORM_CHANNEL_MAX * WAVEFORM_CHANNEL_MAX];
+    if (thiz.custom)
+    {
+        memcpy(gain, thiz.matrixCustom, sizeof(gain));
+    }
+    else if (thiz.record)
+    {
+        matrixWaveform(gain, thiz.deviceMask, thiz.channelMask);
+    }
+    else
+    {
+        matrixWaveform(gain, thiz.channelMask, thiz.deviceMask);
+    }
+
+    bool order = true;
+    memset(thiz.matrix, 0, sizeof(thiz.matrix));
+    for (size_t d = 0; d < thiz.deviceChannel; ++d)
+    {
+        size_t rank = thiz.deviceOrder[d];
+        for (size_t c = 0; c < thiz.channel; ++c)
+        {
+            if (thiz.record)
+            {
+                thiz.matrix[d * WAVEFORM_CHANNEL_MAX + c] = gain[rank * WAVEFORM_CHANNEL_MAX + c];
+            }
+            else
+            {
+                thiz.matrix[c * WAVEFORM_CHANNEL_MAX + d] = gain[c * WAVEFORM_CHANNEL_MAX + rank];
+            }
+        }
+        if (rank != d)
+            order = false;
+    }
+
+    thiz.remix = thiz.custom || order == false || thiz.channelMask != thiz.deviceMask;
+}
+//------------------------------------------------------------------------------
+// Fill the blocks of a period that never arrived from the concealer, in runs
+// of whole frames that end on a block boundary, so a block is either left as
+// it came or written and marked as a whole. The first real frames after a
+// loss are crossfaded in place.
+//------------------------------------------------------------------------------
+static int StreamBlock(StreamCore& thiz, uint64_t index)
+{
+    uint8_t state = RingBuffer::BLOCK_MISSING;
+    thiz.bufferQueue.Map(index, 1, &state, 1);
+    return state;
+}
+//------------------------------------------------------------------------------
+static uint64_t StreamFrameAfter(uint64_t index, size_t frame)
+{
+    uint64_t next = (index | RingBuffer::BLOCK_MASK) + 1;
+    return next + (frame - next % frame) % frame;
+}
+//------------------------------------------------------------------------------
+// A loss starts from the frames that played right before index, and needs
+// them all to be there.
+static bool StreamConcealBegin(StreamCore& thiz, uint64_t index)
+{
+    Conceal& conceal = thiz.conceal;
+    if (conceal.active)
+        return true;
+
+    size_t frame = sizeWaveform(thiz.format) * thiz.channel;
+    uint64_t history = conceal.historyFrames * frame;
+    if (index < history)
+        return false;
+    thiz.bufferQueue.GatherConverted(index - history, thiz.format, conceal.history, WAVEFORM_F32, conceal.historyFrames * thiz.channel, 1.0f);
+    conceal.Begin(conceal.history);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+// Only [pick, send) of the period is the device's to rewrite. Past send the
+// ring is where Queue writes next, so Underrun carries a loss on into the
+// output instead, and nothing past the period is touched either.
+static void StreamConceal(StreamCore& thiz, uint64_t pick, size_t size, uint64_t send)
+{
+    Conceal& conceal = thiz.conceal;
+    uint64_t end = pick + size;
+    if (end > send)
+        end = send > pick ? send : pick;
+    if (end == pick)
+        return;
+    if (conceal.active == false && thiz.bufferQueue.Missing(pick, size_t(end - pick)) == 0)
+        return;
+
+    float buffer[128 * WAVEFORM_CHANNEL_MAX];
+    size_t frame = sizeWaveform(thiz.format) * thiz.channel;
+    uint64_t index = pick;
+    while (index < end)
+    {
+        uint64_t stop = StreamFrameAfter(index, frame);
+        if (stop > end)
+            stop = end;
+        switch (StreamBlock(thiz, index))
+        {
+        case RingBuffer::BLOCK_SILENT:
+            conceal.Reset();
+            break;
+
+        case RingBuffer::BLOCK_PRESENT:
+            while (conceal.active && index < stop)
+            {
+                size_t count = size_t(stop - index) / frame;
+                if (count > 128)
+                    count = 128;
+                thiz.bufferQueue.GatherConverted(index, thiz.format, buffer, WAVEFORM_F32, count * thiz.channel, 1.0f);
+                count = conceal.Recover(buffer, count);
+                thiz.bufferQueue.ScatterConverted(index, thiz.format, buffer, WAVEFORM_F32, count * thiz.channel, 1.0f);
+                index += count * frame;
+            }
+            break;
+
+        default:
+            while (stop < end && StreamBlock(thiz, stop) == RingBuffer::BLOCK_MISSING)
+                stop = StreamFrameAfter(stop, frame);
+            if (stop > end)
+                stop = end;
+            if (StreamConcealBegin(thiz, index) == false)
+                break;
+
+            // Once faded out, the blocks are left to read as silence.
+            size_t concealed = 0;
+            while (index < stop && conceal.Faded() == false)
+            {
+                size_t count = size_t(stop - index) / frame;
+                if (count > 128)
+                    count = 128;
+                conceal.Generate(buffer, count);
+                thiz.bufferQueue.ScatterConverted(index, thiz.format, buffer, WAVEFORM_F32, count * thiz.channel, 1.0f);
+                index += count * frame;
+                concealed += count * frame;
+            }
+            if (concealed)
+            {
+                thiz.telemetry.Concealed(concealed);
+            }
+            break;
+        }
+        index = stop;
+    }
+}
+//------------------------------------------------------------------------------
+// Slices of 128 frames keep the float buffers in L1 for up to eight channels.
+// The meter, when given, takes each slice on its way in, in the stream's own
+// channels.
+static void StreamPlayRemix(StreamCore& thiz, void* output, size_t frames, WaveformMeter* meter)
+{
+    int16_t mix[128 * WAVEFORM_CHANNEL_MAX];
+    float input[128 * WAVEFORM_CHANNEL_MAX];
+    float remix[128 * WAVEFORM_CHANNEL_MAX];
+    size_t deviceFrame = sizeWaveform(thiz.deviceFormat) * thiz.deviceChannel;
+
+    bool go = thiz.mixer == nullptr && thiz.go;
+    uint64_t pick = thiz.bufferQueue.LoadPick();
+    if (go)
+    {
+        thiz.Period(pick, frames * sizeWaveform(thiz.format) * thiz.channel);
+    }
+
+    for (size_t i = 0; i < frames; i += 128)
+    {
+        size_t count = frames - i < 128 ? frames - i : 128;
+        size_t samples = count * thiz.channel;
+        if (thiz.mixer)
+        {
+            MixerRender(thiz.mixer, mix, samples * sizeof(int16_t), thiz.volume);
+            if (meter)
+                scaleWaveform(mix, mix, samples * sizeof(int16_t), 1.0f, thiz.channel, meter);
+            convertWaveform(input, WAVEFORM_F32, mix, WAVEFORM_S16, samples, 1.0f);
+        }
+        else if (go && meter)
+        {
+            uint64_t index = pick;
+            pick += thiz.bufferQueue.GatherMeter(pick, mix, samples * sizeof(int16_t), thiz.volume, thiz.channel, meter);
+            convertWaveform(input, WAVEFORM_F32, mix, WAVEFORM_S16, samples, 1.0f);
+            thiz.Underrun(index, input, WAVEFORM_F32, samples, thiz.volume, false, meter);
+        }
+        else if (go)
+        {
+            uint64_t index = pick;
+            pick += thiz.bufferQueue.GatherConverted(pick, thiz.format, input, WAVEFORM_F32, samples, thiz.volume);
+            thiz.Underrun(index, input, WAVEFORM_F32, samples, thiz.volume, false, nullptr);
+        }
+        else
+        {
+            memset(input, 0, samples * sizeof(float));
+        }
+        remixWaveform(remix, input, count, thiz.matrix, thiz.channel, thiz.deviceChannel);
+        convertWaveform((char*)output + i * deviceFrame, thiz.deviceFormat, remix, WAVEFORM_F32, count * thiz.deviceChannel, 1.0f);
+    }
+
+    if (go)
+    {
+        thiz.bufferQueue.StorePick(pick);
+    }
+}
+//------------------------------------------------------------------------------
+static uint64_t StreamRecordRemix(StreamCore& thiz, uint64_t send, const void* input, size_t frames)
+{
+    float capture[128 * WAVEFORM_CHANNEL_MAX];
+    float remix[128 * WAVEFORM_CHANNEL_MAX];
+    size_t deviceFrame = sizeWaveform(thiz.deviceFormat) * thiz.deviceChannel;
+
+    for (size_t i = 0; i < frames; i += 128)
+    {
+        size_t count = frames - i < 128 ? frames - i : 128;
+        convertWaveform(capture, WAVEFORM_F32, (char*)input + i * deviceFrame, thiz.deviceFormat, count * thiz.deviceChannel, 1.0f);
+        remixWaveform(remix, capture, count, thiz.matrix, thiz.deviceChannel, thiz.channel);
+        send += thiz.bufferQueue.ScatterConverted(send, thiz.format, remix, WAVEFORM_F32, count * thiz.channel, thiz.volume);
+    }
+
+    return send;
+}
+//------------------------------------------------------------------------------
+// The detector speaks for whole periods, and the map keeps its verdict per
+// ring block. A block that starts in [begin, end) takes the verdict, and a
+// block the previous period started keeps speech if either period had it.
+static void StreamVoiceMark(StreamCore& thiz, uint64_t begin, uint64_t end, bool speech)
+{
+    for (uint64_t block = begin >> RingBuffer::BLOCK_SHIFT; (block << RingBuffer::BLOCK_SHIFT) < end; ++block)
+    {
+        std::atomic<uint8_t>& flag = thiz.voiceMap[block % thiz.voiceBlocks];
+        if ((block << RingBuffer::BLOCK_SHIFT) >= begin)
+            flag.store(speech, std::memory_order_relaxed);
+        else if (speech)
+            flag.store(true, std::memory_order_relaxed);
+    }
+}
+//------------------------------------------------------------------------------
+static bool StreamVoiceSpeech(StreamCore& thiz, uint64_t index, size_t size)
+{
+    for (uint64_t block = index >> RingBuffer::BLOCK_SHIFT; (block << RingBuffer::BLOCK_SHIFT) < index + size; ++block)
+    {
+        if (thiz.voiceMap[block % thiz.voiceBlocks].load(std::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+// Measure what Record already wrote, for captures the 16-bit gain pass did
+// not carry. The scale of one leaves the samples as they are.
+static void StreamVoiceMeasure(StreamCore& thiz, uint64_t index, size_t size, WaveformActivity* activity)
+{
+    char* span[2];
+    size_t spanSize[2];
+    if (thiz.bufferQueue.Span(index, size, span, spanSize) == 0)
+        return;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (spanSize[i])
+        {
+            scaleWaveform((int16_t*)span[i], (int16_t*)span[i], spanSize[i], 1.0f, thiz.channel, activity);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// Meter what Record already wrote, for captures its own gain pass did not
+// carry, through a scratch copy so the ring stays as it is.
+static void StreamMeter(StreamCore& thiz, uint64_t index, size_t size, float scale, WaveformMeter* meter)
+{
+    int16_t scratch[2048];
+    while (size)
+    {
+        size_t count = size < sizeof(scratch) ? size : sizeof(scratch);
+        thiz.bufferQueue.GatherMeter(index, scratch, count, scale, thiz.channel, meter);
+        index += count;
+        size -= count;
+    }
+}
+//------------------------------------------------------------------------------
+StreamCore::StreamCore() : bufferQueueSendAdjust(0), bufferQueuePickAdjust(0), resampler(nullptr), inputRate(0), convertBuffer(nullptr), convertCapacity(0), convertFill(0), driftEnable(false), concealEnable(false), concealSend(0), playoutEnable(false), voiceEnable(false), voiceCollapse(false), voiceMap(nullptr), voiceBlocks(0), voiceSpeech(false), voiceCollapsed(0), meterEnable(false), mixer(nullptr), channel(0), sampleRate(0), bytesPerSecond(0), format(WAVEFORM_S16), deviceFormat(WAVEFORM_S16), channelMask(0), deviceChannel(0), deviceMask(0), deviceOrder(), matrixCustom(), matrix(), custom(false), remix(false), volume(0.0f), ready(false), go(false), record(false), bufferSize(0), start(nullptr), startContext(nullptr)
+{
+}
+//------------------------------------------------------------------------------
+StreamCore::~StreamCore()
+{
+    StreamCore& thiz = (*this);
+
+    ResamplerDestroy(thiz.resampler);
+    thiz.resampler = nullptr;
+    delete[] thiz.convertBuffer;
+    thiz.convertBuffer = nullptr;
+    delete[] thiz.voiceMap;
+    thiz.voiceMap = nullptr;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::Startup(int channel, int sampleRate, int secondPerBuffer, bool record, int format, void (*start)(void* context), void* context)
+{
+    StreamCore& thiz = (*this);
+    if (channel == 0)
+        return false;
+    if (sampleRate == 0)
+        return false;
+    if (sizeWaveform(format) == 0)
+        return false;
+
+    if (thiz.bufferQueue.Startup(sampleRate * sizeWaveform(format) * channel * secondPerBuffer, true) == false)
+        return false;
+
+    thiz.channel = channel;
+    thiz.sampleRate = sampleRate;
+    thiz.bytesPerSecond = sampleRate * sizeWaveform(format) * channel;
+    thiz.format = format;
+    thiz.deviceFormat = format;
+    thiz.channelMask = maskWaveform(channel);
+    thiz.deviceChannel = channel;
+    thiz.deviceMask = thiz.channelMask;
+    for (size_t i = 0; i < WAVEFORM_CHANNEL_MAX; ++i)
+        thiz.deviceOrder[i] = (uint8_t)i;
+    thiz.telemetry.Startup(thiz.bytesPerSecond);
+    thiz.volume = record ? 1.0f : 0.0f;
+    thiz.record = record;
+    thiz.start = start;
+    thiz.startContext = context;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+size_t StreamCore::DeviceSize(size_t size) const
+{
+    const StreamCore& thiz = (*this);
+
+    return size / (sizeWaveform(thiz.format) * thiz.channel) * sizeWaveform(thiz.deviceFormat) * thiz.deviceChannel;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::Layout(uint32_t channelMask)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.channel > WAVEFORM_CHANNEL_MAX)
+        return false;
+
+    if (channelMask == 0)
+        channelMask = maskWaveform(thiz.channel);
+
+    size_t count = 0;
+    for (uint32_t bit = channelMask; bit; bit &= bit - 1)
+        count++;
+    if (count != thiz.channel)
+        return false;
+
+    thiz.channelMask = channelMask;
+    StreamRemix(thiz);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::DeviceLayout(int deviceChannel, const uint32_t* speaker)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.channel > WAVEFORM_CHANNEL_MAX)
+        return deviceChannel == (int)thiz.channel && speaker == nullptr;
+    if (deviceChannel <= 0 || deviceChannel > WAVEFORM_CHANNEL_MAX)
+        return false;
+
+    uint32_t deviceMask = 0;
+    if (speaker == nullptr)
+    {
+        deviceMask = maskWaveform(deviceChannel);
+    }
+    else
+    {
+        for (int i = 0; i < deviceChannel; ++i)
+        {
+            if (speaker[i] == 0 || (speaker[i] & (speaker[i] - 1)) || (deviceMask & speaker[i]))
+                return false;
+            deviceMask |= speaker[i];
+        }
+    }
+
+    for (int i = 0; i < deviceChannel; ++i)
+    {
+        uint8_t rank = (uint8_t)i;
+        if (speaker)
+        {
+            rank = 0;
+            for (uint32_t bit = deviceMask & (speaker[i] - 1); bit; bit &= bit - 1)
+                rank++;
+        }
+        thiz.deviceOrder[i] = rank;
+    }
+    thiz.deviceChannel = deviceChannel;
+    thiz.deviceMask = deviceMask;
+    StreamRemix(thiz);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::Matrix(const float* matrix)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.channel > WAVEFORM_CHANNEL_MAX)
+        return false;
+
+    thiz.custom = matrix != nullptr;
+    if (matrix)
+    {
+        memcpy(thiz.matrixCustom, matrix, sizeof(thiz.matrixCustom));
+    }
+    StreamRemix(thiz);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::DeviceFallback()
+{
+    StreamCore& thiz = (*this);
+
+    if (thiz.deviceChannel > 2)
+        return thiz.DeviceLayout(2, nullptr);
+    if (thiz.deviceFormat != WAVEFORM_S16)
+    {
+        thiz.deviceFormat = WAVEFORM_S16;
+        return true;
+    }
+
+    return false;
+}
+//------------------------------------------------------------------------------
+// With adaptive playout, a packet should land Delay ahead of pick. One that
+// needs a resync or found less than half of that moves send ahead at once,
+// and the bytes it skips play as missing. Smaller shortfalls wait for silence.
+static uint64_t StreamPlayout(StreamCore& thiz, uint64_t send, uint64_t pick)
+{
+    size_t frame = sizeWaveform(thiz.format) * thiz.channel;
+    uint64_t delay = thiz.playout.Delay() * thiz.bytesPerSecond / 1000000;
+    if (send != 0 && send >= pick + delay / 2)
+        return send;
+    if (send != 0)
+    {
+        thiz.drift.Reset();
+        ResamplerDrift(thiz.resampler, 0);
+    }
+
+    uint64_t place = pick + delay + frame - 1;
+    return place - (place % frame);
+}
+//------------------------------------------------------------------------------
+size_t StreamCore::QueueReserve(uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2])
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record)
+        return 0;
+    if (thiz.mixer)
+        return 0;
+    if (bufferSize == 0)
+        return 0;
+
+    if (thiz.playoutEnable)
+    {
+        thiz.playout.Update(now, timestamp, bufferSize * 1000000 / thiz.bytesPerSecond);
+        thiz.telemetry.Playout(uint64_t(thiz.playout.target), uint64_t(thiz.playout.jitter));
+    }
+
+    uint64_t send = thiz.bufferQueue.LoadSend();
+    if (thiz.ready)
+    {
+        uint64_t pick = thiz.bufferQueue.LoadPick();
+        if (send < pick || send > pick + thiz.bytesPerSecond / 2)
+        {
+            send = 0;
+            timestamp = now + thiz.bufferQueuePickAdjust;
+            thiz.drift.Reset();
+            ResamplerDrift(thiz.resampler, 0);
+            thiz.telemetry.Resync();
+        }
+        if (thiz.playoutEnable)
+        {
+            send = StreamPlayout(thiz, send, pick);
+        }
+    }
+
+    if (send == 0 || thiz.bufferQueueSendAdjust != adjust)
+    {
+        send = (timestamp + adjust) * thiz.bytesPerSecond / 1000000;
+        send = send - (send % bufferSize);
+        thiz.bufferQueueSendAdjust = adjust;
+    }
+
+    if (thiz.ready)
+    {
+        uint64_t pick = thiz.bufferQueue.LoadPick();
+        thiz.telemetry.Packet(send, pick);
+        thiz.telemetry.Write(send, pick, bufferSize, thiz.bufferQueue.bufferSize);
+    }
+
+    char* ring[2];
+    size_t size = thiz.bufferQueue.Reserve(send, bufferSize, ring, spanSize);
+    span[0] = ring[0];
+    span[1] = ring[1];
+
+    return size;
+}
+//------------------------------------------------------------------------------
+// After a commit, the first one makes the stream ready, with pick gap buffers
+// of bufferSize behind the timestamp, and every later one lets it go.
+//------------------------------------------------------------------------------
+static uint64_t StreamQueued(StreamCore& thiz, uint64_t now, uint64_t timestamp, size_t bufferSize, int gap)
+{
+    if (thiz.ready == false)
+    {
+        int64_t adjust = 0;
+        if (now > timestamp)
+        {
+            adjust = timestamp - now;
+        }
+
+        // A stream that learned its playout delay before a Reset starts with
+        // that instead of the gap.
+        uint64_t preroll = bufferSize * gap;
+        if (thiz.playoutEnable && thiz.playout.arrivals > 1)
+        {
+            preroll = uint64_t(thiz.playout.target) * thiz.bytesPerSecond / 1000000;
+        }
+        else if (thiz.playoutEnable)
+        {
+            thiz.playout.Seed(preroll * 1000000 / thiz.bytesPerSecond);
+        }
+
+        thiz.bufferSize = bufferSize;
+        uint64_t pick = (now + adjust) * thiz.bytesPerSecond / 1000000 - preroll;
+        pick = pick - (pick % bufferSize);
+        thiz.bufferQueue.StorePick(pick);
+        thiz.bufferQueuePickAdjust = adjust;
+        thiz.ready = true;
+
+        if (thiz.start)
+            thiz.start(thiz.startContext);
+    }
+    else
+    {
+        thiz.go = true;
+    }
+
+    return thiz.bufferQueue.LoadPick() * 1000000 / thiz.bytesPerSecond;
+}
+//------------------------------------------------------------------------------
+uint64_t StreamCore::QueueCommit(uint64_t now, uint64_t timestamp, int gap)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record)
+        return 0;
+
+    size_t bufferSize = thiz.bufferQueue.reserveSize;
+    if (bufferSize == 0)
+        return 0;
+    thiz.bufferQueue.Commit();
+
+    return StreamQueued(thiz, now, timestamp, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t StreamCore::Queue(uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    StreamCore& thiz = (*this);
+
+    if (thiz.resampler)
+    {
+        StreamSteer(thiz, now);
+
+        size_t frame = sizeof(int16_t) * thiz.channel;
+        size_t frames = 0;
+        buffer = ResamplerConvert(thiz.resampler, (int16_t*)buffer, bufferSize / frame, &frames);
+        bufferSize = frames * frame;
+        if (buffer == nullptr)
+            return 0;
+    }
+
+    void* span[2];
+    size_t spanSize[2];
+    if (thiz.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize) == 0)
+        return 0;
+    memcpy(span[0], buffer, spanSize[0]);
+    if (spanSize[1])
+    {
+        memcpy(span[1], (char*)buffer + spanSize[0], spanSize[1]);
+    }
+
+    return thiz.QueueCommit(now, timestamp, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t StreamCore::QueuePlanar(uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    StreamCore& thiz = (*this);
+
+    // The resampler takes the planes as they are and hands back frames.
+    if (thiz.resampler)
+    {
+        StreamSteer(thiz, now);
+
+        size_t frame = sizeof(int16_t) * thiz.channel;
+        size_t frames = 0;
+        const int16_t* output = ResamplerConvertPlanar(thiz.resampler, (const int16_t* const*)buffer, bufferSize / frame, &frames);
+        if (output == nullptr)
+            return 0;
+
+        void* span[2];
+        size_t spanSize[2];
+        if (thiz.QueueReserve(now, timestamp, adjust, frames * frame, span, spanSize) == 0)
+            return 0;
+        memcpy(span[0], output, spanSize[0]);
+        if (spanSize[1])
+        {
+            memcpy(span[1], (char*)output + spanSize[0], spanSize[1]);
+        }
+
+        return thiz.QueueCommit(now, timestamp, gap);
+    }
+
+    void* span[2];
+    size_t spanSize[2];
+    if (thiz.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize) == 0)
+        return 0;
+    StreamInterleave(thiz, span, spanSize, buffer);
+
+    return thiz.QueueCommit(now, timestamp, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t StreamCore::QueueBatch(uint64_t now, int64_t adjust, const StreamPacket* packet, size_t count, int gap)
+{
+    StreamCore& thiz = (*this);
+
+    if (thiz.resampler)
+    {
+        StreamSteer(thiz, now);
+    }
+
+    // The first packet takes the resync check and the timestamp, the rest
+    // follow it in the same reservation and go out with one commit.
+    uint64_t timestamp = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const void* buffer = packet[i].buffer;
+        size_t bufferSize = packet[i].bufferSize;
+        if (thiz.resampler)
+        {
+            size_t frame = sizeof(int16_t) * thiz.channel;
+            size_t frames = 0;
+            buffer = ResamplerConvert(thiz.resampler, (int16_t*)buffer, bufferSize / frame, &frames);
+            bufferSize = frames * frame;
+            if (buffer == nullptr)
+                continue;
+        }
+
+        void* span[2];
+        size_t spanSize[2];
+        if (first == 0)
+        {
+            if (thiz.QueueReserve(now, packet[i].timestamp, adjust, bufferSize, span, spanSize) == 0)
+                continue;
+            timestamp = packet[i].timestamp;
+            first = bufferSize;
+        }
+        else
+        {
+            if (bufferSize == 0)
+                continue;
+            if (thiz.bufferQueue.reserveSize + bufferSize > thiz.bufferQueue.bufferSize)
+                break;
+
+            uint64_t send = thiz.bufferQueue.reserve + thiz.bufferQueue.reserveSize;
+            if (thiz.playoutEnable)
+            {
+                thiz.playout.Update(now, packet[i].timestamp, bufferSize * 1000000 / thiz.bytesPerSecond);
+            }
+            if (thiz.ready)
+            {
+                uint64_t pick = thiz.bufferQueue.LoadPick();
+                thiz.telemetry.Packet(send, pick);
+                thiz.telemetry.Write(send, pick, bufferSize, thiz.bufferQueue.bufferSize);
+            }
+
+            char* ring[2];
+            thiz.bufferQueue.Span(send, bufferSize, ring, spanSize);
+            span[0] = ring[0];
+            span[1] = ring[1];
+            thiz.bufferQueue.reserveSize += bufferSize;
+        }
+
+        memcpy(span[0], buffer, spanSize[0]);
+        if (spanSize[1])
+        {
+            memcpy(span[1], (char*)buffer + spanSize[0], spanSize[1]);
+        }
+    }
+    if (first == 0)
+        return 0;
+    bool more = thiz.bufferQueue.reserveSize > first;
+    thiz.bufferQueue.Commit();
+
+    // Packets after the first count as the later Queue calls that let a
+    // stream made ready by the first one go.
+    uint64_t pick = StreamQueued(thiz, now, timestamp, first, gap);
+    if (more)
+    {
+        thiz.go = true;
+    }
+
+    return pick;
+}
+//------------------------------------------------------------------------------
+uint64_t StreamCore::QueueSilence(uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    StreamCore& thiz = (*this);
+
+    // Nothing goes through the resampler, the span is sized at the rate it
+    // would have come out at. A resampler that only carries the drift trim
+    // has no input rate and leaves the size alone.
+    if (thiz.resampler && thiz.inputRate != 0)
+    {
+        size_t frame = sizeof(int16_t) * thiz.channel;
+        bufferSize = size_t(uint64_t(bufferSize / frame) * thiz.sampleRate / thiz.inputRate) * frame;
+    }
+
+    void* span[2];
+    size_t spanSize[2];
+    if (thiz.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize) == 0)
+        return 0;
+
+    // Silence is where adaptive playout moves, stretched to make up a
+    // shortfall or cut by at most half to give back an excess.
+    if (thiz.playoutEnable && thiz.ready)
+    {
+        size_t frame = sizeWaveform(thiz.format) * thiz.channel;
+        uint64_t send = thiz.bufferQueue.reserve;
+        uint64_t pick = thiz.bufferQueue.LoadPick();
+        uint64_t delay = thiz.playout.Delay() * thiz.bytesPerSecond / 1000000;
+        uint64_t slack = uint64_t(Playout::PLAYOUT_SLACK) * thiz.bytesPerSecond / 1000000;
+        if (send + slack < pick + delay)
+        {
+            uint64_t grow = pick + delay - send + frame - 1;
+            thiz.bufferQueue.reserveSize += size_t(grow - (grow % frame));
+        }
+        else if (send > pick + delay + slack)
+        {
+            uint64_t trim = send - pick - delay;
+            if (trim > bufferSize / 2)
+                trim = bufferSize / 2;
+            thiz.bufferQueue.reserveSize -= size_t(trim - (trim % frame));
+        }
+    }
+    thiz.bufferQueue.CommitSilence();
+
+    return StreamQueued(thiz, now, timestamp, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+// A recorder that converts runs whatever the ring holds through the resampler
+// and keeps the output until there is a whole buffer of it, so the ring is
+// free again as soon as it is read.
+static size_t StreamDequeueConvert(StreamCore& thiz, const void* span[2], size_t spanSize[2], size_t bufferSize)
+{
+    size_t frame = sizeof(int16_t) * thiz.channel;
+    span[0] = span[1] = nullptr;
+    spanSize[0] = spanSize[1] = 0;
+    bufferSize -= bufferSize % frame;
+    if (bufferSize == 0)
+        return 0;
+
+    if (thiz.convertCapacity < bufferSize)
+    {
+        char* buffer = new (std::nothrow) char[bufferSize];
+        if (buffer == nullptr)
+            return 0;
+        memcpy(buffer, thiz.convertBuffer, thiz.convertFill);
+        delete[] thiz.convertBuffer;
+        thiz.convertBuffer = buffer;
+        thiz.convertCapacity = bufferSize;
+    }
+
+    // The ring comes out through a slice of whole frames, so a span that
+    // ends inside a frame does not reach the resampler.
+    int16_t input[2048];
+    size_t slice = (2048 - 2048 % thiz.channel) / thiz.channel;
+    uint64_t send = thiz.bufferQueue.LoadSend();
+    uint64_t pick = thiz.bufferQueue.LoadPick();
+    while (thiz.convertFill < bufferSize && send >= pick + frame)
+    {
+        size_t count = size_t(send - pick) / frame;
+        if (count > slice)
+            count = slice;
+        thiz.bufferQueue.Gather(pick, input, count * frame, false);
+
+        size_t used = 0;
+        int16_t* output = (int16_t*)(thiz.convertBuffer + thiz.convertFill);
+        size_t produced = ResamplerProcess(thiz.resampler, input, count, output, (bufferSize - thiz.convertFill) / frame, &used);
+        thiz.convertFill += produced * frame;
+        pick += used * frame;
+        if (used == 0 && produced == 0)
+            break;
+    }
+    thiz.bufferQueue.StorePick(pick);
+    if (thiz.convertFill < bufferSize)
+        return 0;
+
+    span[0] = thiz.convertBuffer;
+    spanSize[0] = bufferSize;
+
+    return bufferSize;
+}
+//------------------------------------------------------------------------------
+size_t StreamCore::DequeuePeek(const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record == false)
+        return 0;
+
+    // The ring runs at the stream rate, so the device period and the speech
+    // chunks follow what a buffer of bufferSize takes from it.
+    size_t ringSize = bufferSize;
+    if (thiz.resampler)
+    {
+        size_t frame = sizeof(int16_t) * thiz.channel;
+        ringSize = size_t(uint64_t(bufferSize / frame) * thiz.sampleRate / thiz.inputRate) * frame;
+    }
+
+    if (thiz.ready == false)
+    {
+        thiz.bufferSize = ringSize;
+        thiz.ready = true;
+
+        if (thiz.start)
+            thiz.start(thiz.startContext);
+    }
+
+    uint64_t send = thiz.bufferQueue.LoadSend();
+    uint64_t pick = thiz.bufferQueue.LoadPick();
+    if (drop)
+    {
+        uint64_t available = send - pick;
+        while (available > thiz.bytesPerSecond)
+        {
+            pick += thiz.bytesPerSecond;
+            available = send - pick;
+        }
+        thiz.telemetry.Drop(pick - thiz.bufferQueue.LoadPick());
+        thiz.bufferQueue.StorePick(pick);
+    }
+    if (thiz.voiceEnable)
+    {
+        uint64_t begin = pick;
+        while (thiz.voiceCollapse && send - pick >= ringSize && StreamVoiceSpeech(thiz, pick, ringSize) == false)
+        {
+            pick += ringSize;
+        }
+        if (pick != begin)
+        {
+            thiz.voiceCollapsed += pick - begin;
+            thiz.bufferQueue.StorePick(pick);
+        }
+        thiz.voiceSpeech = StreamVoiceSpeech(thiz, pick, ringSize);
+    }
+    if (thiz.resampler)
+    {
+        return StreamDequeueConvert(thiz, span, spanSize, bufferSize);
+    }
+
+    char* ring[2];
+    size_t size = thiz.bufferQueue.Peek(bufferSize, ring, spanSize);
+    span[0] = ring[0];
+    span[1] = ring[1];
+
+    return size;
+}
+//------------------------------------------------------------------------------
+void StreamCore::DequeueRelease(size_t bufferSize)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record == false)
+        return;
+
+    // A converted buffer left the ring when it was made.
+    if (thiz.resampler)
+    {
+        if (bufferSize > thiz.convertFill)
+            bufferSize = thiz.convertFill;
+        thiz.convertFill -= bufferSize;
+        memmove(thiz.convertBuffer, thiz.convertBuffer + bufferSize, thiz.convertFill);
+        return;
+    }
+
+    thiz.bufferQueue.Release(bufferSize);
+}
+//------------------------------------------------------------------------------
+size_t StreamCore::Dequeue(void* buffer, size_t bufferSize, bool drop)
+{
+    StreamCore& thiz = (*this);
+
+    const void* span[2];
+    size_t spanSize[2];
+    if (thiz.DequeuePeek(span, spanSize, bufferSize, drop) == 0)
+        return 0;
+    memcpy(buffer, span[0], spanSize[0]);
+    if (spanSize[1])
+    {
+        memcpy((char*)buffer + spanSize[0], span[1], spanSize[1]);
+    }
+    thiz.DequeueRelease(bufferSize);
+
+    return bufferSize;
+}
+//------------------------------------------------------------------------------
+size_t StreamCore::DequeuePlanar(void* const* buffer, size_t bufferSize, bool drop)
+{
+    StreamCore& thiz = (*this);
+
+    const void* span[2];
+    size_t spanSize[2];
+    if (thiz.DequeuePeek(span, spanSize, bufferSize, drop) == 0)
+        return 0;
+    StreamDeinterleave(thiz, buffer, span, spanSize);
+    thiz.DequeueRelease(bufferSize);
+
+    return bufferSize;
+}
+//------------------------------------------------------------------------------
+void StreamCore::Period(uint64_t pick, size_t size)
+{
+    StreamCore& thiz = (*this);
+
+    uint64_t send = thiz.bufferQueue.LoadSend();
+    thiz.concealSend = send;
+    thiz.telemetry.Period(send, pick, size);
+    if (send > pick)
+    {
+        size_t silence = 0;
+        size_t missing = thiz.bufferQueue.Missing(pick, size_t(send - pick < size ? send - pick : size), &silence);
+        thiz.telemetry.Missing(missing, silence);
+    }
+    if (thiz.concealEnable)
+    {
+        StreamConceal(thiz, pick, size, send);
+    }
+}
+//------------------------------------------------------------------------------
+void StreamCore::Underrun(uint64_t index, void* output, int outputFormat, size_t samples, float scale, bool mix, WaveformMeter* meter)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.concealEnable == false)
+        return;
+
+    size_t sample = sizeWaveform(thiz.format);
+    uint64_t end = index + samples * sample;
+    uint64_t begin = thiz.concealSend > index ? thiz.concealSend : index;
+    if (begin >= end || StreamConcealBegin(thiz, begin) == false)
+        return;
+
+    float buffer[128 * WAVEFORM_CHANNEL_MAX];
+    int16_t scaled[128 * WAVEFORM_CHANNEL_MAX];
+    char* run = (char*)output + (begin - index) / sample * sizeWaveform(outputFormat);
+    size_t frame = sample * thiz.channel;
+    size_t concealed = 0;
+    while (begin < end && thiz.conceal.Faded() == false)
+    {
+        size_t count = size_t(end - begin) / frame;
+        if (count > 128)
+            count = 128;
+        size_t total = count * thiz.channel;
+        thiz.conceal.Generate(buffer, count);
+        if (mix)
+        {
+            convertWaveform(scaled, WAVEFORM_S16, buffer, WAVEFORM_F32, total, 1.0f);
+            mixWaveform((int16_t*)run, scaled, total * sizeof(int16_t), scale);
+        }
+        else if (meter)
+        {
+            convertWaveform(scaled, WAVEFORM_S16, buffer, WAVEFORM_F32, total, scale);
+            scaleWaveform(scaled, scaled, total * sizeof(int16_t), 1.0f, thiz.channel, meter);
+            convertWaveform(run, outputFormat, scaled, WAVEFORM_S16, total, 1.0f);
+        }
+        else
+        {
+            convertWaveform(run, outputFormat, buffer, WAVEFORM_F32, total, scale);
+        }
+        run += total * sizeWaveform(outputFormat);
+        begin += count * frame;
+        concealed += count * frame;
+    }
+    if (concealed)
+    {
+        thiz.telemetry.Concealed(concealed);
+    }
+}
+//------------------------------------------------------------------------------
+void StreamCore::Play(void* output, size_t outputSize)
+{
+    StreamCore& thiz = (*this);
+    size_t samples = outputSize / sizeWaveform(thiz.deviceFormat);
+    size_t frames = samples / thiz.deviceChannel;
+
+    WaveformMeter meter = {};
+    if (thiz.remix)
+    {
+        StreamPlayRemix(thiz, output, frames, thiz.meterEnable ? &meter : nullptr);
+    }
+    else if (thiz.mixer && thiz.deviceFormat == WAVEFORM_S16)
+    {
+        MixerRender(thiz.mixer, output, outputSize, thiz.volume);
+        if (thiz.meterEnable)
+            scaleWaveform((int16_t*)output, (int16_t*)output, outputSize, 1.0f, thiz.channel, &meter);
+    }
+    else if (thiz.mixer)
+    {
+        // The mixer sums in 16 bits, so widen its output a slice of whole
+        // frames at a time.
+        int16_t mix[2048];
+        size_t slice = 2048 - 2048 % thiz.channel;
+        for (size_t i = 0; i < samples; i += slice)
+        {
+            size_t count = samples - i < slice ? samples - i : slice;
+            MixerRender(thiz.mixer, mix, count * sizeof(int16_t), thiz.volume);
+            if (thiz.meterEnable)
+                scaleWaveform(mix, mix, count * sizeof(int16_t), 1.0f, thiz.channel, &meter);
+            convertWaveform((char*)output + i * sizeWaveform(thiz.deviceFormat), thiz.deviceFormat, mix, WAVEFORM_S16, count, 1.0f);
+        }
+    }
+    else if (thiz.go)
+    {
+        uint64_t pick = thiz.bufferQueue.LoadPick();
+        uint64_t begin = pick;
+        thiz.Period(pick, samples * sizeWaveform(thiz.format));
+        if (thiz.meterEnable && thiz.deviceFormat == WAVEFORM_S16)
+        {
+            pick += thiz.bufferQueue.GatherMeter(pick, output, outputSize, thiz.volume, thiz.channel, &meter);
+        }
+        else if (thiz.meterEnable)
+        {
+            // The meter runs on 16-bit samples, so the ring comes out through
+            // a slice of whole frames and is widened from there.
+            int16_t mix[2048];
+            size_t slice = 2048 - 2048 % thiz.channel;
+            for (size_t i = 0; i < samples; i += slice)
+            {
+                size_t count = samples - i < slice ? samples - i : slice;
+                pick += thiz.bufferQueue.GatherMeter(pick, mix, count * sizeof(int16_t), thiz.volume, thiz.channel, &meter);
+                convertWaveform((char*)output + i * sizeWaveform(thiz.deviceFormat), thiz.deviceFormat, mix, WAVEFORM_S16, count, 1.0f);
+            }
+        }
+        else
+        {
+            pick += thiz.bufferQueue.GatherConverted(pick, thiz.format, output, thiz.deviceFormat, samples, thiz.volume);
+        }
+        thiz.Underrun(begin, output, thiz.deviceFormat, samples, thiz.volume, false, thiz.meterEnable ? &meter : nullptr);
+        thiz.bufferQueue.StorePick(pick);
+    }
+    else
+    {
+        memset(output, 0, outputSize);
+    }
+    if (thiz.meterEnable)
+    {
+        meter.samples = frames * thiz.channel;
+        thiz.telemetry.Meter(meter, thiz.channel, frames * 1000000 / thiz.sampleRate);
+    }
+}
+//------------------------------------------------------------------------------
+void StreamCore::Record(const void* input, size_t inputSize)
+{
+    StreamCore& thiz = (*this);
+    size_t frames = inputSize / (sizeWaveform(thiz.deviceFormat) * thiz.deviceChannel);
+    size_t samples = frames * thiz.channel;
+
+    uint64_t send = thiz.bufferQueue.LoadSend();
+    uint64_t pick = thiz.bufferQueue.LoadPick();
+    thiz.telemetry.Period(send, pick, 0);
+    thiz.telemetry.Write(send, pick, samples * sizeWaveform(thiz.format), thiz.bufferQueue.bufferSize);
+    uint64_t begin = send;
+    WaveformActivity activity = {};
+    WaveformMeter meter = {};
+    if (thiz.remix)
+    {
+        send = StreamRecordRemix(thiz, send, input, frames);
+    }
+    else if (thiz.voiceEnable && thiz.deviceFormat == WAVEFORM_S16)
+    {
+        send += thiz.bufferQueue.ScatterActivity(send, input, samples * sizeof(int16_t), thiz.volume, thiz.channel, &activity);
+    }
+    else if (thiz.meterEnable && thiz.deviceFormat == WAVEFORM_S16)
+    {
+        send += thiz.bufferQueue.ScatterMeter(send, input, samples * sizeof(int16_t), thiz.volume, thiz.channel, &meter);
+    }
+    else
+    {
+        send += thiz.bufferQueue.ScatterConverted(send, thiz.format, input, thiz.deviceFormat, samples, thiz.volume);
+    }
+    if (thiz.voiceEnable)
+    {
+        if (activity.samples == 0)
+            StreamVoiceMeasure(thiz, begin, size_t(send - begin), &activity);
+        StreamVoiceMark(thiz, begin, send, thiz.voice.Update(activity));
+    }
+    if (thiz.meterEnable)
+    {
+        if (meter.samples == 0)
+            StreamMeter(thiz, begin, size_t(send - begin), 1.0f, &meter);
+        thiz.telemetry.Meter(meter, thiz.channel, frames * 1000000 / thiz.sampleRate);
+    }
+    thiz.bufferQueue.StoreSend(send);
+}
+//------------------------------------------------------------------------------
+bool StreamCore::Attach(struct Mixer* mixer, size_t limit)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record)
+        return false;
+
+    if (mixer == nullptr)
+    {
+        thiz.Reset();
+        thiz.mixer = nullptr;
+        return true;
+    }
+
+    int channel = 0;
+    int sampleRate = 0;
+    MixerFormat(mixer, &channel, &sampleRate);
+    if (channel != (int)thiz.channel || sampleRate != (int)thiz.sampleRate)
+        return false;
+
+    // limit is in device bytes, the period is kept in ring bytes.
+    size_t frame = sizeWaveform(thiz.format) * thiz.channel;
+    size_t bufferSize = thiz.bytesPerSecond / 100;
+    if (limit && thiz.DeviceSize(bufferSize) > limit)
+        bufferSize = limit / (sizeWaveform(thiz.deviceFormat) * thiz.deviceChannel) * frame;
+    bufferSize -= bufferSize % frame;
+
+    thiz.mixer = mixer;
+    thiz.bufferSize = bufferSize;
+
+    if (thiz.ready == false)
+    {
+        thiz.ready = true;
+
+        if (thiz.start)
+            thiz.start(thiz.startContext);
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::Convert(int inputRate)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.format != WAVEFORM_S16)
+        return inputRate == 0 || inputRate == (int)thiz.sampleRate;
+
+    ResamplerDestroy(thiz.resampler);
+    thiz.resampler = nullptr;
+    thiz.inputRate = 0;
+    thiz.convertFill = 0;
+
+    if (inputRate == 0 || inputRate == (int)thiz.sampleRate)
+    {
+        if (thiz.driftEnable)
+            return thiz.EnableDrift(true);
+        return true;
+    }
+
+    // A recorder converts the other way, from the ring to the caller.
+    if (thiz.record)
+        thiz.resampler = ResamplerCreate(thiz.channel, thiz.sampleRate, inputRate);
+    else
+        thiz.resampler = ResamplerCreate(thiz.channel, inputRate, thiz.sampleRate);
+    if (thiz.resampler == nullptr)
+        return false;
+    thiz.inputRate = inputRate;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::EnableDrift(bool enable)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record)
+        return false;
+
+    if (thiz.format != WAVEFORM_S16)
+        return enable == false;
+
+    // A resampler that only carries the trim goes away with it.
+    if (enable == false)
+    {
+        thiz.driftEnable = false;
+        ResamplerDrift(thiz.resampler, 0);
+        if (thiz.inputRate == 0)
+        {
+            ResamplerDestroy(thiz.resampler);
+            thiz.resampler = nullptr;
+        }
+        return true;
+    }
+
+    if (thiz.resampler == nullptr)
+    {
+        thiz.resampler = ResamplerCreate(thiz.channel, thiz.sampleRate, thiz.sampleRate);
+        if (thiz.resampler == nullptr)
+            return false;
+    }
+    ResamplerDrift(thiz.resampler, 0);
+    thiz.drift.Startup(thiz.bytesPerSecond, RESAMPLER_DRIFT_MAX);
+    thiz.driftEnable = true;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::EnableConceal(bool enable)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record)
+        return false;
+
+    thiz.concealEnable = false;
+    if (enable == false)
+        return true;
+    if (thiz.conceal.Startup(thiz.channel, thiz.sampleRate) == false)
+        return false;
+    thiz.concealEnable = true;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::EnablePlayout(bool enable)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record)
+        return false;
+
+    thiz.playout.Startup();
+    thiz.playoutEnable = enable;
+    if (enable == false)
+    {
+        thiz.telemetry.Playout(0, 0);
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::EnableVoice(bool enable, bool collapse)
+{
+    StreamCore& thiz = (*this);
+    if (thiz.record == false)
+        return false;
+
+    if (thiz.format != WAVEFORM_S16)
+        return enable == false;
+
+    thiz.voiceEnable = false;
+    thiz.voiceCollapse = false;
+    thiz.voiceSpeech = false;
+    thiz.voiceCollapsed = 0;
+    if (enable == false)
+        return true;
+
+    size_t blocks = thiz.bufferQueue.bufferSize >> RingBuffer::BLOCK_SHIFT;
+    if (thiz.voiceMap == nullptr || thiz.voiceBlocks != blocks)
+    {
+        delete[] thiz.voiceMap;
+        thiz.voiceMap = new (std::nothrow) std::atomic<uint8_t>[blocks]();
+        thiz.voiceBlocks = thiz.voiceMap ? blocks : 0;
+        if (thiz.voiceMap == nullptr)
+            return false;
+    }
+    thiz.voice.Startup(thiz.channel, thiz.sampleRate);
+    thiz.voiceEnable = true;
+    thiz.voiceCollapse = collapse;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::EnableMeter(bool enable)
+{
+    StreamCore& thiz = (*this);
+
+    if (thiz.format != WAVEFORM_S16 || thiz.channel > WAVEFORM_CHANNEL_MAX)
+        return enable == false;
+
+    thiz.meterEnable = enable;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool StreamCore::Speech(uint64_t* collapsed)
+{
+    StreamCore& thiz = (*this);
+
+    if (collapsed)
+    {
+        (*collapsed) = thiz.voiceCollapsed;
+        thiz.voiceCollapsed = 0;
+    }
+
+    return thiz.voiceEnable == false || thiz.voiceSpeech;
+}
+//------------------------------------------------------------------------------
+void StreamCore::Reset()
+{
+    StreamCore& thiz = (*this);
+
+    thiz.ready = false;
+    thiz.go = false;
+
+    ResamplerReset(thiz.resampler);
+    ResamplerDrift(thiz.resampler, 0);
+    thiz.convertFill = 0;
+    thiz.drift.Reset();
+    thiz.conceal.Reset();
+    thiz.playout.Reset();
+    thiz.voice.Reset();
+}
+//------------------------------------------------------------------------------
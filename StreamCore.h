@@ -0,0 +1,207 @@
+//==============================================================================
+// Stream Core
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "Conceal.h"
+#include "Drift.h"
+#include "Playout.h"
+#include "RingBuffer.h"
+#include "Telemetry.h"
+#include "Voice.h"
+#include "Waveform.h"
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//------------------------------------------------------------------------------
+// One entry of a batch for QueueBatch
+//------------------------------------------------------------------------------
+struct StreamPacket
+{
+    uint64_t timestamp;
+    const void* buffer;
+    size_t bufferSize;
+};
+//------------------------------------------------------------------------------
+// Platform independent part of a stream
+//
+// Owns the ring, both cursors and the timing rules every backend shares:
+// timestamp to byte position, the resync rule, gap pre-roll, the ready / go
+// state machine, the Dequeue drop loop, drift trim and telemetry. A backend
+// is left with a driver that calls Play or Record once per device period and
+// starts its device from the start callback, which runs on the Queue or
+// Dequeue thread the first time the stream becomes ready.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT StreamCore
+{
+    StreamCore();
+    ~StreamCore();
+
+    bool Startup(int channel, int sampleRate, int secondPerBuffer, bool record, int format, void (*start)(void* context), void* context);
+
+    // The ring holds samples in format, the one Queue and Dequeue speak. A
+    // backend that opens its device in another format sets deviceFormat, and
+    // Play or Record convert on the way through.
+    size_t DeviceSize(size_t size) const;
+
+    // Producer side
+    size_t QueueReserve(uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2]);
+    uint64_t QueueCommit(uint64_t now, uint64_t timestamp, int gap);
+    uint64_t Queue(uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+
+    // One plane per channel, interleaved in the same pass as the ring copy.
+    // bufferSize counts every plane together, as in Queue.
+    uint64_t QueuePlanar(uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+
+    // Packets that arrived together, placed back to back as consecutive Queue
+    // calls would place them, then published with one commit. Returns the
+    // playout position once, like Queue.
+    uint64_t QueueBatch(uint64_t now, int64_t adjust, const StreamPacket* packet, size_t count, int gap);
+
+    // A silent packet, as from discontinuous transmission, placed like Queue
+    // but recorded in the block map without writing its samples.
+    uint64_t QueueSilence(uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+
+    // Consumer side
+    size_t DequeuePeek(const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop);
+    void DequeueRelease(size_t bufferSize);
+    size_t Dequeue(void* buffer, size_t bufferSize, bool drop);
+
+    // Split into one plane per channel in the same pass as the ring copy.
+    size_t DequeuePlanar(void* const* buffer, size_t bufferSize, bool drop);
+
+    // The ring holds the speakers of channelMask, the default for the channel
+    // count unless Layout says otherwise. A backend that opens its device
+    // with other channels names their speakers in device order through
+    // DeviceLayout, mask order when speaker is null. Play and Record then run
+    // every frame through a matrix, the default downmix or upmix of
+    // matrixWaveform unless Matrix gives one in mask order on both sides.
+    // Like Convert, these belong before the stream starts.
+    bool Layout(uint32_t channelMask);
+    bool DeviceLayout(int deviceChannel, const uint32_t* speaker);
+    bool Matrix(const float* matrix);
+
+    // Step the device down once, multichannel to stereo and then float to 16
+    // bits, for a backend whose device refused the current one.
+    bool DeviceFallback();
+
+    // Device side, once per period, sizes in deviceFormat and deviceChannel
+    void Play(void* output, size_t outputSize);
+    void Record(const void* input, size_t inputSize);
+
+    // Account a period of size ring bytes played from pick: the fill level,
+    // and the blocks behind send that arrived silent or never arrived. With
+    // concealment on, the blocks behind send that never arrived are then
+    // filled in.
+    void Period(uint64_t pick, size_t size);
+
+    // After Period, conceal the part of samples read from index that lies
+    // past send into output, as outputFormat scaled by scale. It is written
+    // over what the ring gave there, or with mix added to 16-bit output,
+    // and metered into meter when given. Does nothing without concealment.
+    void Underrun(uint64_t index, void* output, int outputFormat, size_t samples, float scale, bool mix, struct WaveformMeter* meter);
+
+    // A mixer renders into Play instead of the ring, in periods of 10 ms
+    // capped at limit bytes.
+    bool Attach(struct Mixer* mixer, size_t limit);
+
+    // Queue takes buffers at inputRate and converts them to the stream rate.
+    // A recorder turns it around: Dequeue hands out buffers at inputRate,
+    // converted from the ring on the way out and held until a whole buffer is
+    // there. The resampler runs on 16-bit samples only.
+    bool Convert(int inputRate);
+
+    // Trim the ratio to hold the ring at the level it settled at, 16-bit only.
+    bool EnableDrift(bool enable);
+
+    // Fill blocks that never arrived by repeating the last pitch period, so
+    // a lost packet plays as a short fade instead of a hole.
+    bool EnableConceal(bool enable);
+
+    // Follow the arrival jitter of Queue with the playout delay instead of
+    // holding the gap pre-roll. The delay grows at once by skipping ahead of
+    // a packet that found less than half of it, and otherwise moves only in
+    // QueueSilence packets, which stretch or give up to half of themselves.
+    // The gap still sets the pre-roll of the first start.
+    bool EnablePlayout(bool enable);
+
+    // Detect speech in what Record captures, 16-bit only. The activity comes
+    // from the capture gain pass when the device is 16-bit too, and from a
+    // pass over the ring otherwise. With collapse, DequeuePeek skips whole
+    // bufferSize chunks without speech while there is more to read. Like
+    // Convert, this belongs before the stream starts.
+    bool EnableVoice(bool enable, bool collapse);
+
+    // Whether the chunk of the last DequeuePeek holds speech, true with the
+    // detector off. collapsed takes the bytes skipped since the last call.
+    bool Speech(uint64_t* collapsed);
+
+    // Meter the peak and RMS of each channel into telemetry once per period,
+    // 16-bit only. Levels are taken after volume, in the gain pass of Play or
+    // Record when the device is 16-bit too and from the ring otherwise.
+    bool EnableMeter(bool enable);
+    void Reset();
+
+    RingQueue bufferQueue;
+    int64_t bufferQueueSendAdjust;
+    int64_t bufferQueuePickAdjust;
+
+    struct Resampler* resampler;
+    uint32_t inputRate;
+    char* convertBuffer;
+    size_t convertCapacity;
+    size_t convertFill;
+    Drift drift;
+    bool driftEnable;
+    Conceal conceal;
+    bool concealEnable;
+    uint64_t concealSend;
+    Playout playout;
+    bool playoutEnable;
+    Voice voice;
+    bool voiceEnable;
+    bool voiceCollapse;
+    std::atomic<uint8_t>* voiceMap;
+    size_t voiceBlocks;
+    bool voiceSpeech;
+    uint64_t voiceCollapsed;
+    bool meterEnable;
+    Telemetry telemetry;
+
+    struct Mixer* mixer;
+
+    uint32_t channel;
+    uint32_t sampleRate;
+    uint32_t bytesPerSecond;
+    uint32_t format;
+    uint32_t deviceFormat;
+
+    uint32_t channelMask;
+    uint32_t deviceChannel;
+    uint32_t deviceMask;
+    uint8_t deviceOrder[WAVEFORM_CHANNEL_MAX];
+    float matrixCustom[WAVEFORM_CHANNEL_MAX * WAVEFORM_CHANNEL_MAX];
+    float matrix[WAVEFORM_CHANNEL_MAX * WAVEFORM_CHANNEL_MAX];
+    bool custom;
+    std::atomic<bool> remix;
+
+    std::atomic<float> volume;
+    std::atomic<bool> ready;
+    std::atomic<bool> go;
+    bool record;
+
+    // Period of the device in ring bytes, the first buffer size seen by Queue
+    // or Dequeue unless a mixer is attached.
+    std::atomic<size_t> bufferSize;
+
+    void (*start)(void* context);
+    void* startContext;
+};
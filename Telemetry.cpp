@@ -0,0 +1,191 @@
+//==============================================================================
+// Telemetry
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include "Telemetry.h"
+
+//------------------------------------------------------------------------------
+template<typename T>
+static inline void TelemetryAdd(std::atomic<T>& counter, T value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+static inline int TelemetryBucket(uint64_t microsecond)
+{
+    uint64_t millisecond = microsecond / 1000;
+    int bucket = 0;
+    while (millisecond && bucket < TELEMETRY_BUCKETS - 1)
+    {
+        millisecond >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+//==============================================================================
+// Telemetry
+//==============================================================================
+Telemetry::Telemetry() : bytesPerSecond(0), callbacks(0), underrunBytes(0), missingBytes(0), silenceBytes(0), concealBytes(0), fill(), meterFrames(0), meterEnergy(), meterPeak(), overwriteBytes(0), resyncs(0), packets(0), offsetMin(INT64_MAX), offsetMax(INT64_MIN), playoutTarget(0), playoutJitter(0), early(), late(), dropBytes(0)
+{
+}
+//------------------------------------------------------------------------------
+void Telemetry::Startup(uint32_t bytesPerSecond)
+{
+    Telemetry& thiz = (*this);
+
+    thiz.bytesPerSecond = bytesPerSecond;
+}
+//------------------------------------------------------------------------------
+void Telemetry::Period(uint64_t send, uint64_t pick, size_t size)
+{
+    Telemetry& thiz = (*this);
+    if (thiz.bytesPerSecond == 0)
+        return;
+
+    uint64_t level = send > pick ? send - pick : 0;
+    TelemetryAdd<uint64_t>(thiz.callbacks, 1);
+    TelemetryAdd<uint64_t>(thiz.fill[TelemetryBucket(level * 1000000 / thiz.bytesPerSecond)], 1);
+    if (level < size)
+    {
+        TelemetryAdd<uint64_t>(thiz.underrunBytes, size - level);
+    }
+}
+//------------------------------------------------------------------------------
+void Telemetry::Missing(size_t missing, size_t silence)
+{
+    Telemetry& thiz = (*this);
+
+    if (missing)
+    {
+        TelemetryAdd<uint64_t>(thiz.missingBytes, missing);
+    }
+    if (silence)
+    {
+        TelemetryAdd<uint64_t>(thiz.silenceBytes, silence);
+    }
+}
+//------------------------------------------------------------------------------
+void Telemetry::Concealed(size_t size)
+{
+    Telemetry& thiz = (*this);
+
+    if (size)
+    {
+        TelemetryAdd<uint64_t>(thiz.concealBytes, size);
+    }
+}
+//------------------------------------------------------------------------------
+void Telemetry::Meter(const WaveformMeter& meter, size_t channels, uint64_t duration)
+{
+    Telemetry& thiz = (*this);
+    if (channels == 0 || channels > WAVEFORM_CHANNEL_MAX)
+        return;
+
+    double fall = pow(10.0, -TELEMETRY_PEAK_FALL * double(duration) / 20000000.0);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        uint32_t peak = uint32_t(thiz.meterPeak[c].load(std::memory_order_relaxed) * fall);
+        if (peak < meter.peak[c])
+            peak = meter.peak[c];
+        thiz.meterPeak[c].store(peak, std::memory_order_relaxed);
+        TelemetryAdd<uint64_t>(thiz.meterEnergy[c], meter.energy[c]);
+    }
+    TelemetryAdd<uint64_t>(thiz.meterFrames, meter.samples / channels);
+}
+//------------------------------------------------------------------------------
+void Telemetry::Write(uint64_t send, uint64_t pick, size_t size, size_t capacity)
+{
+    Telemetry& thiz = (*this);
+
+    if (send + size > pick + capacity)
+    {
+        uint64_t overwrite = send + size - (pick + capacity);
+        TelemetryAdd<uint64_t>(thiz.overwriteBytes, overwrite < size ? overwrite : size);
+    }
+}
+//------------------------------------------------------------------------------
+void Telemetry::Packet(uint64_t send, uint64_t pick)
+{
+    Telemetry& thiz = (*this);
+    if (thiz.bytesPerSecond == 0)
+        return;
+
+    int64_t offset = int64_t(send - pick) * 1000000 / int64_t(thiz.bytesPerSecond);
+    TelemetryAdd<uint64_t>(thiz.packets, 1);
+    if (offset >= 0)
+    {
+        TelemetryAdd<uint64_t>(thiz.early[TelemetryBucket(offset)], 1);
+    }
+    else
+    {
+        TelemetryAdd<uint64_t>(thiz.late[TelemetryBucket(-offset)], 1);
+    }
+    if (thiz.offsetMin.load(std::memory_order_relaxed) > offset)
+        thiz.offsetMin.store(offset, std::memory_order_relaxed);
+    if (thiz.offsetMax.load(std::memory_order_relaxed) < offset)
+        thiz.offsetMax.store(offset, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+void Telemetry::Resync()
+{
+    Telemetry& thiz = (*this);
+
+    TelemetryAdd<uint64_t>(thiz.resyncs, 1);
+}
+//------------------------------------------------------------------------------
+void Telemetry::Playout(uint64_t target, uint64_t jitter)
+{
+    Telemetry& thiz = (*this);
+
+    thiz.playoutTarget.store(target, std::memory_order_relaxed);
+    thiz.playoutJitter.store(jitter, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+void Telemetry::Drop(uint64_t size)
+{
+    Telemetry& thiz = (*this);
+
+    TelemetryAdd<uint64_t>(thiz.dropBytes, size);
+}
+//------------------------------------------------------------------------------
+void Telemetry::Read(TelemetrySnapshot* snapshot) const
+{
+    const Telemetry& thiz = (*this);
+    if (snapshot == nullptr)
+        return;
+
+    snapshot->callbacks = thiz.callbacks.load(std::memory_order_relaxed);
+    snapshot->underrunBytes = thiz.underrunBytes.load(std::memory_order_relaxed);
+    snapshot->missingBytes = thiz.missingBytes.load(std::memory_order_relaxed);
+    snapshot->silenceBytes = thiz.silenceBytes.load(std::memory_order_relaxed);
+    snapshot->concealBytes = thiz.concealBytes.load(std::memory_order_relaxed);
+    snapshot->overwriteBytes = thiz.overwriteBytes.load(std::memory_order_relaxed);
+    snapshot->resyncs = thiz.resyncs.load(std::memory_order_relaxed);
+    snapshot->dropBytes = thiz.dropBytes.load(std::memory_order_relaxed);
+    snapshot->packets = thiz.packets.load(std::memory_order_relaxed);
+    snapshot->offsetMin = thiz.offsetMin.load(std::memory_order_relaxed);
+    snapshot->offsetMax = thiz.offsetMax.load(std::memory_order_relaxed);
+    snapshot->playoutTarget = thiz.playoutTarget.load(std::memory_order_relaxed);
+    snapshot->playoutJitter = thiz.playoutJitter.load(std::memory_order_relaxed);
+    if (snapshot->packets == 0)
+    {
+        snapshot->offsetMin = 0;
+        snapshot->offsetMax = 0;
+    }
+    snapshot->meterFrames = thiz.meterFrames.load(std::memory_order_relaxed);
+    for (int i = 0; i < WAVEFORM_CHANNEL_MAX; ++i)
+    {
+        snapshot->meterEnergy[i] = thiz.meterEnergy[i].load(std::memory_order_relaxed);
+        snapshot->meterPeak[i] = thiz.meterPeak[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < TELEMETRY_BUCKETS; ++i)
+    {
+        snapshot->fill[i] = thiz.fill[i].load(std::memory_order_relaxed);
+        snapshot->early[i] = thiz.early[i].load(std::memory_order_relaxed);
+        snapshot->late[i] = thiz.late[i].load(std::memory_order_relaxed);
+    }
+}
+//------------------------------------------------------------------------------
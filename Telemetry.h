@@ -0,0 +1,109 @@
+//==============================================================================
+// Telemetry
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "RingBuffer.h"
+#include "Waveform.h"
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+// Histogram bucket 0 counts under 1 ms, bucket i counts [2^(i-1), 2^i) ms
+// and the last bucket is open-ended.
+#define TELEMETRY_BUCKETS 16
+
+// Decibels per second a held peak falls by, as on a peak programme meter.
+#define TELEMETRY_PEAK_FALL 20
+
+//------------------------------------------------------------------------------
+// Counters are totals since the stream was created. Poll and subtract two
+// snapshots to get rates.
+//------------------------------------------------------------------------------
+struct TelemetrySnapshot
+{
+    uint64_t callbacks;         // device periods
+    uint64_t underrunBytes;     // bytes a period wanted beyond send
+    uint64_t missingBytes;      // bytes a period played behind send that no packet wrote
+    uint64_t silenceBytes;      // bytes a period played from silent regions
+    uint64_t concealBytes;      // bytes concealment filled in
+    uint64_t overwriteBytes;    // unread bytes a write landed on
+    uint64_t resyncs;           // hard resyncs of send in Queue
+    uint64_t dropBytes;         // bytes skipped by drop in Dequeue
+    uint64_t packets;           // buffers given to Queue
+    int64_t offsetMin;          // microseconds of send ahead of pick
+    int64_t offsetMax;
+    uint64_t playoutTarget;     // microseconds of adaptive playout delay, 0 when off
+    uint64_t playoutJitter;     // microseconds of arrival jitter it follows
+    uint64_t meterFrames;       // frames metered, 0 when metering is off
+    uint64_t meterEnergy[WAVEFORM_CHANNEL_MAX]; // sum of squares per channel, wraps around
+    uint32_t meterPeak[WAVEFORM_CHANNEL_MAX];   // held peak per channel, full scale 32768
+    uint64_t fill[TELEMETRY_BUCKETS];   // send - pick at each period
+    uint64_t early[TELEMETRY_BUCKETS];  // send ahead of pick at Queue
+    uint64_t late[TELEMETRY_BUCKETS];   // send behind pick at Queue
+};
+
+//------------------------------------------------------------------------------
+// Every counter has a single writer, either the device side or the Queue /
+// Dequeue side, so updates are plain relaxed stores that never lock or
+// allocate. Read may run on any thread; each value is consistent on its own,
+// but the snapshot as a whole is not taken atomically.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT Telemetry
+{
+    Telemetry();
+
+    void Startup(uint32_t bytesPerSecond);
+
+    // Device side
+    void Period(uint64_t send, uint64_t pick, size_t size);
+    void Missing(size_t missing, size_t silence);
+    void Concealed(size_t size);
+
+    // Levels of a period of duration microseconds, as played or captured.
+    // The RMS of a channel between two snapshots is the square root of its
+    // meterEnergy over meterFrames, both differences.
+    void Meter(const WaveformMeter& meter, size_t channels, uint64_t duration);
+
+    // Producer side
+    void Write(uint64_t send, uint64_t pick, size_t size, size_t capacity);
+    void Packet(uint64_t send, uint64_t pick);
+    void Resync();
+    void Playout(uint64_t target, uint64_t jitter);
+
+    // Consumer side
+    void Drop(uint64_t size);
+
+    void Read(TelemetrySnapshot* snapshot) const;
+
+    uint32_t bytesPerSecond;
+
+    alignas(STREAMAL_CACHELINE) std::atomic<uint64_t> callbacks;
+    std::atomic<uint64_t> underrunBytes;
+    std::atomic<uint64_t> missingBytes;
+    std::atomic<uint64_t> silenceBytes;
+    std::atomic<uint64_t> concealBytes;
+    std::atomic<uint64_t> fill[TELEMETRY_BUCKETS];
+    std::atomic<uint64_t> meterFrames;
+    std::atomic<uint64_t> meterEnergy[WAVEFORM_CHANNEL_MAX];
+    std::atomic<uint32_t> meterPeak[WAVEFORM_CHANNEL_MAX];
+
+    alignas(STREAMAL_CACHELINE) std::atomic<uint64_t> overwriteBytes;
+    std::atomic<uint64_t> resyncs;
+    std::atomic<uint64_t> packets;
+    std::atomic<int64_t> offsetMin;
+    std::atomic<int64_t> offsetMax;
+    std::atomic<uint64_t> playoutTarget;
+    std::atomic<uint64_t> playoutJitter;
+    std::atomic<uint64_t> early[TELEMETRY_BUCKETS];
+    std::atomic<uint64_t> late[TELEMETRY_BUCKETS];
+
+    alignas(STREAMAL_CACHELINE) std::atomic<uint64_t> dropBytes;
+};
@@ -0,0 +1,80 @@
+//==============================================================================
+// Voice
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include "Voice.h"
+
+//==============================================================================
+// Voice
+//==============================================================================
+static double VoiceRatio(int decibel)
+{
+    return pow(10.0, decibel / 10.0);
+}
+//------------------------------------------------------------------------------
+Voice::Voice() : channel(0), sampleRate(0), floor(0.0), hold(0), speech(false)
+{
+}
+//------------------------------------------------------------------------------
+void Voice::Startup(int channel, int sampleRate)
+{
+    Voice& thiz = (*this);
+
+    thiz.channel = channel;
+    thiz.sampleRate = sampleRate;
+    thiz.Reset();
+}
+//------------------------------------------------------------------------------
+void Voice::Reset()
+{
+    Voice& thiz = (*this);
+
+    thiz.floor = 0.0;
+    thiz.hold = 0;
+    thiz.speech = false;
+}
+//------------------------------------------------------------------------------
+bool Voice::Update(const WaveformActivity& activity)
+{
+    Voice& thiz = (*this);
+    if (thiz.channel == 0 || thiz.sampleRate == 0 || activity.samples == 0)
+        return thiz.speech;
+
+    uint64_t frames = activity.samples / thiz.channel;
+    double elapsed = double(frames) / thiz.sampleRate;
+    double power = double(activity.energy) / activity.samples;
+    double crossings = double(activity.crossings) / thiz.channel / elapsed;
+
+    // Digital silence would pin the floor at zero, so it stays at least one
+    // step squared.
+    if (power < 1.0)
+        power = 1.0;
+    if (thiz.floor == 0.0 || power < thiz.floor)
+        thiz.floor = power;
+    else
+        thiz.floor *= pow(10.0, VOICE_RISE * elapsed / 10.0);
+
+    static const double quiet = 32768.0 * 32768.0 * VoiceRatio(VOICE_QUIET);
+    bool active = false;
+    if (power > quiet)
+    {
+        double ratio = power / thiz.floor;
+        if (ratio > VoiceRatio(VOICE_VOICED))
+            active = true;
+        if (ratio > VoiceRatio(VOICE_UNVOICED) && crossings > VOICE_FRICATIVE)
+            active = true;
+    }
+
+    uint64_t duration = frames * 1000000 / thiz.sampleRate;
+    if (active)
+        thiz.hold = VOICE_HANG;
+    else
+        thiz.hold = thiz.hold > duration ? thiz.hold - duration : 0;
+    thiz.speech = active || thiz.hold > 0;
+
+    return thiz.speech;
+}
+//------------------------------------------------------------------------------
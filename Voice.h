@@ -0,0 +1,52 @@
+//==============================================================================
+// Voice
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Waveform.h"
+
+#ifndef STREAMAL_EXPORT
+#define STREAMAL_EXPORT
+#endif
+
+//------------------------------------------------------------------------------
+// Voice activity detector
+//
+// Takes the activity of each captured period, as the scaleActivity kernel
+// measures it. The noise floor is the mean square of the quiet periods: it
+// drops to a quieter period at once and rises by VOICE_RISE dB per second
+// otherwise. A period is speech when it stands VOICE_VOICED dB above the
+// floor, or VOICE_UNVOICED dB with the crossing rate of a fricative, and is
+// louder than VOICE_QUIET dBFS. Speech holds for VOICE_HANG microseconds
+// after the last such period, so word endings stay with their words.
+//------------------------------------------------------------------------------
+struct STREAMAL_EXPORT Voice
+{
+    Voice();
+
+    enum
+    {
+        VOICE_RISE = 1,
+        VOICE_VOICED = 9,
+        VOICE_UNVOICED = 5,
+        VOICE_QUIET = -60,
+        VOICE_FRICATIVE = 3000,
+        VOICE_HANG = 250000,
+    };
+
+    void Startup(int channel, int sampleRate);
+    void Reset();
+    bool Update(const WaveformActivity& activity);
+
+    uint32_t channel;
+    uint32_t sampleRate;
+
+    double floor;
+    uint64_t hold;
+    bool speech;
+};
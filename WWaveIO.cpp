@@ -10,40 +10,28 @@
 #pragma comment(lib, "winmm.lib")
 #include <windows.h>
 #include <mmeapi.h>
-#include "RingBuffer.h"
+#include <mmreg.h>
+#include "StreamCore.h"
 #include "Waveform.h"
+#include "Mixer.h"
 #include "WWaveIO.h"
 
 //------------------------------------------------------------------------------
 struct WWaveIO
 {
-    WAVEFORMATEX waveFormat;
+    WAVEFORMATEXTENSIBLE waveFormat;
     HWAVEIN waveIn;
     HWAVEOUT waveOut;
     WAVEHDR waveHeader[8];
     int waveHeaderIndex;
 
-    RingBuffer bufferQueue;
-    uint64_t bufferQueueSend;
-    uint64_t bufferQueuePick;
-    int64_t bufferQueueSendAdjust;
-    int64_t bufferQueuePickAdjust;
-
-    uint32_t channel;
-    uint32_t sampleRate;
-    uint32_t bytesPerSecond;
-
-    float volume;
+    StreamCore core;
 
     bool cancel;
-    bool ready;
-    bool go;
-    bool record;
 
     HANDLE thread;
     HANDLE semaphore;
 
-    int bufferSize;
     short temp[8192];
 };
 //------------------------------------------------------------------------------
@@ -53,32 +41,89 @@ static DWORD WINAPI WWaveOutThread(LPVOID arg)
 
     if (thiz.cancel == false)
     {
-        waveOutOpen(&thiz.waveOut, WAVE_MAPPER, &thiz.waveFormat, 0, 0, CALLBACK_NULL);
+        waveOutOpen(&thiz.waveOut, WAVE_MAPPER, &thiz.waveFormat.Format, 0, 0, CALLBACK_NULL);
     }
 
     while (thiz.waveOut)
     {
         if (thiz.cancel)
             break;
-        WaitForSingleObject(thiz.semaphore, INFINITE);
+        bool render = (thiz.core.mixer || thiz.core.remix || thiz.core.deviceFormat != thiz.core.format);
+        WaitForSingleObject(thiz.semaphore, render ? 5 : INFINITE);
         if (thiz.cancel)
             break;
 
-        size_t outputSize = thiz.bufferSize;
+        // The mixer owns the device clock, and a ring in another format or
+        // layout than the device cannot be handed over as is, so refill the
+        // first headers from temp whenever the driver hands one back.
+        if (render)
+        {
+            size_t outputSize = thiz.core.DeviceSize(thiz.core.bufferSize);
+            if (outputSize > sizeof(thiz.temp) / 4)
+                outputSize = sizeof(thiz.temp) / 4;
+            outputSize -= outputSize % thiz.waveFormat.Format.nBlockAlign;
+            for (int i = 0; i < 4; ++i)
+            {
+                WAVEHDR& header = thiz.waveHeader[i];
+                if ((header.dwFlags & WHDR_PREPARED) && (header.dwFlags & WHDR_DONE) == 0)
+                    continue;
+
+                char* output = (char*)thiz.temp + i * outputSize;
+                thiz.core.Play(output, outputSize);
+
+                if (header.dwFlags & WHDR_PREPARED)
+                    waveOutUnprepareHeader(thiz.waveOut, &header, sizeof(WAVEHDR));
+                header.lpData = (LPSTR)output;
+                header.dwBufferLength = outputSize;
+                header.dwFlags = 0;
+                waveOutPrepareHeader(thiz.waveOut, &header, sizeof(WAVEHDR));
+                waveOutWrite(thiz.waveOut, &header, sizeof(WAVEHDR));
+            }
+            continue;
+        }
+
+        size_t outputSize = thiz.core.bufferSize;
         for (int i = 0; i < 2; ++i)
         {
             thiz.waveHeaderIndex++;
             if (thiz.waveHeaderIndex >= _countof(thiz.waveHeader))
                 thiz.waveHeaderIndex = 0;
 
-            short* output = (short*)thiz.bufferQueue.Address(thiz.bufferQueuePick, &outputSize);
-            scaleWaveform(output, outputSize, thiz.volume);
+            uint64_t pick = thiz.core.bufferQueue.LoadPick();
+            char* output = thiz.core.bufferQueue.Address(pick, &outputSize);
+            size_t samples = outputSize / sizeWaveform(thiz.core.format);
+            bool go = thiz.core.go;
+            if (go)
+            {
+                thiz.core.Period(pick, outputSize);
+            }
+            thiz.core.bufferQueue.Silence(pick, outputSize);
+            if (go)
+            {
+                thiz.core.Underrun(pick, output, thiz.core.format, samples, 1.0f, false, nullptr);
+            }
+            // Play is not on this path, so the volume pass meters here. The
+            // meter is 16-bit only, as the ring is whenever it is on.
+            if (thiz.core.meterEnable)
+            {
+                WaveformMeter meter = {};
+                if (go)
+                {
+                    scaleWaveform((int16_t*)output, (int16_t*)output, outputSize, thiz.core.volume, thiz.core.channel, &meter);
+                }
+                meter.samples = samples;
+                thiz.core.telemetry.Meter(meter, thiz.core.channel, samples / thiz.core.channel * 1000000 / thiz.core.sampleRate);
+            }
+            else
+            {
+                convertWaveform(output, thiz.core.format, output, thiz.core.format, samples, thiz.core.volume);
+            }
 
             thiz.waveHeader[thiz.waveHeaderIndex].lpData = (LPSTR)output;
             thiz.waveHeader[thiz.waveHeaderIndex].dwBufferLength = outputSize;
-            if (thiz.go)
+            if (go)
             {
-                thiz.bufferQueuePick += outputSize;
+                thiz.core.bufferQueue.StorePick(pick + outputSize);
             }
             else
             {
@@ -90,7 +135,7 @@ static DWORD WINAPI WWaveOutThread(LPVOID arg)
             waveOutPrepareHeader(thiz.waveOut, &thiz.waveHeader[thiz.waveHeaderIndex], sizeof(WAVEHDR));
             waveOutWrite(thiz.waveOut, &thiz.waveHeader[thiz.waveHeaderIndex], sizeof(WAVEHDR));
 
-            outputSize = thiz.bufferSize - outputSize;
+            outputSize = thiz.core.bufferSize - outputSize;
             if (outputSize == 0)
                 break;
         }
@@ -125,8 +170,7 @@ static DWORD WINAPI WWaveInCallback(HWAVEIN hWaveIn, UINT uMsg, DWORD_PTR dwInst
 
         short* input = (short*)hdr->lpData;
         size_t inputSize = hdr->dwBufferLength;
-        scaleWaveform(input, inputSize, thiz.volume);
-        thiz.bufferQueueSend += thiz.bufferQueue.Scatter(thiz.bufferQueueSend, input, inputSize);
+        thiz.core.Record(input, inputSize);
 
         waveInAddBuffer(hWaveIn, hdr, sizeof(WAVEHDR));
         break;
@@ -146,19 +190,24 @@ static DWORD WINAPI WWaveInThread(LPVOID arg)
 
     if (thiz.cancel == false)
     {
-        waveInOpen(&thiz.waveIn, WAVE_MAPPER, &thiz.waveFormat, (DWORD_PTR)WWaveInCallback, (DWORD_PTR)&thiz, CALLBACK_FUNCTION);
+        waveInOpen(&thiz.waveIn, WAVE_MAPPER, &thiz.waveFormat.Format, (DWORD_PTR)WWaveInCallback, (DWORD_PTR)&thiz, CALLBACK_FUNCTION);
     }
 
     if (thiz.waveIn)
     {
+        size_t inputSize = thiz.core.DeviceSize(thiz.core.bufferSize);
+        if (inputSize > sizeof(thiz.temp) / 2)
+            inputSize = sizeof(thiz.temp) / 2;
+        inputSize -= inputSize % thiz.waveFormat.Format.nBlockAlign;
+
         thiz.waveHeader[0] = {};
-        thiz.waveHeader[0].lpData = (LPSTR)&thiz.temp[0];
-        thiz.waveHeader[0].dwBufferLength = thiz.bufferSize;
+        thiz.waveHeader[0].lpData = (LPSTR)thiz.temp;
+        thiz.waveHeader[0].dwBufferLength = inputSize;
         thiz.waveHeader[0].dwLoops = TRUE;
 
         thiz.waveHeader[1] = {};
-        thiz.waveHeader[1].lpData = (LPSTR)&thiz.temp[thiz.bufferSize];
-        thiz.waveHeader[1].dwBufferLength = thiz.bufferSize;
+        thiz.waveHeader[1].lpData = (LPSTR)thiz.temp + inputSize;
+        thiz.waveHeader[1].dwBufferLength = inputSize;
         thiz.waveHeader[1].dwLoops = TRUE;
 
         waveInPrepareHeader(thiz.waveIn, &thiz.waveHeader[0], sizeof(WAVEHDR));
@@ -189,53 +238,81 @@ static DWORD WINAPI WWaveInThread(LPVOID arg)
     return 0;
 }
 //------------------------------------------------------------------------------
-struct WWaveIO* WWaveIOCreate(int channel, int sampleRate, int secondPerBuffer, bool record)
+static bool WWaveIOQuery(WWaveIO& thiz)
+{
+    bool pcm = (thiz.core.deviceFormat == WAVEFORM_S16);
+    WAVEFORMATEX& waveFormat = thiz.waveFormat.Format;
+    waveFormat.nSamplesPerSec = thiz.core.sampleRate;
+    waveFormat.wBitsPerSample = pcm ? 16 : 32;
+    waveFormat.nChannels = thiz.core.deviceChannel;
+    waveFormat.cbSize = 0;
+    waveFormat.wFormatTag = pcm ? WAVE_FORMAT_PCM : WAVE_FORMAT_IEEE_FLOAT;
+    waveFormat.nBlockAlign = (waveFormat.wBitsPerSample * waveFormat.nChannels) >> 3;
+    waveFormat.nAvgBytesPerSec = waveFormat.nBlockAlign * waveFormat.nSamplesPerSec;
+
+    // Past stereo the speakers have to be named, and the speaker bits of
+    // Waveform are the ones of dwChannelMask. The subformat GUID is the
+    // format tag on the base every WAVE_FORMAT GUID shares.
+    if (waveFormat.nChannels > 2)
+    {
+        thiz.waveFormat.Samples.wValidBitsPerSample = waveFormat.wBitsPerSample;
+        thiz.waveFormat.dwChannelMask = thiz.core.deviceMask;
+        thiz.waveFormat.SubFormat = { waveFormat.wFormatTag, 0x0000, 0x0010, { 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } };
+        waveFormat.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+        waveFormat.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+    }
+
+    if (thiz.core.record)
+        return waveInOpen(nullptr, WAVE_MAPPER, &waveFormat, 0, 0, WAVE_FORMAT_QUERY) == MMSYSERR_NOERROR;
+
+    return waveOutOpen(nullptr, WAVE_MAPPER, &waveFormat, 0, 0, WAVE_FORMAT_QUERY) == MMSYSERR_NOERROR;
+}
+//------------------------------------------------------------------------------
+static void WWaveIOStart(void* context)
+{
+    WWaveIO& thiz = *(WWaveIO*)context;
+    if (thiz.thread)
+        return;
+
+    if (thiz.core.record)
+    {
+        thiz.core.bufferQueue.StoreSend(0);
+        thiz.thread = CreateThread(nullptr, 0, WWaveInThread, &thiz, 0, nullptr);
+    }
+    else
+    {
+        thiz.thread = CreateThread(nullptr, 0, WWaveOutThread, &thiz, 0, nullptr);
+    }
+}
+//------------------------------------------------------------------------------
+struct WWaveIO* WWaveIOCreate(int channel, int sampleRate, int secondPerBuffer, bool record, int format)
 {
     WWaveIO* waveOut = nullptr;
 
     switch (0) case 0: default:
     {
-        if (channel == 0)
-            break;
-        if (sampleRate == 0)
-            break;
-
         waveOut = new WWaveIO{};
         if (waveOut == nullptr)
             break;
         WWaveIO& thiz = (*waveOut);
 
-        if (thiz.bufferQueue.Startup(sampleRate * sizeof(int16_t) * channel * secondPerBuffer) == false)
+        if (thiz.core.Startup(channel, sampleRate, secondPerBuffer, record, format, WWaveIOStart, waveOut) == false)
             break;
 
-        thiz.waveFormat.nSamplesPerSec = sampleRate;
-        thiz.waveFormat.wBitsPerSample = 16;
-        thiz.waveFormat.nChannels = channel;
-        thiz.waveFormat.cbSize = 0;
-        thiz.waveFormat.wFormatTag = WAVE_FORMAT_PCM;
-        thiz.waveFormat.nBlockAlign = (thiz.waveFormat.wBitsPerSample * thiz.waveFormat.nChannels) >> 3;
-        thiz.waveFormat.nAvgBytesPerSec = thiz.waveFormat.nBlockAlign * thiz.waveFormat.nSamplesPerSec;
-        if (record)
-        {
-            if (waveInOpen(nullptr, WAVE_MAPPER, &thiz.waveFormat, 0, 0, WAVE_FORMAT_QUERY) != MMSYSERR_NOERROR)
-                break;
-        }
-        else
-        {
-            if (waveOutOpen(nullptr, WAVE_MAPPER, &thiz.waveFormat, 0, 0, WAVE_FORMAT_QUERY) != MMSYSERR_NOERROR)
-                break;
-        }
+        // WaveIO has no low-aligned 24-bit container, so S24 runs on a float
+        // device, and a device the mapper refuses steps down to stereo and
+        // then to 16 bits.
+        thiz.core.deviceFormat = (format == WAVEFORM_S16) ? WAVEFORM_S16 : WAVEFORM_F32;
+        bool query = WWaveIOQuery(thiz);
+        while (query == false && thiz.core.DeviceFallback())
+            query = WWaveIOQuery(thiz);
+        if (query == false)
+            break;
 
         thiz.semaphore = CreateSemaphoreA(nullptr, 0, LONG_MAX, nullptr);
         if (thiz.semaphore == nullptr)
             break;
 
-        thiz.channel = channel;
-        thiz.sampleRate = sampleRate;
-        thiz.bytesPerSecond = sampleRate * sizeof(int16_t) * channel;
-        thiz.volume = record ? 1.0f : 0.0f;
-        thiz.record = record;
-
         return waveOut;
     }
     WWaveIODestroy(waveOut);
@@ -243,58 +320,106 @@ struct WWaveIO* WWaveIOCreate(int channel, int sampleRate, int secondPerBuffer,
     return nullptr;
 }
 //------------------------------------------------------------------------------
-uint64_t WWaveIOQueue(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+size_t WWaveIOQueueReserve(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2])
 {
     if (waveOut == nullptr)
         return 0;
     WWaveIO& thiz = (*waveOut);
-    if (bufferSize == 0)
-        return 0;
-    if (thiz.record)
+
+    return thiz.core.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize);
+}
+//------------------------------------------------------------------------------
+uint64_t WWaveIOQueueCommit(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int gap)
+{
+    if (waveOut == nullptr)
         return 0;
+    WWaveIO& thiz = (*waveOut);
 
-    if (thiz.ready)
+    uint64_t pick = thiz.core.QueueCommit(now, timestamp, gap);
+    if (pick)
     {
-        if (thiz.bufferQueueSend < thiz.bufferQueuePick || thiz.bufferQueueSend > thiz.bufferQueuePick + thiz.bytesPerSecond / 2)
-        {
-            thiz.bufferQueueSend = 0;
-            timestamp = now + thiz.bufferQueuePickAdjust;
-        }
+        ReleaseSemaphore(thiz.semaphore, 1, nullptr);
     }
 
-    if (thiz.bufferQueueSend == 0 || thiz.bufferQueueSendAdjust != adjust)
+    return pick;
+}
+//------------------------------------------------------------------------------
+uint64_t WWaveIOQueue(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    if (waveOut == nullptr)
+        return 0;
+    WWaveIO& thiz = (*waveOut);
+
+    uint64_t pick = thiz.core.Queue(now, timestamp, adjust, buffer, bufferSize, gap);
+    if (pick)
     {
-        thiz.bufferQueueSend = (timestamp + adjust) * thiz.bytesPerSecond / 1000000;
-        thiz.bufferQueueSend = thiz.bufferQueueSend - (thiz.bufferQueueSend % bufferSize);
-        thiz.bufferQueueSendAdjust = adjust;
+        ReleaseSemaphore(thiz.semaphore, 1, nullptr);
     }
-    thiz.bufferQueueSend += thiz.bufferQueue.Scatter(thiz.bufferQueueSend, buffer, bufferSize);
 
-    if (thiz.ready == false)
-    {
-        thiz.ready = true;
+    return pick;
+}
+//------------------------------------------------------------------------------
+uint64_t WWaveIOQueuePlanar(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    if (waveOut == nullptr)
+        return 0;
+    WWaveIO& thiz = (*waveOut);
 
-        adjust = 0;
-        if (now > timestamp)
-        {
-            adjust = timestamp - now;
-        }
+    uint64_t pick = thiz.core.QueuePlanar(now, timestamp, adjust, buffer, bufferSize, gap);
+    if (pick)
+    {
+        ReleaseSemaphore(thiz.semaphore, 1, nullptr);
+    }
 
-        thiz.bufferSize = bufferSize;
-        thiz.bufferQueuePick = (now + adjust) * thiz.bytesPerSecond / 1000000 - bufferSize * gap;
-        thiz.bufferQueuePick = thiz.bufferQueuePick - (thiz.bufferQueuePick % bufferSize);
-        thiz.bufferQueuePickAdjust = adjust;
+    return pick;
+}
+//------------------------------------------------------------------------------
+uint64_t WWaveIOQueueBatch(struct WWaveIO* waveOut, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap)
+{
+    if (waveOut == nullptr)
+        return 0;
+    WWaveIO& thiz = (*waveOut);
 
-        if (thiz.thread == nullptr)
-            thiz.thread = CreateThread(nullptr, 0, WWaveOutThread, &thiz, 0, nullptr);
+    uint64_t pick = thiz.core.QueueBatch(now, adjust, packet, count, gap);
+    if (pick)
+    {
+        ReleaseSemaphore(thiz.semaphore, 1, nullptr);
     }
-    else
+
+    return pick;
+}
+//------------------------------------------------------------------------------
+uint64_t WWaveIOQueueSilence(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    if (waveOut == nullptr)
+        return 0;
+    WWaveIO& thiz = (*waveOut);
+
+    uint64_t pick = thiz.core.QueueSilence(now, timestamp, adjust, bufferSize, gap);
+    if (pick)
     {
-        thiz.go = true;
+        ReleaseSemaphore(thiz.semaphore, 1, nullptr);
     }
 
-    ReleaseSemaphore(thiz.semaphore, 1, nullptr);
-    return thiz.bufferQueuePick * 1000000 / thiz.bytesPerSecond;
+    return pick;
+}
+//------------------------------------------------------------------------------
+size_t WWaveIODequeuePeek(struct WWaveIO* waveOut, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop)
+{
+    if (waveOut == nullptr)
+        return 0;
+    WWaveIO& thiz = (*waveOut);
+
+    return thiz.core.DequeuePeek(span, spanSize, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+void WWaveIODequeueRelease(struct WWaveIO* waveOut, size_t bufferSize)
+{
+    if (waveOut == nullptr)
+        return;
+    WWaveIO& thiz = (*waveOut);
+
+    thiz.core.DequeueRelease(bufferSize);
 }
 //------------------------------------------------------------------------------
 size_t WWaveIODequeue(struct WWaveIO* waveOut, void* buffer, size_t bufferSize, bool drop)
@@ -302,35 +427,130 @@ size_t WWaveIODequeue(struct WWaveIO* waveOut, void* buffer, size_t bufferSize,
     if (waveOut == nullptr)
         return 0;
     WWaveIO& thiz = (*waveOut);
-    if (thiz.record == false)
+
+    return thiz.core.Dequeue(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+size_t WWaveIODequeuePlanar(struct WWaveIO* waveOut, void* const* buffer, size_t bufferSize, bool drop)
+{
+    if (waveOut == nullptr)
         return 0;
+    WWaveIO& thiz = (*waveOut);
+
+    return thiz.core.DequeuePlanar(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOMixer(struct WWaveIO* waveOut, struct Mixer* mixer)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
 
-    if (thiz.ready == false)
+    // The mixer renders into the first four headers of temp.
+    if (thiz.core.Attach(mixer, sizeof(thiz.temp) / 4) == false)
+        return false;
+    if (mixer)
     {
-        thiz.ready = true;
+        ReleaseSemaphore(thiz.semaphore, 1, nullptr);
+    }
 
-        thiz.bufferSize = bufferSize;
-        thiz.bufferQueueSend = 0;
+    return true;
+}
+//------------------------------------------------------------------------------
+bool WWaveIOConvert(struct WWaveIO* waveOut, int sampleRate)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
 
-        if (thiz.thread == nullptr)
-            thiz.thread = CreateThread(nullptr, 0, WWaveInThread, &thiz, 0, nullptr);
-    }
+    return thiz.core.Convert(sampleRate);
+}
+//------------------------------------------------------------------------------
+bool WWaveIODrift(struct WWaveIO* waveOut, bool enable)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
 
-    if (drop)
-    {
-        uint64_t available = thiz.bufferQueueSend - thiz.bufferQueuePick;
-        while (available > thiz.bytesPerSecond)
-        {
-            thiz.bufferQueuePick += thiz.bytesPerSecond;
-            available = thiz.bufferQueueSend - thiz.bufferQueuePick;
-        }
-    }
+    return thiz.core.EnableDrift(enable);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOConceal(struct WWaveIO* waveOut, bool enable)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
 
-    if (thiz.bufferQueueSend < thiz.bufferQueuePick + bufferSize)
-        return 0;
-    thiz.bufferQueuePick += thiz.bufferQueue.Gather(thiz.bufferQueuePick, buffer, bufferSize, true);
+    return thiz.core.EnableConceal(enable);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOPlayout(struct WWaveIO* waveOut, bool enable)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
 
-    return bufferSize;
+    return thiz.core.EnablePlayout(enable);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOVoice(struct WWaveIO* waveOut, bool enable, bool collapse)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
+
+    return thiz.core.EnableVoice(enable, collapse);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOSpeech(struct WWaveIO* waveOut, uint64_t* collapsed)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
+
+    return thiz.core.Speech(collapsed);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOMeter(struct WWaveIO* waveOut, bool enable)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
+
+    return thiz.core.EnableMeter(enable);
+}
+//------------------------------------------------------------------------------
+bool WWaveIOTelemetry(struct WWaveIO* waveOut, struct TelemetrySnapshot* snapshot)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
+
+    thiz.core.telemetry.Read(snapshot);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool WWaveIOLayout(struct WWaveIO* waveOut, uint32_t channelMask, uint32_t* deviceMask)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
+
+    if (thiz.core.Layout(channelMask) == false)
+        return false;
+    if (deviceMask)
+        (*deviceMask) = thiz.core.deviceMask;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool WWaveIOMatrix(struct WWaveIO* waveOut, const float* matrix)
+{
+    if (waveOut == nullptr)
+        return false;
+    WWaveIO& thiz = (*waveOut);
+
+    return thiz.core.Matrix(matrix);
 }
 //------------------------------------------------------------------------------
 void WWaveIOReset(struct WWaveIO* waveOut)
@@ -339,16 +559,7 @@ void WWaveIOReset(struct WWaveIO* waveOut)
         return;
     WWaveIO& thiz = (*waveOut);
 
-    if (thiz.record)
-    {
-        thiz.ready = false;
-        thiz.go = false;
-    }
-    else
-    {
-        thiz.ready = false;
-        thiz.go = false;
-    }
+    thiz.core.Reset();
 }
 //------------------------------------------------------------------------------
 void WWaveIOVolume(struct WWaveIO* waveOut, float volume)
@@ -357,14 +568,7 @@ void WWaveIOVolume(struct WWaveIO* waveOut, float volume)
         return;
     WWaveIO& thiz = (*waveOut);
 
-    if (thiz.record)
-    {
-        thiz.volume = volume;
-    }
-    else
-    {
-        thiz.volume = volume;
-    }
+    thiz.core.volume = volume;
 }
 //------------------------------------------------------------------------------
 void WWaveIODestroy(struct WWaveIO* waveOut)
@@ -7,14 +7,34 @@
 #pragma once
 
 #include <stdint.h>
+#include "Waveform.h"
 
 #ifndef STREAMAL_EXPORT
 #define STREAMAL_EXPORT
 #endif
 
-STREAMAL_EXPORT struct WWaveIO* WWaveIOCreate(int channel, int sampleRate, int secondPerBuffer, bool record);
+STREAMAL_EXPORT struct WWaveIO* WWaveIOCreate(int channel, int sampleRate, int secondPerBuffer, bool record, int format = WAVEFORM_S16);
 STREAMAL_EXPORT void WWaveIODestroy(struct WWaveIO* waveOut);
 STREAMAL_EXPORT uint64_t WWaveIOQueue(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t WWaveIOQueuePlanar(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t WWaveIOQueueBatch(struct WWaveIO* waveOut, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap);
+STREAMAL_EXPORT uint64_t WWaveIOQueueSilence(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+STREAMAL_EXPORT size_t WWaveIOQueueReserve(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2]);
+STREAMAL_EXPORT uint64_t WWaveIOQueueCommit(struct WWaveIO* waveOut, uint64_t now, uint64_t timestamp, int gap);
 STREAMAL_EXPORT size_t WWaveIODequeue(struct WWaveIO* waveOut, void* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t WWaveIODequeuePlanar(struct WWaveIO* waveOut, void* const* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t WWaveIODequeuePeek(struct WWaveIO* waveOut, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT void WWaveIODequeueRelease(struct WWaveIO* waveOut, size_t bufferSize);
+STREAMAL_EXPORT bool WWaveIOMixer(struct WWaveIO* waveOut, struct Mixer* mixer);
+STREAMAL_EXPORT bool WWaveIOConvert(struct WWaveIO* waveOut, int sampleRate);
+STREAMAL_EXPORT bool WWaveIODrift(struct WWaveIO* waveOut, bool enable);
+STREAMAL_EXPORT bool WWaveIOConceal(struct WWaveIO* waveOut, bool enable);
+STREAMAL_EXPORT bool WWaveIOPlayout(struct WWaveIO* waveOut, bool enable);
+STREAMAL_EXPORT bool WWaveIOVoice(struct WWaveIO* waveOut, bool enable, bool collapse = false);
+STREAMAL_EXPORT bool WWaveIOSpeech(struct WWaveIO* waveOut, uint64_t* collapsed = nullptr);
+STREAMAL_EXPORT bool WWaveIOMeter(struct WWaveIO* waveOut, bool enable);
+STREAMAL_EXPORT bool WWaveIOTelemetry(struct WWaveIO* waveOut, struct TelemetrySnapshot* snapshot);
+STREAMAL_EXPORT bool WWaveIOLayout(struct WWaveIO* waveOut, uint32_t channelMask, uint32_t* deviceMask = nullptr);
+STREAMAL_EXPORT bool WWaveIOMatrix(struct WWaveIO* waveOut, const float* matrix);
 STREAMAL_EXPORT void WWaveIOReset(struct WWaveIO* waveOut);
 STREAMAL_EXPORT void WWaveIOVolume(struct WWaveIO* waveOut, float volume);
@@ -5,56 +5,2367 @@
 // https://github.com/metarutaiga/StreamAL
 //==============================================================================
 #if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(_M_ARM) || defined(_M_ARM64)
+#   define WAVEFORM_NEON_ENABLE 1
 #   include <arm_neon.h>
 #elif defined(_M_IX86) || defined(_M_AMD64) || defined(__i386__) || defined(__amd64__)
+#   define WAVEFORM_X86_ENABLE 1
 #   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
 #endif
 #include <math.h>
 #include <limits.h>
 #include <string.h>
 #include "Waveform.h"
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#   define WAVEFORM_TARGET(isa)
+#else
+#   define WAVEFORM_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#define S24_MIN (-8388608)
+#define S24_MAX 8388607
+
+#define WAVEFORM_CONVERT_TABLE(convert) \
+{ \
+    { convert<WAVEFORM_S16, WAVEFORM_S16>, convert<WAVEFORM_S16, WAVEFORM_S24>, convert<WAVEFORM_S16, WAVEFORM_F32> }, \
+    { convert<WAVEFORM_S24, WAVEFORM_S16>, convert<WAVEFORM_S24, WAVEFORM_S24>, convert<WAVEFORM_S24, WAVEFORM_F32> }, \
+    { convert<WAVEFORM_F32, WAVEFORM_S16>, convert<WAVEFORM_F32, WAVEFORM_S24>, convert<WAVEFORM_F32, WAVEFORM_F32> }, \
+}
+
+// Runs function<channels> for the channel counts a template covers, and falls
+// through for the others.
+#define WAVEFORM_CHANNEL_SWITCH(function, channels, ...) \
+    switch (channels) \
+    { \
+    case 1: function<1>(__VA_ARGS__); return; \
+    case 2: function<2>(__VA_ARGS__); return; \
+    case 3: function<3>(__VA_ARGS__); return; \
+    case 4: function<4>(__VA_ARGS__); return; \
+    case 5: function<5>(__VA_ARGS__); return; \
+    case 6: function<6>(__VA_ARGS__); return; \
+    case 7: function<7>(__VA_ARGS__); return; \
+    case 8: function<8>(__VA_ARGS__); return; \
+    default: break; \
+    }
+
+static constexpr size_t sampleSize(int format)
+{
+    return format == WAVEFORM_S16 ? sizeof(int16_t) : sizeof(int32_t);
+}
+
+// Vectors of lanes samples a run takes for its lanes to meet the same
+// channels again.
+static constexpr size_t laneDivisor(size_t a, size_t b)
+{
+    return b ? laneDivisor(b, a % b) : a;
+}
+static constexpr size_t lanePeriod(size_t channels, size_t lanes)
+{
+    return channels / laneDivisor(channels, lanes);
+}
+
+// Lane j of vector p of a run always holds channel (lanes * p + j) % channels,
+// so the meter kernels keep a maximum, a minimum and 64-bit squares per lane
+// and fold them into channels once. The squares are stored as unpacked in
+// 128-bit lanes: element e of accumulator k is lane (e / 2) * 8 + k * 2 + e % 2.
+static void meterFold(const int16_t* high, const int16_t* low, const uint64_t* energy, size_t lanes, size_t vector, size_t channels, WaveformMeter* meter)
+{
+    for (size_t j = 0; j < lanes; ++j)
+    {
+        size_t c = (lanes * vector + j) % channels;
+        int32_t magnitude = high[j] > -low[j] ? high[j] : -low[j];
+        if (magnitude > int32_t(meter->peak[c]))
+            meter->peak[c] = uint32_t(magnitude);
+    }
+    size_t count = lanes / 4;
+    for (size_t k = 0; k < 4; ++k)
+    {
+        for (size_t e = 0; e < count; ++e)
+        {
+            size_t j = (e / 2) * 8 + k * 2 + e % 2;
+            meter->energy[(lanes * vector + j) % channels] += energy[k * count + e];
+        }
+    }
+}
+
+//==============================================================================
+// Scalar
+//==============================================================================
+static void scaleScalar(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    for (size_t i = 0; i < samples; ++i)
+    {
+        float scaled = input[i] * scale;
+        scaled = fminf(fmaxf(scaled, SHRT_MIN), SHRT_MAX);
+        output[i] = int16_t(lrintf(scaled));
+    }
+}
+//------------------------------------------------------------------------------
+static void scaleQ15Scalar(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    for (size_t i = 0; i < samples; ++i)
+    {
+        int32_t scaled = (input[i] * scale + 0x4000) >> 15;
+        output[i] = int16_t(scaled < SHRT_MIN ? SHRT_MIN : scaled > SHRT_MAX ? SHRT_MAX : scaled);
+    }
+}
+//------------------------------------------------------------------------------
+// Samples [begin, end) of a scaleActivity call. The vector kernels run their
+// first frame and their tail through here.
+static void activityScalar(int16_t* output, const int16_t* input, size_t begin, size_t end, float scale, size_t channels, WaveformActivity* activity)
+{
+    uint64_t energy = 0;
+    uint64_t crossings = 0;
+    for (size_t i = begin; i < end; ++i)
+    {
+        float scaled = input[i] * scale;
+        scaled = fminf(fmaxf(scaled, SHRT_MIN), SHRT_MAX);
+        int16_t sample = int16_t(lrintf(scaled));
+        output[i] = sample;
+        energy += uint32_t(sample * sample);
+        if (i >= channels && (sample ^ output[i - channels]) < 0)
+            crossings++;
+    }
+    activity->energy += energy;
+    activity->crossings += crossings;
+    activity->samples += end - begin;
+}
+//------------------------------------------------------------------------------
+static void scaleActivityScalar(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformActivity* activity)
+{
+    activityScalar(output, input, 0, samples, scale, channels, activity);
+}
+//------------------------------------------------------------------------------
+// Samples [begin, end) of a scaleMeter call. The vector kernels run their
+// tail through here.
+static void meterScalar(int16_t* output, const int16_t* input, size_t begin, size_t end, float scale, size_t channels, WaveformMeter* meter)
+{
+    size_t c = begin % channels;
+    for (size_t i = begin; i < end; ++i)
+    {
+        float scaled = input[i] * scale;
+        scaled = fminf(fmaxf(scaled, SHRT_MIN), SHRT_MAX);
+        int16_t sample = int16_t(lrintf(scaled));
+        output[i] = sample;
+        uint32_t magnitude = uint32_t(sample < 0 ? -sample : sample);
+        if (meter->peak[c] < magnitude)
+            meter->peak[c] = magnitude;
+        meter->energy[c] += uint32_t(sample * sample);
+        if (++c == channels)
+            c = 0;
+    }
+    meter->samples += end - begin;
+}
+//------------------------------------------------------------------------------
+static void scaleMeterScalar(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformMeter* meter)
+{
+    meterScalar(output, input, 0, samples, scale, channels, meter);
+}
+//------------------------------------------------------------------------------
+static void mixScalar(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    for (size_t i = 0; i < samples; ++i)
+    {
+        float scaled = input[i] * scale;
+        scaled = fminf(fmaxf(scaled, SHRT_MIN), SHRT_MAX);
+        int32_t mixed = output[i] + int32_t(lrintf(scaled));
+        output[i] = int16_t(mixed < SHRT_MIN ? SHRT_MIN : mixed > SHRT_MAX ? SHRT_MAX : mixed);
+    }
+}
+//------------------------------------------------------------------------------
+static void mixQ15Scalar(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    for (size_t i = 0; i < samples; ++i)
+    {
+        int32_t scaled = (input[i] * scale + 0x4000) >> 15;
+        scaled = scaled < SHRT_MIN ? SHRT_MIN : scaled > SHRT_MAX ? SHRT_MAX : scaled;
+        int32_t mixed = output[i] + scaled;
+        output[i] = int16_t(mixed < SHRT_MIN ? SHRT_MIN : mixed > SHRT_MAX ? SHRT_MAX : mixed);
+    }
+}
+//------------------------------------------------------------------------------
+static int32_t dotScalar(const int16_t* a, const int16_t* b, size_t samples)
+{
+    int32_t sum = 0;
+    for (size_t i = 0; i < samples; ++i)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+//------------------------------------------------------------------------------
+static float correlateScalar(const float* a, const float* b, size_t samples)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < samples; ++i)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+//------------------------------------------------------------------------------
+static inline float loadScalar(const void* input, int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        return *(const int16_t*)input;
+    case WAVEFORM_S24:
+        return float(*(const int32_t*)input);
+    default:
+        return *(const float*)input;
+    }
+}
+//------------------------------------------------------------------------------
+static inline void storeScalar(void* output, int format, float sample)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        *(int16_t*)output = int16_t(lrintf(fminf(fmaxf(sample, SHRT_MIN), SHRT_MAX)));
+        break;
+    case WAVEFORM_S24:
+        *(int32_t*)output = int32_t(lrintf(fminf(fmaxf(sample, S24_MIN), S24_MAX)));
+        break;
+    default:
+        *(float*)output = sample;
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+template<int inputFormat, int outputFormat>
+static void convertScalar(void* output, const void* input, size_t samples, float scale)
+{
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+    for (size_t i = 0; i < samples; ++i)
+    {
+        float sample = loadScalar(in + i * sampleSize(inputFormat), inputFormat);
+        storeScalar(out + i * sampleSize(outputFormat), outputFormat, sample * scale);
+    }
+}
+//------------------------------------------------------------------------------
+template<typename T>
+static void interleaveScalar(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    T* out = (T*)output;
+    for (size_t c = 0; c < channels; ++c)
+    {
+        const T* plane = (const T*)input[c] + offset;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            out[i * channels + c] = plane[i];
+        }
+    }
+}
+//------------------------------------------------------------------------------
+template<typename T>
+static void deinterleaveScalar(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    const T* in = (const T*)input;
+    for (size_t c = 0; c < channels; ++c)
+    {
+        T* plane = (T*)output[c] + offset;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            plane[i] = in[i * channels + c];
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static void remixScalar(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs)
+{
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const float* in = input + f * inputs;
+        float* out = output + f * outputs;
+        for (size_t o = 0; o < outputs; ++o)
+        {
+            float sum = 0.0f;
+            for (size_t i = 0; i < inputs; ++i)
+            {
+                sum += in[i] * matrix[i * WAVEFORM_CHANNEL_MAX + o];
+            }
+            out[o] = sum;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static const WaveformKernel kernelScalar =
+{
+    "scalar",
+    scaleScalar,
+    scaleQ15Scalar,
+    scaleActivityScalar,
+    scaleMeterScalar,
+    mixScalar,
+    mixQ15Scalar,
+    dotScalar,
+    correlateScalar,
+    WAVEFORM_CONVERT_TABLE(convertScalar),
+    interleaveScalar<int16_t>,
+    interleaveScalar<int32_t>,
+    deinterleaveScalar<int16_t>,
+    deinterleaveScalar<int32_t>,
+    remixScalar,
+};
+#if WAVEFORM_X86_ENABLE
+//==============================================================================
+// SSE2 : 8 samples per iteration
+//==============================================================================
+WAVEFORM_TARGET("sse2")
+static inline __m128i scale8SSE2(__m128i s16, __m128 vScale)
+{
+    const __m128 vMin = _mm_set1_ps(SHRT_MIN);
+    const __m128 vMax = _mm_set1_ps(SHRT_MAX);
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+    __m128 flo = _mm_mul_ps(_mm_cvtepi32_ps(lo), vScale);
+    __m128 fhi = _mm_mul_ps(_mm_cvtepi32_ps(hi), vScale);
+    lo = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(flo, vMin), vMax));
+    hi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(fhi, vMin), vMax));
+    return _mm_packs_epi32(lo, hi);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static inline __m128i scaleQ15x8SSE2(__m128i s16, __m128i vScale)
+{
+    const __m128i vOne = _mm_set1_epi16(1);
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(s16, vOne), vScale);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(s16, vOne), vScale);
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 15), _mm_srai_epi32(hi, 15));
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void scaleSSE2(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    __m128 vScale = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i s16 = _mm_loadu_si128((__m128i*)(input + i));
+        _mm_storeu_si128((__m128i*)(output + i), scale8SSE2(s16, vScale));
+    }
+    if (i < samples)
+    {
+        int16_t tail[8] = {};
+        memcpy(tail, input + i, (samples - i) * sizeof(int16_t));
+        _mm_storeu_si128((__m128i*)tail, scale8SSE2(_mm_loadu_si128((__m128i*)tail), vScale));
+        memcpy(output + i, tail, (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void scaleQ15SSE2(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    __m128i vScale = _mm_set1_epi32((0x4000 << 16) | uint16_t(scale));
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i s16 = _mm_loadu_si128((__m128i*)(input + i));
+        _mm_storeu_si128((__m128i*)(output + i), scaleQ15x8SSE2(s16, vScale));
+    }
+    if (i < samples)
+    {
+        int16_t tail[8] = {};
+        memcpy(tail, input + i, (samples - i) * sizeof(int16_t));
+        _mm_storeu_si128((__m128i*)tail, scaleQ15x8SSE2(_mm_loadu_si128((__m128i*)tail), vScale));
+        memcpy(output + i, tail, (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+// The sample a frame back is shifted in from the last vector, which takes an
+// immediate, so the channel count is a template argument.
+template<size_t C>
+WAVEFORM_TARGET("sse2")
+static void activitySSE2(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformActivity* activity)
+{
+    size_t i = C < samples ? C : samples;
+    activityScalar(output, input, 0, i, scale, C, activity);
+
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vOne = _mm_set1_epi16(1);
+    __m128 vScale = _mm_set1_ps(scale);
+    int16_t head[8] = {};
+    memcpy(head + 8 - i, output, i * sizeof(int16_t));
+    __m128i last = _mm_loadu_si128((__m128i*)head);
+    __m128i energy = vZero;
+    __m128i crossings = vZero;
+    size_t begin = i;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i s16 = scale8SSE2(_mm_loadu_si128((__m128i*)(input + i)), vScale);
+        _mm_storeu_si128((__m128i*)(output + i), s16);
+        __m128i prev = _mm_or_si128(_mm_slli_si128(s16, 2 * C), _mm_srli_si128(last, 16 - 2 * C));
+        __m128i square = _mm_madd_epi16(s16, s16);
+        energy = _mm_add_epi64(energy, _mm_unpacklo_epi32(square, vZero));
+        energy = _mm_add_epi64(energy, _mm_unpackhi_epi32(square, vZero));
+        crossings = _mm_add_epi32(crossings, _mm_madd_epi16(_mm_srli_epi16(_mm_xor_si128(s16, prev), 15), vOne));
+        last = s16;
+    }
+    uint64_t energy64[2];
+    uint32_t crossings32[4];
+    _mm_storeu_si128((__m128i*)energy64, energy);
+    _mm_storeu_si128((__m128i*)crossings32, crossings);
+    activity->energy += energy64[0] + energy64[1];
+    activity->crossings += uint64_t(crossings32[0]) + crossings32[1] + crossings32[2] + crossings32[3];
+    activity->samples += i - begin;
+    activityScalar(output, input, i, samples, scale, C, activity);
+}
+//------------------------------------------------------------------------------
+static void scaleActivitySSE2(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformActivity* activity)
+{
+    WAVEFORM_CHANNEL_SWITCH(activitySSE2, channels, output, input, samples, scale, activity);
+    activityScalar(output, input, 0, samples, scale, channels, activity);
+}
+//------------------------------------------------------------------------------
+// Runs of lanePeriod vectors, so the lanes of each vector of a run keep to
+// the same channels.
+template<size_t C>
+WAVEFORM_TARGET("sse2")
+static void meterSSE2(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformMeter* meter)
+{
+    const size_t P = lanePeriod(C, 8);
+    const __m128i vZero = _mm_setzero_si128();
+    __m128 vScale = _mm_set1_ps(scale);
+    __m128i high[P];
+    __m128i low[P];
+    __m128i energy[P][4];
+    for (size_t p = 0; p < P; ++p)
+    {
+        high[p] = _mm_set1_epi16(SHRT_MIN);
+        low[p] = _mm_set1_epi16(SHRT_MAX);
+        for (size_t k = 0; k < 4; ++k)
+            energy[p][k] = vZero;
+    }
+    size_t i = 0;
+    for (; i + 8 * P <= samples; i += 8 * P)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            __m128i s16 = scale8SSE2(_mm_loadu_si128((__m128i*)(input + i + 8 * p)), vScale);
+            _mm_storeu_si128((__m128i*)(output + i + 8 * p), s16);
+            high[p] = _mm_max_epi16(high[p], s16);
+            low[p] = _mm_min_epi16(low[p], s16);
+            __m128i lo = _mm_unpacklo_epi16(_mm_mullo_epi16(s16, s16), _mm_mulhi_epi16(s16, s16));
+            __m128i hi = _mm_unpackhi_epi16(_mm_mullo_epi16(s16, s16), _mm_mulhi_epi16(s16, s16));
+            energy[p][0] = _mm_add_epi64(energy[p][0], _mm_unpacklo_epi32(lo, vZero));
+            energy[p][1] = _mm_add_epi64(energy[p][1], _mm_unpackhi_epi32(lo, vZero));
+            energy[p][2] = _mm_add_epi64(energy[p][2], _mm_unpacklo_epi32(hi, vZero));
+            energy[p][3] = _mm_add_epi64(energy[p][3], _mm_unpackhi_epi32(hi, vZero));
+        }
+    }
+    if (i)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            int16_t high16[8];
+            int16_t low16[8];
+            uint64_t energy64[8];
+            _mm_storeu_si128((__m128i*)high16, high[p]);
+            _mm_storeu_si128((__m128i*)low16, low[p]);
+            for (size_t k = 0; k < 4; ++k)
+                _mm_storeu_si128((__m128i*)(energy64 + 2 * k), energy[p][k]);
+            meterFold(high16, low16, energy64, 8, p, C, meter);
+        }
+        meter->samples += i;
+    }
+    meterScalar(output, input, i, samples, scale, C, meter);
+}
+//------------------------------------------------------------------------------
+static void scaleMeterSSE2(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformMeter* meter)
+{
+    WAVEFORM_CHANNEL_SWITCH(meterSSE2, channels, output, input, samples, scale, meter);
+    meterScalar(output, input, 0, samples, scale, channels, meter);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void mixSSE2(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    __m128 vScale = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i s16 = scale8SSE2(_mm_loadu_si128((__m128i*)(input + i)), vScale);
+        __m128i d16 = _mm_loadu_si128((__m128i*)(output + i));
+        _mm_storeu_si128((__m128i*)(output + i), _mm_adds_epi16(d16, s16));
+    }
+    if (i < samples)
+    {
+        int16_t tail[2][8] = {};
+        memcpy(tail[0], input + i, (samples - i) * sizeof(int16_t));
+        memcpy(tail[1], output + i, (samples - i) * sizeof(int16_t));
+        __m128i s16 = scale8SSE2(_mm_loadu_si128((__m128i*)tail[0]), vScale);
+        __m128i d16 = _mm_loadu_si128((__m128i*)tail[1]);
+        _mm_storeu_si128((__m128i*)tail[1], _mm_adds_epi16(d16, s16));
+        memcpy(output + i, tail[1], (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void mixQ15SSE2(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    __m128i vScale = _mm_set1_epi32((0x4000 << 16) | uint16_t(scale));
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i s16 = scaleQ15x8SSE2(_mm_loadu_si128((__m128i*)(input + i)), vScale);
+        __m128i d16 = _mm_loadu_si128((__m128i*)(output + i));
+        _mm_storeu_si128((__m128i*)(output + i), _mm_adds_epi16(d16, s16));
+    }
+    if (i < samples)
+    {
+        int16_t tail[2][8] = {};
+        memcpy(tail[0], input + i, (samples - i) * sizeof(int16_t));
+        memcpy(tail[1], output + i, (samples - i) * sizeof(int16_t));
+        __m128i s16 = scaleQ15x8SSE2(_mm_loadu_si128((__m128i*)tail[0]), vScale);
+        __m128i d16 = _mm_loadu_si128((__m128i*)tail[1]);
+        _mm_storeu_si128((__m128i*)tail[1], _mm_adds_epi16(d16, s16));
+        memcpy(output + i, tail[1], (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static int32_t dotSSE2(const int16_t* a, const int16_t* b, size_t samples)
+{
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i a16 = _mm_loadu_si128((__m128i*)(a + i));
+        __m128i b16 = _mm_loadu_si128((__m128i*)(b + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a16, b16));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum) + dotScalar(a + i, b + i, samples - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static float correlateSSE2(const float* a, const float* b, size_t samples)
+{
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 sum = _mm_add_ps(sum0, sum1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum) + correlateScalar(a + i, b + i, samples - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static inline __m128 load4SSE2(const void* input, int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+    {
+        __m128i s16 = _mm_loadl_epi64((__m128i*)input);
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+    }
+    case WAVEFORM_S24:
+        return _mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)input));
+    default:
+        return _mm_loadu_ps((float*)input);
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static inline void store4SSE2(void* output, int format, __m128 f32)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+    {
+        __m128i s32 = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(f32, _mm_set1_ps(SHRT_MIN)), _mm_set1_ps(SHRT_MAX)));
+        _mm_storel_epi64((__m128i*)output, _mm_packs_epi32(s32, s32));
+        break;
+    }
+    case WAVEFORM_S24:
+        _mm_storeu_si128((__m128i*)output, _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(f32, _mm_set1_ps(S24_MIN)), _mm_set1_ps(S24_MAX))));
+        break;
+    default:
+        _mm_storeu_ps((float*)output, f32);
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+template<int inputFormat, int outputFormat>
+WAVEFORM_TARGET("sse2")
+static void convertSSE2(void* output, const void* input, size_t samples, float scale)
+{
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+    __m128 vScale = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 f32 = load4SSE2(in + i * sampleSize(inputFormat), inputFormat);
+        store4SSE2(out + i * sampleSize(outputFormat), outputFormat, _mm_mul_ps(f32, vScale));
+    }
+    if (i < samples)
+    {
+        char tail[2][16] = {};
+        memcpy(tail[0], in + i * sampleSize(inputFormat), (samples - i) * sampleSize(inputFormat));
+        store4SSE2(tail[1], outputFormat, _mm_mul_ps(load4SSE2(tail[0], inputFormat), vScale));
+        memcpy(out + i * sampleSize(outputFormat), tail[1], (samples - i) * sampleSize(outputFormat));
+    }
+}
+//------------------------------------------------------------------------------
+// Stereo is the layout worth a shuffle, other channel counts stay scalar.
+WAVEFORM_TARGET("sse2")
+static void interleave16SSE2(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int16_t>(output, input, offset, channels, frames);
+
+    const int16_t* left = (const int16_t*)input[0] + offset;
+    const int16_t* right = (const int16_t*)input[1] + offset;
+    int16_t* out = (int16_t*)output;
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i l = _mm_loadu_si128((__m128i*)(left + i));
+        __m128i r = _mm_loadu_si128((__m128i*)(right + i));
+        _mm_storeu_si128((__m128i*)(out + i * 2 + 0), _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128((__m128i*)(out + i * 2 + 8), _mm_unpackhi_epi16(l, r));
+    }
+    interleaveScalar<int16_t>(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void interleave32SSE2(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int32_t>(output, input, offset, channels, frames);
+
+    const int32_t* left = (const int32_t*)input[0] + offset;
+    const int32_t* right = (const int32_t*)input[1] + offset;
+    int32_t* out = (int32_t*)output;
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128i l = _mm_loadu_si128((__m128i*)(left + i));
+        __m128i r = _mm_loadu_si128((__m128i*)(right + i));
+        _mm_storeu_si128((__m128i*)(out + i * 2 + 0), _mm_unpacklo_epi32(l, r));
+        _mm_storeu_si128((__m128i*)(out + i * 2 + 4), _mm_unpackhi_epi32(l, r));
+    }
+    interleaveScalar<int32_t>(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void deinterleave16SSE2(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int16_t>(output, offset, input, channels, frames);
+
+    const int16_t* in = (const int16_t*)input;
+    int16_t* left = (int16_t*)output[0] + offset;
+    int16_t* right = (int16_t*)output[1] + offset;
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((__m128i*)(in + i * 2 + 0));
+        __m128i b = _mm_loadu_si128((__m128i*)(in + i * 2 + 8));
+        __m128i la = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+        __m128i lb = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+        _mm_storeu_si128((__m128i*)(left + i), _mm_packs_epi32(la, lb));
+        _mm_storeu_si128((__m128i*)(right + i), _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)));
+    }
+    deinterleaveScalar<int16_t>(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("sse2")
+static void deinterleave32SSE2(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int32_t>(output, offset, input, channels, frames);
+
+    const float* in = (const float*)input;
+    float* left = (float*)output[0] + offset;
+    float* right = (float*)output[1] + offset;
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(in + i * 2 + 0);
+        __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    deinterleaveScalar<int32_t>(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+// Each input sample is broadcast against its row of gains, so a frame of up
+// to eight outputs builds up in two registers. A full store is taken while it
+// still ends inside output, the last frames go through a buffer.
+WAVEFORM_TARGET("sse2")
+static void remixSSE2(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs)
+{
+    __m128 row[WAVEFORM_CHANNEL_MAX][2];
+    for (size_t i = 0; i < inputs; ++i)
+    {
+        row[i][0] = _mm_loadu_ps(matrix + i * WAVEFORM_CHANNEL_MAX + 0);
+        row[i][1] = _mm_loadu_ps(matrix + i * WAVEFORM_CHANNEL_MAX + 4);
+    }
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const float* in = input + f * inputs;
+        __m128 lo = _mm_setzero_ps();
+        __m128 hi = _mm_setzero_ps();
+        for (size_t i = 0; i < inputs; ++i)
+        {
+            __m128 sample = _mm_set1_ps(in[i]);
+            lo = _mm_add_ps(lo, _mm_mul_ps(sample, row[i][0]));
+            hi = _mm_add_ps(hi, _mm_mul_ps(sample, row[i][1]));
+        }
+        float* out = output + f * outputs;
+        if (f * outputs + 8 <= frames * outputs)
+        {
+            _mm_storeu_ps(out + 0, lo);
+            _mm_storeu_ps(out + 4, hi);
+            continue;
+        }
+        float tail[8];
+        _mm_storeu_ps(tail + 0, lo);
+        _mm_storeu_ps(tail + 4, hi);
+        memcpy(out, tail, outputs * sizeof(float));
+    }
+}
+//------------------------------------------------------------------------------
+static const WaveformKernel kernelSSE2 =
+{
+    "sse2",
+    scaleSSE2,
+    scaleQ15SSE2,
+    scaleActivitySSE2,
+    scaleMeterSSE2,
+    mixSSE2,
+    mixQ15SSE2,
+    dotSSE2,
+    correlateSSE2,
+    WAVEFORM_CONVERT_TABLE(convertSSE2),
+    interleave16SSE2,
+    interleave32SSE2,
+    deinterleave16SSE2,
+    deinterleave32SSE2,
+    remixSSE2,
+};
+//==============================================================================
+// AVX2 : 16 samples per iteration
+//==============================================================================
+WAVEFORM_TARGET("avx2")
+static inline __m256i scale16AVX2(__m256i s16, __m256 vScale)
+{
+    const __m256 vMin = _mm256_set1_ps(SHRT_MIN);
+    const __m256 vMax = _mm256_set1_ps(SHRT_MAX);
+    __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(s16));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(s16, 1));
+    __m256 flo = _mm256_mul_ps(_mm256_cvtepi32_ps(lo), vScale);
+    __m256 fhi = _mm256_mul_ps(_mm256_cvtepi32_ps(hi), vScale);
+    lo = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(flo, vMin), vMax));
+    hi = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(fhi, vMin), vMax));
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void scaleAVX2(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    __m256 vScale = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i s16 = _mm256_loadu_si256((__m256i*)(input + i));
+        _mm256_storeu_si256((__m256i*)(output + i), scale16AVX2(s16, vScale));
+    }
+    if (i < samples)
+    {
+        int16_t tail[16] = {};
+        memcpy(tail, input + i, (samples - i) * sizeof(int16_t));
+        _mm256_storeu_si256((__m256i*)tail, scale16AVX2(_mm256_loadu_si256((__m256i*)tail), vScale));
+        memcpy(output + i, tail, (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+// mulhrs wraps the one product it cannot hold, -32768 by -32768, to -32768,
+// which no other product rounds to, so that lane is flipped to 32767.
+WAVEFORM_TARGET("avx2")
+static inline __m256i scaleQ15x16AVX2(__m256i s16, __m256i vScale)
+{
+    __m256i q15 = _mm256_mulhrs_epi16(s16, vScale);
+    return _mm256_xor_si256(q15, _mm256_cmpeq_epi16(q15, _mm256_set1_epi16(SHRT_MIN)));
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void scaleQ15AVX2(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    __m256i vScale = _mm256_set1_epi16(scale);
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i s16 = _mm256_loadu_si256((__m256i*)(input + i));
+        _mm256_storeu_si256((__m256i*)(output + i), scaleQ15x16AVX2(s16, vScale));
+    }
+    if (i < samples)
+    {
+        int16_t tail[16] = {};
+        memcpy(tail, input + i, (samples - i) * sizeof(int16_t));
+        _mm256_storeu_si256((__m256i*)tail, scaleQ15x16AVX2(_mm256_loadu_si256((__m256i*)tail), vScale));
+        memcpy(output + i, tail, (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+// alignr shifts within 128-bit lanes, so the lane it shifts in from is
+// brought next to the low lane of this vector with a permute first.
+template<size_t C>
+WAVEFORM_TARGET("avx2")
+static void activityAVX2(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformActivity* activity)
+{
+    size_t i = C < samples ? C : samples;
+    activityScalar(output, input, 0, i, scale, C, activity);
+
+    const __m256i vZero = _mm256_setzero_si256();
+    const __m256i vOne = _mm256_set1_epi16(1);
+    __m256 vScale = _mm256_set1_ps(scale);
+    int16_t head[16] = {};
+    memcpy(head + 16 - i, output, i * sizeof(int16_t));
+    __m256i last = _mm256_loadu_si256((__m256i*)head);
+    __m256i energy = vZero;
+    __m256i crossings = vZero;
+    size_t begin = i;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i s16 = scale16AVX2(_mm256_loadu_si256((__m256i*)(input + i)), vScale);
+        _mm256_storeu_si256((__m256i*)(output + i), s16);
+        __m256i prev = _mm256_alignr_epi8(s16, _mm256_permute2x128_si256(last, s16, 0x21), 16 - 2 * C);
+        __m256i square = _mm256_madd_epi16(s16, s16);
+        energy = _mm256_add_epi64(energy, _mm256_unpacklo_epi32(square, vZero));
+        energy = _mm256_add_epi64(energy, _mm256_unpackhi_epi32(square, vZero));
+        crossings = _mm256_add_epi32(crossings, _mm256_madd_epi16(_mm256_srli_epi16(_mm256_xor_si256(s16, prev), 15), vOne));
+        last = s16;
+    }
+    uint64_t energy64[4];
+    uint32_t crossings32[8];
+    _mm256_storeu_si256((__m256i*)energy64, energy);
+    _mm256_storeu_si256((__m256i*)crossings32, crossings);
+    for (int j = 0; j < 4; ++j)
+        activity->energy += energy64[j];
+    for (int j = 0; j < 8; ++j)
+        activity->crossings += crossings32[j];
+    activity->samples += i - begin;
+    activityScalar(output, input, i, samples, scale, C, activity);
+}
+//------------------------------------------------------------------------------
+static void scaleActivityAVX2(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformActivity* activity)
+{
+    WAVEFORM_CHANNEL_SWITCH(activityAVX2, channels, output, input, samples, scale, activity);
+    activityScalar(output, input, 0, samples, scale, channels, activity);
+}
+//------------------------------------------------------------------------------
+template<size_t C>
+WAVEFORM_TARGET("avx2")
+static void meterAVX2(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformMeter* meter)
+{
+    const size_t P = lanePeriod(C, 16);
+    const __m256i vZero = _mm256_setzero_si256();
+    __m256 vScale = _mm256_set1_ps(scale);
+    __m256i high[P];
+    __m256i low[P];
+    __m256i energy[P][4];
+    for (size_t p = 0; p < P; ++p)
+    {
+        high[p] = _mm256_set1_epi16(SHRT_MIN);
+        low[p] = _mm256_set1_epi16(SHRT_MAX);
+        for (size_t k = 0; k < 4; ++k)
+            energy[p][k] = vZero;
+    }
+    size_t i = 0;
+    for (; i + 16 * P <= samples; i += 16 * P)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            __m256i s16 = scale16AVX2(_mm256_loadu_si256((__m256i*)(input + i + 16 * p)), vScale);
+            _mm256_storeu_si256((__m256i*)(output + i + 16 * p), s16);
+            high[p] = _mm256_max_epi16(high[p], s16);
+            low[p] = _mm256_min_epi16(low[p], s16);
+            __m256i lo = _mm256_unpacklo_epi16(_mm256_mullo_epi16(s16, s16), _mm256_mulhi_epi16(s16, s16));
+            __m256i hi = _mm256_unpackhi_epi16(_mm256_mullo_epi16(s16, s16), _mm256_mulhi_epi16(s16, s16));
+            energy[p][0] = _mm256_add_epi64(energy[p][0], _mm256_unpacklo_epi32(lo, vZero));
+            energy[p][1] = _mm256_add_epi64(energy[p][1], _mm256_unpackhi_epi32(lo, vZero));
+            energy[p][2] = _mm256_add_epi64(energy[p][2], _mm256_unpacklo_epi32(hi, vZero));
+            energy[p][3] = _mm256_add_epi64(energy[p][3], _mm256_unpackhi_epi32(hi, vZero));
+        }
+    }
+    if (i)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            int16_t high16[16];
+            int16_t low16[16];
+            uint64_t energy64[16];
+            _mm256_storeu_si256((__m256i*)high16, high[p]);
+            _mm256_storeu_si256((__m256i*)low16, low[p]);
+            for (size_t k = 0; k < 4; ++k)
+                _mm256_storeu_si256((__m256i*)(energy64 + 4 * k), energy[p][k]);
+            meterFold(high16, low16, energy64, 16, p, C, meter);
+        }
+        meter->samples += i;
+    }
+    meterScalar(output, input, i, samples, scale, C, meter);
+}
+//------------------------------------------------------------------------------
+static void scaleMeterAVX2(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformMeter* meter)
+{
+    WAVEFORM_CHANNEL_SWITCH(meterAVX2, channels, output, input, samples, scale, meter);
+    meterScalar(output, input, 0, samples, scale, channels, meter);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void mixAVX2(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    __m256 vScale = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i s16 = scale16AVX2(_mm256_loadu_si256((__m256i*)(input + i)), vScale);
+        __m256i d16 = _mm256_loadu_si256((__m256i*)(output + i));
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_adds_epi16(d16, s16));
+    }
+    if (i < samples)
+    {
+        int16_t tail[2][16] = {};
+        memcpy(tail[0], input + i, (samples - i) * sizeof(int16_t));
+        memcpy(tail[1], output + i, (samples - i) * sizeof(int16_t));
+        __m256i s16 = scale16AVX2(_mm256_loadu_si256((__m256i*)tail[0]), vScale);
+        __m256i d16 = _mm256_loadu_si256((__m256i*)tail[1]);
+        _mm256_storeu_si256((__m256i*)tail[1], _mm256_adds_epi16(d16, s16));
+        memcpy(output + i, tail[1], (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void mixQ15AVX2(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    __m256i vScale = _mm256_set1_epi16(scale);
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i s16 = scaleQ15x16AVX2(_mm256_loadu_si256((__m256i*)(input + i)), vScale);
+        __m256i d16 = _mm256_loadu_si256((__m256i*)(output + i));
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_adds_epi16(d16, s16));
+    }
+    if (i < samples)
+    {
+        int16_t tail[2][16] = {};
+        memcpy(tail[0], input + i, (samples - i) * sizeof(int16_t));
+        memcpy(tail[1], output + i, (samples - i) * sizeof(int16_t));
+        __m256i s16 = scaleQ15x16AVX2(_mm256_loadu_si256((__m256i*)tail[0]), vScale);
+        __m256i d16 = _mm256_loadu_si256((__m256i*)tail[1]);
+        _mm256_storeu_si256((__m256i*)tail[1], _mm256_adds_epi16(d16, s16));
+        memcpy(output + i, tail[1], (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static int32_t dotAVX2(const int16_t* a, const int16_t* b, size_t samples)
+{
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i a16 = _mm256_loadu_si256((__m256i*)(a + i));
+        __m256i b16 = _mm256_loadu_si256((__m256i*)(b + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a16, b16));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half) + dotScalar(a + i, b + i, samples - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static float correlateAVX2(const float* a, const float* b, size_t samples)
+{
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    __m256 sum8 = _mm256_add_ps(sum0, sum1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum) + correlateScalar(a + i, b + i, samples - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static inline __m256 load8AVX2(const void* input, int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)input)));
+    case WAVEFORM_S24:
+        return _mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i*)input));
+    default:
+        return _mm256_loadu_ps((float*)input);
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static inline void store8AVX2(void* output, int format, __m256 f32)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+    {
+        __m256i s32 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(f32, _mm256_set1_ps(SHRT_MIN)), _mm256_set1_ps(SHRT_MAX)));
+        _mm_storeu_si128((__m128i*)output, _mm_packs_epi32(_mm256_castsi256_si128(s32), _mm256_extracti128_si256(s32, 1)));
+        break;
+    }
+    case WAVEFORM_S24:
+        _mm256_storeu_si256((__m256i*)output, _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(f32, _mm256_set1_ps(S24_MIN)), _mm256_set1_ps(S24_MAX))));
+        break;
+    default:
+        _mm256_storeu_ps((float*)output, f32);
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+template<int inputFormat, int outputFormat>
+WAVEFORM_TARGET("avx2")
+static void convertAVX2(void* output, const void* input, size_t samples, float scale)
+{
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+    __m256 vScale = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256 f32 = load8AVX2(in + i * sampleSize(inputFormat), inputFormat);
+        store8AVX2(out + i * sampleSize(outputFormat), outputFormat, _mm256_mul_ps(f32, vScale));
+    }
+    if (i < samples)
+    {
+        char tail[2][32] = {};
+        memcpy(tail[0], in + i * sampleSize(inputFormat), (samples - i) * sampleSize(inputFormat));
+        store8AVX2(tail[1], outputFormat, _mm256_mul_ps(load8AVX2(tail[0], inputFormat), vScale));
+        memcpy(out + i * sampleSize(outputFormat), tail[1], (samples - i) * sampleSize(outputFormat));
+    }
+}
+//------------------------------------------------------------------------------
+// Unpack works within 128-bit lanes, so the halves are put back in order
+// with a lane permute.
+WAVEFORM_TARGET("avx2")
+static void interleave16AVX2(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int16_t>(output, input, offset, channels, frames);
+
+    const int16_t* left = (const int16_t*)input[0] + offset;
+    const int16_t* right = (const int16_t*)input[1] + offset;
+    int16_t* out = (int16_t*)output;
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16)
+    {
+        __m256i l = _mm256_loadu_si256((__m256i*)(left + i));
+        __m256i r = _mm256_loadu_si256((__m256i*)(right + i));
+        __m256i lo = _mm256_unpacklo_epi16(l, r);
+        __m256i hi = _mm256_unpackhi_epi16(l, r);
+        _mm256_storeu_si256((__m256i*)(out + i * 2 + 0), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + i * 2 + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave16SSE2(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void interleave32AVX2(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int32_t>(output, input, offset, channels, frames);
+
+    const int32_t* left = (const int32_t*)input[0] + offset;
+    const int32_t* right = (const int32_t*)input[1] + offset;
+    int32_t* out = (int32_t*)output;
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m256i l = _mm256_loadu_si256((__m256i*)(left + i));
+        __m256i r = _mm256_loadu_si256((__m256i*)(right + i));
+        __m256i lo = _mm256_unpacklo_epi32(l, r);
+        __m256i hi = _mm256_unpackhi_epi32(l, r);
+        _mm256_storeu_si256((__m256i*)(out + i * 2 + 0), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + i * 2 + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave32SSE2(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void deinterleave16AVX2(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int16_t>(output, offset, input, channels, frames);
+
+    const int16_t* in = (const int16_t*)input;
+    int16_t* left = (int16_t*)output[0] + offset;
+    int16_t* right = (int16_t*)output[1] + offset;
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((__m256i*)(in + i * 2 + 0));
+        __m256i b = _mm256_loadu_si256((__m256i*)(in + i * 2 + 16));
+        __m256i la = _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16);
+        __m256i lb = _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16);
+        __m256i l = _mm256_packs_epi32(la, lb);
+        __m256i r = _mm256_packs_epi32(_mm256_srai_epi32(a, 16), _mm256_srai_epi32(b, 16));
+        _mm256_storeu_si256((__m256i*)(left + i), _mm256_permute4x64_epi64(l, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256((__m256i*)(right + i), _mm256_permute4x64_epi64(r, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    deinterleave16SSE2(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void deinterleave32AVX2(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int32_t>(output, offset, input, channels, frames);
+
+    const float* in = (const float*)input;
+    float* left = (float*)output[0] + offset;
+    float* right = (float*)output[1] + offset;
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m256 a = _mm256_loadu_ps(in + i * 2 + 0);
+        __m256 b = _mm256_loadu_ps(in + i * 2 + 8);
+        __m256d l = _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m256d r = _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(l, _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(r, _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    deinterleave32SSE2(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx2")
+static void remixAVX2(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs)
+{
+    __m256 row[WAVEFORM_CHANNEL_MAX];
+    for (size_t i = 0; i < inputs; ++i)
+    {
+        row[i] = _mm256_loadu_ps(matrix + i * WAVEFORM_CHANNEL_MAX);
+    }
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const float* in = input + f * inputs;
+        __m256 sum = _mm256_setzero_ps();
+        for (size_t i = 0; i < inputs; ++i)
+        {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(in[i]), row[i]));
+        }
+        float* out = output + f * outputs;
+        if (f * outputs + 8 <= frames * outputs)
+        {
+            _mm256_storeu_ps(out, sum);
+            continue;
+        }
+        float tail[8];
+        _mm256_storeu_ps(tail, sum);
+        memcpy(out, tail, outputs * sizeof(float));
+    }
+}
+//------------------------------------------------------------------------------
+static const WaveformKernel kernelAVX2 =
+{
+    "avx2",
+    scaleAVX2,
+    scaleQ15AVX2,
+    scaleActivityAVX2,
+    scaleMeterAVX2,
+    mixAVX2,
+    mixQ15AVX2,
+    dotAVX2,
+    correlateAVX2,
+    WAVEFORM_CONVERT_TABLE(convertAVX2),
+    interleave16AVX2,
+    interleave32AVX2,
+    deinterleave16AVX2,
+    deinterleave32AVX2,
+    remixAVX2,
+};
+//==============================================================================
+// AVX-512 : 32 samples per iteration, masked tail
+//==============================================================================
+WAVEFORM_TARGET("avx512f,avx512bw")
+static inline __m512i scale32AVX512(__m512i s16, __m512 vScale)
+{
+    const __m512 vMin = _mm512_set1_ps(SHRT_MIN);
+    const __m512 vMax = _mm512_set1_ps(SHRT_MAX);
+    __m512i lo = _mm512_cvtepi16_epi32(_mm512_castsi512_si256(s16));
+    __m512i hi = _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(s16, 1));
+    __m512 flo = _mm512_mul_ps(_mm512_cvtepi32_ps(lo), vScale);
+    __m512 fhi = _mm512_mul_ps(_mm512_cvtepi32_ps(hi), vScale);
+    lo = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(flo, vMin), vMax));
+    hi = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(fhi, vMin), vMax));
+    return _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtsepi32_epi16(lo)), _mm512_cvtsepi32_epi16(hi), 1);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void scaleAVX512(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    __m512 vScale = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 32 <= samples; i += 32)
+    {
+        __m512i s16 = _mm512_loadu_si512(input + i);
+        _mm512_storeu_si512(output + i, scale32AVX512(s16, vScale));
+    }
+    if (i < samples)
+    {
+        __mmask32 mask = _cvtu32_mask32((1u << (samples - i)) - 1);
+        __m512i s16 = _mm512_maskz_loadu_epi16(mask, input + i);
+        _mm512_mask_storeu_epi16(output + i, mask, scale32AVX512(s16, vScale));
+    }
+}
+//------------------------------------------------------------------------------
+// The same wrapped lane as scaleQ15x16AVX2, set back to 32767 under a mask.
+WAVEFORM_TARGET("avx512f,avx512bw")
+static inline __m512i scaleQ15x32AVX512(__m512i s16, __m512i vScale)
+{
+    __m512i q15 = _mm512_mulhrs_epi16(s16, vScale);
+    __mmask32 wrap = _mm512_cmpeq_epi16_mask(q15, _mm512_set1_epi16(SHRT_MIN));
+    return _mm512_mask_mov_epi16(q15, wrap, _mm512_set1_epi16(SHRT_MAX));
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void scaleQ15AVX512(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    __m512i vScale = _mm512_set1_epi16(scale);
+    size_t i = 0;
+    for (; i + 32 <= samples; i += 32)
+    {
+        __m512i s16 = _mm512_loadu_si512(input + i);
+        _mm512_storeu_si512(output + i, scaleQ15x32AVX512(s16, vScale));
+    }
+    if (i < samples)
+    {
+        __mmask32 mask = _cvtu32_mask32((1u << (samples - i)) - 1);
+        __m512i s16 = _mm512_maskz_loadu_epi16(mask, input + i);
+        _mm512_mask_storeu_epi16(output + i, mask, scaleQ15x32AVX512(s16, vScale));
+    }
+}
+//------------------------------------------------------------------------------
+// A two-source permute with a fixed index picks the sample a frame back from
+// the last vector and this one, so any channel count up to 32 runs here.
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void scaleActivityAVX512(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformActivity* activity)
+{
+    if (channels == 0 || channels > 32)
+    {
+        activityScalar(output, input, 0, samples, scale, channels, activity);
+        return;
+    }
+    size_t i = channels < samples ? channels : samples;
+    activityScalar(output, input, 0, i, scale, channels, activity);
+
+    const __m512i vZero = _mm512_setzero_si512();
+    const __m512i vOne = _mm512_set1_epi16(1);
+    __m512 vScale = _mm512_set1_ps(scale);
+    int16_t head[32] = {};
+    int16_t index[32];
+    memcpy(head + 32 - i, output, i * sizeof(int16_t));
+    for (size_t j = 0; j < 32; ++j)
+        index[j] = int16_t(j + 32 - channels);
+    __m512i vIndex = _mm512_loadu_si512(index);
+    __m512i last = _mm512_loadu_si512(head);
+    __m512i energy = vZero;
+    __m512i crossings = vZero;
+    size_t begin = i;
+    for (; i + 32 <= samples; i += 32)
+    {
+        __m512i s16 = scale32AVX512(_mm512_loadu_si512(input + i), vScale);
+        _mm512_storeu_si512(output + i, s16);
+        __m512i prev = _mm512_permutex2var_epi16(last, vIndex, s16);
+        __m512i square = _mm512_madd_epi16(s16, s16);
+        energy = _mm512_add_epi64(energy, _mm512_unpacklo_epi32(square, vZero));
+        energy = _mm512_add_epi64(energy, _mm512_unpackhi_epi32(square, vZero));
+        crossings = _mm512_add_epi32(crossings, _mm512_madd_epi16(_mm512_srli_epi16(_mm512_xor_si512(s16, prev), 15), vOne));
+        last = s16;
+    }
+    activity->energy += uint64_t(_mm512_reduce_add_epi64(energy));
+    activity->crossings += uint32_t(_mm512_reduce_add_epi32(crossings));
+    activity->samples += i - begin;
+    activityScalar(output, input, i, samples, scale, channels, activity);
+}
+//------------------------------------------------------------------------------
+template<size_t C>
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void meterAVX512(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformMeter* meter)
+{
+    const size_t P = lanePeriod(C, 32);
+    const __m512i vZero = _mm512_setzero_si512();
+    __m512 vScale = _mm512_set1_ps(scale);
+    __m512i high[P];
+    __m512i low[P];
+    __m512i energy[P][4];
+    for (size_t p = 0; p < P; ++p)
+    {
+        high[p] = _mm512_set1_epi16(SHRT_MIN);
+        low[p] = _mm512_set1_epi16(SHRT_MAX);
+        for (size_t k = 0; k < 4; ++k)
+            energy[p][k] = vZero;
+    }
+    size_t i = 0;
+    for (; i + 32 * P <= samples; i += 32 * P)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            __m512i s16 = scale32AVX512(_mm512_loadu_si512(input + i + 32 * p), vScale);
+            _mm512_storeu_si512(output + i + 32 * p, s16);
+            high[p] = _mm512_max_epi16(high[p], s16);
+            low[p] = _mm512_min_epi16(low[p], s16);
+            __m512i lo = _mm512_unpacklo_epi16(_mm512_mullo_epi16(s16, s16), _mm512_mulhi_epi16(s16, s16));
+            __m512i hi = _mm512_unpackhi_epi16(_mm512_mullo_epi16(s16, s16), _mm512_mulhi_epi16(s16, s16));
+            energy[p][0] = _mm512_add_epi64(energy[p][0], _mm512_unpacklo_epi32(lo, vZero));
+            energy[p][1] = _mm512_add_epi64(energy[p][1], _mm512_unpackhi_epi32(lo, vZero));
+            energy[p][2] = _mm512_add_epi64(energy[p][2], _mm512_unpacklo_epi32(hi, vZero));
+            energy[p][3] = _mm512_add_epi64(energy[p][3], _mm512_unpackhi_epi32(hi, vZero));
+        }
+    }
+    if (i)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            int16_t high16[32];
+            int16_t low16[32];
+            uint64_t energy64[32];
+            _mm512_storeu_si512(high16, high[p]);
+            _mm512_storeu_si512(low16, low[p]);
+            for (size_t k = 0; k < 4; ++k)
+                _mm512_storeu_si512(energy64 + 8 * k, energy[p][k]);
+            meterFold(high16, low16, energy64, 32, p, C, meter);
+        }
+        meter->samples += i;
+    }
+    meterScalar(output, input, i, samples, scale, C, meter);
+}
+//------------------------------------------------------------------------------
+static void scaleMeterAVX512(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformMeter* meter)
+{
+    WAVEFORM_CHANNEL_SWITCH(meterAVX512, channels, output, input, samples, scale, meter);
+    meterScalar(output, input, 0, samples, scale, channels, meter);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void mixAVX512(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    __m512 vScale = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 32 <= samples; i += 32)
+    {
+        __m512i s16 = scale32AVX512(_mm512_loadu_si512(input + i), vScale);
+        __m512i d16 = _mm512_loadu_si512(output + i);
+        _mm512_storeu_si512(output + i, _mm512_adds_epi16(d16, s16));
+    }
+    if (i < samples)
+    {
+        __mmask32 mask = _cvtu32_mask32((1u << (samples - i)) - 1);
+        __m512i s16 = scale32AVX512(_mm512_maskz_loadu_epi16(mask, input + i), vScale);
+        __m512i d16 = _mm512_maskz_loadu_epi16(mask, output + i);
+        _mm512_mask_storeu_epi16(output + i, mask, _mm512_adds_epi16(d16, s16));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void mixQ15AVX512(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    __m512i vScale = _mm512_set1_epi16(scale);
+    size_t i = 0;
+    for (; i + 32 <= samples; i += 32)
+    {
+        __m512i s16 = scaleQ15x32AVX512(_mm512_loadu_si512(input + i), vScale);
+        __m512i d16 = _mm512_loadu_si512(output + i);
+        _mm512_storeu_si512(output + i, _mm512_adds_epi16(d16, s16));
+    }
+    if (i < samples)
+    {
+        __mmask32 mask = _cvtu32_mask32((1u << (samples - i)) - 1);
+        __m512i s16 = scaleQ15x32AVX512(_mm512_maskz_loadu_epi16(mask, input + i), vScale);
+        __m512i d16 = _mm512_maskz_loadu_epi16(mask, output + i);
+        _mm512_mask_storeu_epi16(output + i, mask, _mm512_adds_epi16(d16, s16));
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static int32_t dotAVX512(const int16_t* a, const int16_t* b, size_t samples)
+{
+    __m512i sum = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= samples; i += 32)
+    {
+        __m512i a16 = _mm512_loadu_si512(a + i);
+        __m512i b16 = _mm512_loadu_si512(b + i);
+        sum = _mm512_add_epi32(sum, _mm512_madd_epi16(a16, b16));
+    }
+    if (i < samples)
+    {
+        __mmask32 mask = _cvtu32_mask32((1u << (samples - i)) - 1);
+        __m512i a16 = _mm512_maskz_loadu_epi16(mask, a + i);
+        __m512i b16 = _mm512_maskz_loadu_epi16(mask, b + i);
+        sum = _mm512_add_epi32(sum, _mm512_madd_epi16(a16, b16));
+    }
+    __m256i quarter = _mm256_add_epi32(_mm512_castsi512_si256(sum), _mm512_extracti64x4_epi64(sum, 1));
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(quarter), _mm256_extracti128_si256(quarter, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static float correlateAVX512(const float* a, const float* b, size_t samples)
+{
+    __m512 sum = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        sum = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum);
+    }
+    if (i < samples)
+    {
+        __mmask16 mask = _cvtu32_mask16((1u << (samples - i)) - 1);
+        sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), sum);
+    }
+    return _mm512_reduce_add_ps(sum);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static inline __m512 load16AVX512(const void* input, int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i*)input)));
+    case WAVEFORM_S24:
+        return _mm512_cvtepi32_ps(_mm512_loadu_si512(input));
+    default:
+        return _mm512_loadu_ps(input);
+    }
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static inline void store16AVX512(void* output, int format, __m512 f32)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+    {
+        __m512i s32 = _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(f32, _mm512_set1_ps(SHRT_MIN)), _mm512_set1_ps(SHRT_MAX)));
+        _mm256_storeu_si256((__m256i*)output, _mm512_cvtsepi32_epi16(s32));
+        break;
+    }
+    case WAVEFORM_S24:
+        _mm512_storeu_si512(output, _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(f32, _mm512_set1_ps(S24_MIN)), _mm512_set1_ps(S24_MAX))));
+        break;
+    default:
+        _mm512_storeu_ps(output, f32);
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+// 16-bit lanes would need AVX512VL for a masked tail, so the tail goes
+// through a buffer as in the narrower kernels.
+template<int inputFormat, int outputFormat>
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void convertAVX512(void* output, const void* input, size_t samples, float scale)
+{
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+    __m512 vScale = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m512 f32 = load16AVX512(in + i * sampleSize(inputFormat), inputFormat);
+        store16AVX512(out + i * sampleSize(outputFormat), outputFormat, _mm512_mul_ps(f32, vScale));
+    }
+    if (i < samples)
+    {
+        char tail[2][64] = {};
+        memcpy(tail[0], in + i * sampleSize(inputFormat), (samples - i) * sampleSize(inputFormat));
+        store16AVX512(tail[1], outputFormat, _mm512_mul_ps(load16AVX512(tail[0], inputFormat), vScale));
+        memcpy(out + i * sampleSize(outputFormat), tail[1], (samples - i) * sampleSize(outputFormat));
+    }
+}
+//------------------------------------------------------------------------------
+// A two-source permute does the whole shuffle, the tail falls back to AVX2.
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void interleave16AVX512(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int16_t>(output, input, offset, channels, frames);
+
+    const int16_t* left = (const int16_t*)input[0] + offset;
+    const int16_t* right = (const int16_t*)input[1] + offset;
+    int16_t* out = (int16_t*)output;
+    static const int16_t index[32] = { 0, 32, 1, 33, 2, 34, 3, 35, 4, 36, 5, 37, 6, 38, 7, 39,
+                                       8, 40, 9, 41, 10, 42, 11, 43, 12, 44, 13, 45, 14, 46, 15, 47 };
+    const __m512i lo = _mm512_loadu_si512(index);
+    const __m512i hi = _mm512_add_epi16(lo, _mm512_set1_epi16(16));
+    size_t i = 0;
+    for (; i + 32 <= frames; i += 32)
+    {
+        __m512i l = _mm512_loadu_si512(left + i);
+        __m512i r = _mm512_loadu_si512(right + i);
+        _mm512_storeu_si512(out + i * 2 + 0, _mm512_permutex2var_epi16(l, lo, r));
+        _mm512_storeu_si512(out + i * 2 + 32, _mm512_permutex2var_epi16(l, hi, r));
+    }
+    interleave16AVX2(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void interleave32AVX512(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int32_t>(output, input, offset, channels, frames);
+
+    const int32_t* left = (const int32_t*)input[0] + offset;
+    const int32_t* right = (const int32_t*)input[1] + offset;
+    int32_t* out = (int32_t*)output;
+    const __m512i lo = _mm512_set_epi32(23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0);
+    const __m512i hi = _mm512_add_epi32(lo, _mm512_set1_epi32(8));
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16)
+    {
+        __m512i l = _mm512_loadu_si512(left + i);
+        __m512i r = _mm512_loadu_si512(right + i);
+        _mm512_storeu_si512(out + i * 2 + 0, _mm512_permutex2var_epi32(l, lo, r));
+        _mm512_storeu_si512(out + i * 2 + 16, _mm512_permutex2var_epi32(l, hi, r));
+    }
+    interleave32AVX2(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void deinterleave16AVX512(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int16_t>(output, offset, input, channels, frames);
+
+    const int16_t* in = (const int16_t*)input;
+    int16_t* left = (int16_t*)output[0] + offset;
+    int16_t* right = (int16_t*)output[1] + offset;
+    static const int16_t index[32] = { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
+                                       32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62 };
+    const __m512i even = _mm512_loadu_si512(index);
+    const __m512i odd = _mm512_add_epi16(even, _mm512_set1_epi16(1));
+    size_t i = 0;
+    for (; i + 32 <= frames; i += 32)
+    {
+        __m512i a = _mm512_loadu_si512(in + i * 2 + 0);
+        __m512i b = _mm512_loadu_si512(in + i * 2 + 32);
+        _mm512_storeu_si512(left + i, _mm512_permutex2var_epi16(a, even, b));
+        _mm512_storeu_si512(right + i, _mm512_permutex2var_epi16(a, odd, b));
+    }
+    deinterleave16AVX2(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+WAVEFORM_TARGET("avx512f,avx512bw")
+static void deinterleave32AVX512(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int32_t>(output, offset, input, channels, frames);
+
+    const int32_t* in = (const int32_t*)input;
+    int32_t* left = (int32_t*)output[0] + offset;
+    int32_t* right = (int32_t*)output[1] + offset;
+    const __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd = _mm512_add_epi32(even, _mm512_set1_epi32(1));
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16)
+    {
+        __m512i a = _mm512_loadu_si512(in + i * 2 + 0);
+        __m512i b = _mm512_loadu_si512(in + i * 2 + 16);
+        _mm512_storeu_si512(left + i, _mm512_permutex2var_epi32(a, even, b));
+        _mm512_storeu_si512(right + i, _mm512_permutex2var_epi32(a, odd, b));
+    }
+    deinterleave32AVX2(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+// A frame holds at most eight outputs, so remix keeps the AVX2 kernel.
+static const WaveformKernel kernelAVX512 =
+{
+    "avx512",
+    scaleAVX512,
+    scaleQ15AVX512,
+    scaleActivityAVX512,
+    scaleMeterAVX512,
+    mixAVX512,
+    mixQ15AVX512,
+    dotAVX512,
+    correlateAVX512,
+    WAVEFORM_CONVERT_TABLE(convertAVX512),
+    interleave16AVX512,
+    interleave32AVX512,
+    deinterleave16AVX512,
+    deinterleave32AVX512,
+    remixAVX2,
+};
+#endif
+#if WAVEFORM_NEON_ENABLE
+//==============================================================================
+// NEON : 8 samples per iteration
+//==============================================================================
+static inline int32x4_t roundNEON(float32x4_t f32)
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vcvtnq_s32_f32(f32);
+#else
+    uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(f32), vdupq_n_u32(0x80000000));
+    float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+    return vcvtq_s32_f32(vaddq_f32(f32, half));
+#endif
+}
+//------------------------------------------------------------------------------
+static inline int16x8_t scale8NEON(int16x8_t s16, float32x4_t vScale)
+{
+    const float32x4_t vMin = vdupq_n_f32(SHRT_MIN);
+    const float32x4_t vMax = vdupq_n_f32(SHRT_MAX);
+    float32x4_t flo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16))), vScale);
+    float32x4_t fhi = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16))), vScale);
+    int32x4_t lo = roundNEON(vminq_f32(vmaxq_f32(flo, vMin), vMax));
+    int32x4_t hi = roundNEON(vminq_f32(vmaxq_f32(fhi, vMin), vMax));
+    return vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+}
+//------------------------------------------------------------------------------
+static void scaleNEON(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    float32x4_t vScale = vdupq_n_f32(scale);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        vst1q_s16(output + i, scale8NEON(vld1q_s16(input + i), vScale));
+    }
+    if (i < samples)
+    {
+        int16_t tail[8] = {};
+        memcpy(tail, input + i, (samples - i) * sizeof(int16_t));
+        vst1q_s16(tail, scale8NEON(vld1q_s16(tail), vScale));
+        memcpy(output + i, tail, (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+static void scaleQ15NEON(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        vst1q_s16(output + i, vqrdmulhq_n_s16(vld1q_s16(input + i), scale));
+    }
+    if (i < samples)
+    {
+        int16_t tail[8] = {};
+        memcpy(tail, input + i, (samples - i) * sizeof(int16_t));
+        vst1q_s16(tail, vqrdmulhq_n_s16(vld1q_s16(tail), scale));
+        memcpy(output + i, tail, (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+// vext takes an immediate, so the channel count is a template argument.
+template<size_t C>
+static void activityNEON(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformActivity* activity)
+{
+    size_t i = C < samples ? C : samples;
+    activityScalar(output, input, 0, i, scale, C, activity);
+
+    float32x4_t vScale = vdupq_n_f32(scale);
+    int16_t head[8] = {};
+    memcpy(head + 8 - i, output, i * sizeof(int16_t));
+    int16x8_t last = vld1q_s16(head);
+    uint64x2_t energy = vdupq_n_u64(0);
+    uint32x4_t crossings = vdupq_n_u32(0);
+    size_t begin = i;
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t s16 = scale8NEON(vld1q_s16(input + i), vScale);
+        vst1q_s16(output + i, s16);
+        int16x8_t prev = vextq_s16(last, s16, 8 - C);
+        int32x4_t lo = vmull_s16(vget_low_s16(s16), vget_low_s16(s16));
+        int32x4_t hi = vmull_s16(vget_high_s16(s16), vget_high_s16(s16));
+        energy = vpadalq_u32(energy, vreinterpretq_u32_s32(lo));
+        energy = vpadalq_u32(energy, vreinterpretq_u32_s32(hi));
+        crossings = vpadalq_u16(crossings, vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(s16, prev)), 15));
+        last = s16;
+    }
+    uint64x2_t count = vpaddlq_u32(crossings);
+    activity->energy += vgetq_lane_u64(energy, 0) + vgetq_lane_u64(energy, 1);
+    activity->crossings += vgetq_lane_u64(count, 0) + vgetq_lane_u64(count, 1);
+    activity->samples += i - begin;
+    activityScalar(output, input, i, samples, scale, C, activity);
+}
+//------------------------------------------------------------------------------
+static void scaleActivityNEON(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformActivity* activity)
+{
+    WAVEFORM_CHANNEL_SWITCH(activityNEON, channels, output, input, samples, scale, activity);
+    activityScalar(output, input, 0, samples, scale, channels, activity);
+}
+//------------------------------------------------------------------------------
+template<size_t C>
+static void meterNEON(int16_t* output, const int16_t* input, size_t samples, float scale, WaveformMeter* meter)
+{
+    const size_t P = lanePeriod(C, 8);
+    float32x4_t vScale = vdupq_n_f32(scale);
+    int16x8_t high[P];
+    int16x8_t low[P];
+    uint64x2_t energy[P][4];
+    for (size_t p = 0; p < P; ++p)
+    {
+        high[p] = vdupq_n_s16(SHRT_MIN);
+        low[p] = vdupq_n_s16(SHRT_MAX);
+        for (size_t k = 0; k < 4; ++k)
+            energy[p][k] = vdupq_n_u64(0);
+    }
+    size_t i = 0;
+    for (; i + 8 * P <= samples; i += 8 * P)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            int16x8_t s16 = scale8NEON(vld1q_s16(input + i + 8 * p), vScale);
+            vst1q_s16(output + i + 8 * p, s16);
+            high[p] = vmaxq_s16(high[p], s16);
+            low[p] = vminq_s16(low[p], s16);
+            uint32x4_t lo = vreinterpretq_u32_s32(vmull_s16(vget_low_s16(s16), vget_low_s16(s16)));
+            uint32x4_t hi = vreinterpretq_u32_s32(vmull_s16(vget_high_s16(s16), vget_high_s16(s16)));
+            energy[p][0] = vaddw_u32(energy[p][0], vget_low_u32(lo));
+            energy[p][1] = vaddw_u32(energy[p][1], vget_high_u32(lo));
+            energy[p][2] = vaddw_u32(energy[p][2], vget_low_u32(hi));
+            energy[p][3] = vaddw_u32(energy[p][3], vget_high_u32(hi));
+        }
+    }
+    if (i)
+    {
+        for (size_t p = 0; p < P; ++p)
+        {
+            int16_t high16[8];
+            int16_t low16[8];
+            uint64_t energy64[8];
+            vst1q_s16(high16, high[p]);
+            vst1q_s16(low16, low[p]);
+            for (size_t k = 0; k < 4; ++k)
+                vst1q_u64(energy64 + 2 * k, energy[p][k]);
+            meterFold(high16, low16, energy64, 8, p, C, meter);
+        }
+        meter->samples += i;
+    }
+    meterScalar(output, input, i, samples, scale, C, meter);
+}
+//------------------------------------------------------------------------------
+static void scaleMeterNEON(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformMeter* meter)
+{
+    WAVEFORM_CHANNEL_SWITCH(meterNEON, channels, output, input, samples, scale, meter);
+    meterScalar(output, input, 0, samples, scale, channels, meter);
+}
+//------------------------------------------------------------------------------
+static void mixNEON(int16_t* output, const int16_t* input, size_t samples, float scale)
+{
+    float32x4_t vScale = vdupq_n_f32(scale);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t s16 = scale8NEON(vld1q_s16(input + i), vScale);
+        vst1q_s16(output + i, vqaddq_s16(vld1q_s16(output + i), s16));
+    }
+    if (i < samples)
+    {
+        int16_t tail[2][8] = {};
+        memcpy(tail[0], input + i, (samples - i) * sizeof(int16_t));
+        memcpy(tail[1], output + i, (samples - i) * sizeof(int16_t));
+        int16x8_t s16 = scale8NEON(vld1q_s16(tail[0]), vScale);
+        vst1q_s16(tail[1], vqaddq_s16(vld1q_s16(tail[1]), s16));
+        memcpy(output + i, tail[1], (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+static void mixQ15NEON(int16_t* output, const int16_t* input, size_t samples, int16_t scale)
+{
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t s16 = vqrdmulhq_n_s16(vld1q_s16(input + i), scale);
+        vst1q_s16(output + i, vqaddq_s16(vld1q_s16(output + i), s16));
+    }
+    if (i < samples)
+    {
+        int16_t tail[2][8] = {};
+        memcpy(tail[0], input + i, (samples - i) * sizeof(int16_t));
+        memcpy(tail[1], output + i, (samples - i) * sizeof(int16_t));
+        int16x8_t s16 = vqrdmulhq_n_s16(vld1q_s16(tail[0]), scale);
+        vst1q_s16(tail[1], vqaddq_s16(vld1q_s16(tail[1]), s16));
+        memcpy(output + i, tail[1], (samples - i) * sizeof(int16_t));
+    }
+}
+//------------------------------------------------------------------------------
+static int32_t dotNEON(const int16_t* a, const int16_t* b, size_t samples)
+{
+    int32x4_t sum = vdupq_n_s32(0);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t a16 = vld1q_s16(a + i);
+        int16x8_t b16 = vld1q_s16(b + i);
+        sum = vmlal_s16(sum, vget_low_s16(a16), vget_low_s16(b16));
+        sum = vmlal_s16(sum, vget_high_s16(a16), vget_high_s16(b16));
+    }
+#if defined(__aarch64__) || defined(_M_ARM64)
+    int32_t total = vaddvq_s32(sum);
+#else
+    int32x2_t pair = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+    int32_t total = vget_lane_s32(vpadd_s32(pair, pair), 0);
+#endif
+    return total + dotScalar(a + i, b + i, samples - i);
+}
+//------------------------------------------------------------------------------
+static float correlateNEON(const float* a, const float* b, size_t samples)
+{
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t sum = vaddq_f32(sum0, sum1);
+#if defined(__aarch64__) || defined(_M_ARM64)
+    float total = vaddvq_f32(sum);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    float total = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+    return total + correlateScalar(a + i, b + i, samples - i);
+}
+//------------------------------------------------------------------------------
+static inline float32x4_t load4NEON(const void* input, int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        return vcvtq_f32_s32(vmovl_s16(vld1_s16((const int16_t*)input)));
+    case WAVEFORM_S24:
+        return vcvtq_f32_s32(vld1q_s32((const int32_t*)input));
+    default:
+        return vld1q_f32((const float*)input);
+    }
+}
+//------------------------------------------------------------------------------
+static inline void store4NEON(void* output, int format, float32x4_t f32)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+    {
+        int32x4_t s32 = roundNEON(vminq_f32(vmaxq_f32(f32, vdupq_n_f32(SHRT_MIN)), vdupq_n_f32(SHRT_MAX)));
+        vst1_s16((int16_t*)output, vqmovn_s32(s32));
+        break;
+    }
+    case WAVEFORM_S24:
+        vst1q_s32((int32_t*)output, roundNEON(vminq_f32(vmaxq_f32(f32, vdupq_n_f32(S24_MIN)), vdupq_n_f32(S24_MAX))));
+        break;
+    default:
+        vst1q_f32((float*)output, f32);
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+template<int inputFormat, int outputFormat>
+static void convertNEON(void* output, const void* input, size_t samples, float scale)
+{
+    const char* in = (const char*)input;
+    char* out = (char*)output;
+    float32x4_t vScale = vdupq_n_f32(scale);
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4)
+    {
+        float32x4_t f32 = load4NEON(in + i * sampleSize(inputFormat), inputFormat);
+        store4NEON(out + i * sampleSize(outputFormat), outputFormat, vmulq_f32(f32, vScale));
+    }
+    if (i < samples)
+    {
+        char tail[2][16] = {};
+        memcpy(tail[0], in + i * sampleSize(inputFormat), (samples - i) * sampleSize(inputFormat));
+        store4NEON(tail[1], outputFormat, vmulq_f32(load4NEON(tail[0], inputFormat), vScale));
+        memcpy(out + i * sampleSize(outputFormat), tail[1], (samples - i) * sampleSize(outputFormat));
+    }
+}
+//------------------------------------------------------------------------------
+// The structured loads and stores interleave stereo on their own.
+static void interleave16NEON(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int16_t>(output, input, offset, channels, frames);
+
+    const int16_t* left = (const int16_t*)input[0] + offset;
+    const int16_t* right = (const int16_t*)input[1] + offset;
+    int16_t* out = (int16_t*)output;
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        int16x8x2_t lr = { { vld1q_s16(left + i), vld1q_s16(right + i) } };
+        vst2q_s16(out + i * 2, lr);
+    }
+    interleaveScalar<int16_t>(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+static void interleave32NEON(void* output, const void* const* input, size_t offset, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return interleaveScalar<int32_t>(output, input, offset, channels, frames);
+
+    const int32_t* left = (const int32_t*)input[0] + offset;
+    const int32_t* right = (const int32_t*)input[1] + offset;
+    int32_t* out = (int32_t*)output;
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        int32x4x2_t lr = { { vld1q_s32(left + i), vld1q_s32(right + i) } };
+        vst2q_s32(out + i * 2, lr);
+    }
+    interleaveScalar<int32_t>(out + i * 2, input, offset + i, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+static void deinterleave16NEON(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int16_t>(output, offset, input, channels, frames);
+
+    const int16_t* in = (const int16_t*)input;
+    int16_t* left = (int16_t*)output[0] + offset;
+    int16_t* right = (int16_t*)output[1] + offset;
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        int16x8x2_t lr = vld2q_s16(in + i * 2);
+        vst1q_s16(left + i, lr.val[0]);
+        vst1q_s16(right + i, lr.val[1]);
+    }
+    deinterleaveScalar<int16_t>(output, offset + i, in + i * 2, channels, frames - i);
+}
 //------------------------------------------------------------------------------
+static void deinterleave32NEON(void* const* output, size_t offset, const void* input, size_t channels, size_t frames)
+{
+    if (channels != 2)
+        return deinterleaveScalar<int32_t>(output, offset, input, channels, frames);
+
+    const int32_t* in = (const int32_t*)input;
+    int32_t* left = (int32_t*)output[0] + offset;
+    int32_t* right = (int32_t*)output[1] + offset;
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        int32x4x2_t lr = vld2q_s32(in + i * 2);
+        vst1q_s32(left + i, lr.val[0]);
+        vst1q_s32(right + i, lr.val[1]);
+    }
+    deinterleaveScalar<int32_t>(output, offset + i, in + i * 2, channels, frames - i);
+}
+//------------------------------------------------------------------------------
+static void remixNEON(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs)
+{
+    float32x4_t row[WAVEFORM_CHANNEL_MAX][2];
+    for (size_t i = 0; i < inputs; ++i)
+    {
+        row[i][0] = vld1q_f32(matrix + i * WAVEFORM_CHANNEL_MAX + 0);
+        row[i][1] = vld1q_f32(matrix + i * WAVEFORM_CHANNEL_MAX + 4);
+    }
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const float* in = input + f * inputs;
+        float32x4_t lo = vdupq_n_f32(0.0f);
+        float32x4_t hi = vdupq_n_f32(0.0f);
+        for (size_t i = 0; i < inputs; ++i)
+        {
+            lo = vaddq_f32(lo, vmulq_n_f32(row[i][0], in[i]));
+            hi = vaddq_f32(hi, vmulq_n_f32(row[i][1], in[i]));
+        }
+        float* out = output + f * outputs;
+        if (f * outputs + 8 <= frames * outputs)
+        {
+            vst1q_f32(out + 0, lo);
+            vst1q_f32(out + 4, hi);
+            continue;
+        }
+        float tail[8];
+        vst1q_f32(tail + 0, lo);
+        vst1q_f32(tail + 4, hi);
+        memcpy(out, tail, outputs * sizeof(float));
+    }
+}
+//------------------------------------------------------------------------------
+static const WaveformKernel kernelNEON =
+{
+    "neon",
+    scaleNEON,
+    scaleQ15NEON,
+    scaleActivityNEON,
+    scaleMeterNEON,
+    mixNEON,
+    mixQ15NEON,
+    dotNEON,
+    correlateNEON,
+    WAVEFORM_CONVERT_TABLE(convertNEON),
+    interleave16NEON,
+    interleave32NEON,
+    deinterleave16NEON,
+    deinterleave32NEON,
+    remixNEON,
+};
+#endif
+//==============================================================================
+// Dispatch
+//==============================================================================
+static int waveformDetect()
+{
+#if WAVEFORM_NEON_ENABLE
+    return WAVEFORM_NEON;
+#elif WAVEFORM_X86_ENABLE
+#   if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    int count = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool avx2 = false;
+    bool avx512 = false;
+    if (count >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+        avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && (xcr0 & 0xE6) == 0xE6;
+    }
+#   else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#   endif
+    if (avx512)
+        return WAVEFORM_AVX512;
+    if (avx2)
+        return WAVEFORM_AVX2;
+    if (sse2)
+        return WAVEFORM_SSE2;
+    return WAVEFORM_SCALAR;
+#else
+    return WAVEFORM_SCALAR;
+#endif
+}
+//------------------------------------------------------------------------------
+const WaveformKernel* waveformKernel(int isa)
+{
+    static const int best = waveformDetect();
+    if (isa < 0)
+        isa = best;
+
+    switch (isa)
+    {
+    case WAVEFORM_SCALAR:
+        return &kernelScalar;
+#if WAVEFORM_X86_ENABLE
+    case WAVEFORM_SSE2:
+        return best >= WAVEFORM_SSE2 ? &kernelSSE2 : nullptr;
+    case WAVEFORM_AVX2:
+        return best >= WAVEFORM_AVX2 ? &kernelAVX2 : nullptr;
+    case WAVEFORM_AVX512:
+        return best >= WAVEFORM_AVX512 ? &kernelAVX512 : nullptr;
+#endif
+#if WAVEFORM_NEON_ENABLE
+    case WAVEFORM_NEON:
+        return &kernelNEON;
+#endif
+    default:
+        break;
+    }
+
+    return nullptr;
+}
+//==============================================================================
+// Utility
+//==============================================================================
 void scaleWaveform(int16_t* waveform, size_t count, float scale)
 {
     if (scale == 1.0f)
         return;
+    scaleWaveform(waveform, waveform, count, scale);
+}
+//------------------------------------------------------------------------------
+void scaleWaveform(int16_t* output, const int16_t* input, size_t count, float scale)
+{
+    size_t samples = count / sizeof(int16_t);
+    if (scale == 1.0f)
+    {
+        if (output != input)
+        {
+            memcpy(output, input, samples * sizeof(int16_t));
+        }
+        return;
+    }
     if (scale <= 0.0f)
     {
-        memset(waveform, 0, count);
+        memset(output, 0, samples * sizeof(int16_t));
         return;
     }
 
-#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(_M_ARM) || defined(_M_ARM64)
-    float32x4_t vScale = vdupq_n_f32(scale);
-    for (size_t i = 0, size = count / sizeof(int16_t); i < size; i += 4)
+    static const WaveformKernel* kernel = waveformKernel();
+    if (scale < 1.0f)
     {
-        int16x4_t s16 = vld1_s16(waveform + i);
-        int32x4_t s32 = vmovl_s16(s16);
-        float32x4_t f32 = vcvtq_f32_s32(s32);
-        f32 = vmulq_f32(f32, vScale);
-        s32 = vcvtq_s32_f32(f32);
-        s16 = vqmovn_s32(s32);
-        vst1_s16(waveform + i, s16);
+        kernel->scaleQ15(output, input, samples, int16_t(lrintf(fminf(scale * 32768.0f, SHRT_MAX))));
+        return;
     }
-#elif defined(_M_IX86) || defined(_M_AMD64) || defined(__i386__) || defined(__amd64__)
-    __m128 vScale = _mm_set1_ps(scale);
-    for (size_t i = 0, size = count / sizeof(int16_t); i < size; i += 4)
+    kernel->scale(output, input, samples, scale);
+}
+//------------------------------------------------------------------------------
+void scaleWaveform(int16_t* output, const int16_t* input, size_t count, float scale, size_t channels, WaveformActivity* activity)
+{
+    if (activity == nullptr)
     {
-        __m128i s16 = _mm_loadu_si64(waveform + i);
-        __m128i s32 = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
-        __m128 f32 = _mm_cvtepi32_ps(s32);
-        f32 = _mm_mul_ps(f32, vScale);
-        s32 = _mm_cvtps_epi32(f32);
-        s16 = _mm_packs_epi32(s32, s32);
-        _mm_storeu_si64(waveform + i, s16);
+        scaleWaveform(output, input, count, scale);
+        return;
     }
-#else
-    for (size_t i = 0, size = count / sizeof(int16_t); i < size; ++i)
+
+    static const WaveformKernel* kernel = waveformKernel();
+    kernel->scaleActivity(output, input, count / sizeof(int16_t), scale > 0.0f ? scale : 0.0f, channels, activity);
+}
+//------------------------------------------------------------------------------
+void scaleWaveform(int16_t* output, const int16_t* input, size_t count, float scale, size_t channels, WaveformMeter* meter)
+{
+    if (meter == nullptr || channels == 0 || channels > WAVEFORM_CHANNEL_MAX)
     {
-        float scaled = waveform[i] * scale;
-        waveform[i] = fminf(fmaxf(scaled, SHRT_MIN), SHRT_MAX);
+        scaleWaveform(output, input, count, scale);
+        return;
     }
-#endif
+
+    static const WaveformKernel* kernel = waveformKernel();
+    kernel->scaleMeter(output, input, count / sizeof(int16_t), scale > 0.0f ? scale : 0.0f, channels, meter);
+}
+//------------------------------------------------------------------------------
+void mixWaveform(int16_t* output, const int16_t* input, size_t count, float scale)
+{
+    size_t samples = count / sizeof(int16_t);
+    if (scale <= 0.0f)
+        return;
+
+    static const WaveformKernel* kernel = waveformKernel();
+    if (scale < 1.0f)
+    {
+        kernel->mixQ15(output, input, samples, int16_t(lrintf(fminf(scale * 32768.0f, SHRT_MAX))));
+        return;
+    }
+    kernel->mix(output, input, samples, scale);
+}
+//------------------------------------------------------------------------------
+float correlateWaveform(const float* a, const float* b, size_t samples)
+{
+    static const WaveformKernel* kernel = waveformKernel();
+    return kernel->correlate(a, b, samples);
+}
+//------------------------------------------------------------------------------
+size_t sizeWaveform(int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        return sizeof(int16_t);
+    case WAVEFORM_S24:
+        return sizeof(int32_t);
+    case WAVEFORM_F32:
+        return sizeof(float);
+    default:
+        break;
+    }
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+static float fullScaleWaveform(int format)
+{
+    switch (format)
+    {
+    case WAVEFORM_S16:
+        return 32768.0f;
+    case WAVEFORM_S24:
+        return 8388608.0f;
+    default:
+        return 1.0f;
+    }
+}
+//------------------------------------------------------------------------------
+void convertWaveform(void* output, int outputFormat, const void* input, int inputFormat, size_t samples, float scale)
+{
+    if (sizeWaveform(outputFormat) == 0 || sizeWaveform(inputFormat) == 0)
+        return;
+
+    if (outputFormat == inputFormat)
+    {
+        if (outputFormat == WAVEFORM_S16)
+        {
+            scaleWaveform((int16_t*)output, (int16_t*)input, samples * sizeof(int16_t), scale);
+            return;
+        }
+        if (scale == 1.0f)
+        {
+            if (output != input)
+            {
+                memcpy(output, input, samples * sizeWaveform(outputFormat));
+            }
+            return;
+        }
+    }
+    if (scale <= 0.0f)
+    {
+        memset(output, 0, samples * sizeWaveform(outputFormat));
+        return;
+    }
+
+    static const WaveformKernel* kernel = waveformKernel();
+    scale = scale * fullScaleWaveform(outputFormat) / fullScaleWaveform(inputFormat);
+    kernel->convert[inputFormat][outputFormat](output, input, samples, scale);
+}
+//------------------------------------------------------------------------------
+void interleaveWaveform(void* output, const void* const* input, size_t offset, size_t channels, size_t frames, int format)
+{
+    static const WaveformKernel* kernel = waveformKernel();
+    switch (sizeWaveform(format))
+    {
+    case sizeof(int16_t):
+        kernel->interleave16(output, input, offset, channels, frames);
+        break;
+    case sizeof(int32_t):
+        kernel->interleave32(output, input, offset, channels, frames);
+        break;
+    default:
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+void deinterleaveWaveform(void* const* output, size_t offset, const void* input, size_t channels, size_t frames, int format)
+{
+    static const WaveformKernel* kernel = waveformKernel();
+    switch (sizeWaveform(format))
+    {
+    case sizeof(int16_t):
+        kernel->deinterleave16(output, offset, input, channels, frames);
+        break;
+    case sizeof(int32_t):
+        kernel->deinterleave32(output, offset, input, channels, frames);
+        break;
+    default:
+        break;
+    }
+}
+//------------------------------------------------------------------------------
+uint32_t maskWaveform(int channel)
+{
+    switch (channel)
+    {
+    case 1:
+        return WAVEFORM_MONO;
+    case 2:
+        return WAVEFORM_STEREO;
+    case 4:
+        return WAVEFORM_QUAD;
+    case 6:
+        return WAVEFORM_5POINT1;
+    case 8:
+        return WAVEFORM_7POINT1;
+    default:
+        break;
+    }
+    if (channel <= 0 || channel > WAVEFORM_CHANNEL_MAX)
+        return 0;
+
+    return (1u << channel) - 1;
+}
+//------------------------------------------------------------------------------
+static size_t rankWaveform(uint32_t mask, uint32_t speaker)
+{
+    size_t rank = 0;
+    for (mask &= speaker - 1; mask; mask &= mask - 1)
+        rank++;
+    return rank;
+}
+//------------------------------------------------------------------------------
+void matrixWaveform(float* matrix, uint32_t inputMask, uint32_t outputMask)
+{
+    // Where a speaker goes when the output lacks it, nearest first.
+    static const struct
+    {
+        uint32_t speaker;
+        uint32_t target[4];
+    } folds[] =
+    {
+        { WAVEFORM_FRONT_LEFT,              { WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_FRONT_RIGHT,             { WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_FRONT_CENTER,            { WAVEFORM_STEREO } },
+        { WAVEFORM_BACK_LEFT,               { WAVEFORM_SIDE_LEFT, WAVEFORM_FRONT_LEFT, WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_BACK_RIGHT,              { WAVEFORM_SIDE_RIGHT, WAVEFORM_FRONT_RIGHT, WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_FRONT_LEFT_OF_CENTER,    { WAVEFORM_FRONT_LEFT, WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_FRONT_RIGHT_OF_CENTER,   { WAVEFORM_FRONT_RIGHT, WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_BACK_CENTER,             { WAVEFORM_BACK_LEFT | WAVEFORM_BACK_RIGHT, WAVEFORM_SIDE_LEFT | WAVEFORM_SIDE_RIGHT, WAVEFORM_STEREO, WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_SIDE_LEFT,               { WAVEFORM_BACK_LEFT, WAVEFORM_FRONT_LEFT, WAVEFORM_FRONT_CENTER } },
+        { WAVEFORM_SIDE_RIGHT,              { WAVEFORM_BACK_RIGHT, WAVEFORM_FRONT_RIGHT, WAVEFORM_FRONT_CENTER } },
+    };
+
+    memset(matrix, 0, sizeof(float) * WAVEFORM_CHANNEL_MAX * WAVEFORM_CHANNEL_MAX);
+
+    size_t input = 0;
+    for (uint32_t speaker = 1; speaker && input < WAVEFORM_CHANNEL_MAX; speaker <<= 1)
+    {
+        if ((inputMask & speaker) == 0)
+            continue;
+        float* gain = matrix + input++ * WAVEFORM_CHANNEL_MAX;
+
+        uint32_t target = outputMask & speaker;
+        float level = 1.0f;
+        for (size_t i = 0; target == 0 && i < sizeof(folds) / sizeof(folds[0]); ++i)
+        {
+            if (folds[i].speaker != speaker)
+                continue;
+            for (uint32_t fold : folds[i].target)
+            {
+                if (fold && (outputMask & fold) == fold)
+                {
+                    target = fold;
+                    level = 0.70710678f;
+                    break;
+                }
+            }
+        }
+
+        for (uint32_t bit = target; bit; bit &= bit - 1)
+        {
+            size_t output = rankWaveform(outputMask, bit & ~(bit - 1));
+            if (output < WAVEFORM_CHANNEL_MAX)
+            {
+                gain[output] = level;
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void remixWaveform(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs)
+{
+    if (inputs > WAVEFORM_CHANNEL_MAX || outputs > WAVEFORM_CHANNEL_MAX)
+        return;
+
+    static const WaveformKernel* kernel = waveformKernel();
+    kernel->remix(output, input, frames, matrix, inputs, outputs);
 }
 //------------------------------------------------------------------------------
@@ -13,4 +13,173 @@
 #define STREAMAL_EXPORT
 #endif
 
+//==============================================================================
+// Layout
+//
+// A channel mask holds one bit per speaker, and interleaved channels come in
+// the order of their bits. The bits are those of WAVE_FORMAT_EXTENSIBLE and
+// OpenSL ES.
+//==============================================================================
+enum WaveformSpeaker
+{
+    WAVEFORM_FRONT_LEFT             = 0x1,
+    WAVEFORM_FRONT_RIGHT            = 0x2,
+    WAVEFORM_FRONT_CENTER           = 0x4,
+    WAVEFORM_LOW_FREQUENCY          = 0x8,
+    WAVEFORM_BACK_LEFT              = 0x10,
+    WAVEFORM_BACK_RIGHT             = 0x20,
+    WAVEFORM_FRONT_LEFT_OF_CENTER   = 0x40,
+    WAVEFORM_FRONT_RIGHT_OF_CENTER  = 0x80,
+    WAVEFORM_BACK_CENTER            = 0x100,
+    WAVEFORM_SIDE_LEFT              = 0x200,
+    WAVEFORM_SIDE_RIGHT             = 0x400,
+};
+
+#define WAVEFORM_CHANNEL_MAX 8
+#define WAVEFORM_MONO       (WAVEFORM_FRONT_CENTER)
+#define WAVEFORM_STEREO     (WAVEFORM_FRONT_LEFT | WAVEFORM_FRONT_RIGHT)
+#define WAVEFORM_QUAD       (WAVEFORM_STEREO | WAVEFORM_BACK_LEFT | WAVEFORM_BACK_RIGHT)
+#define WAVEFORM_5POINT1    (WAVEFORM_QUAD | WAVEFORM_FRONT_CENTER | WAVEFORM_LOW_FREQUENCY)
+#define WAVEFORM_7POINT1    (WAVEFORM_5POINT1 | WAVEFORM_SIDE_LEFT | WAVEFORM_SIDE_RIGHT)
+
+//==============================================================================
+// Kernels
+//
+// Every instruction set implements the same table, and every entry handles
+// any sample count (no multiple-of-vector requirement). The scalar kernel is
+// the reference the others must match.
+//==============================================================================
+enum WaveformISA
+{
+    WAVEFORM_SCALAR,
+    WAVEFORM_SSE2,
+    WAVEFORM_AVX2,
+    WAVEFORM_AVX512,
+    WAVEFORM_NEON,
+    WAVEFORM_ISA_COUNT,
+};
+
+// Sample formats, interleaved. S24 keeps 24 bits sign-extended in the low
+// bits of an int32_t, F32 is full scale at 1.0.
+enum WaveformFormat
+{
+    WAVEFORM_S16,
+    WAVEFORM_S24,
+    WAVEFORM_F32,
+    WAVEFORM_FORMAT_COUNT,
+};
+
+// Sums over 16-bit samples that the activity kernels add to. A crossing is a
+// sample whose sign differs from the one a frame earlier, zero counting as
+// positive, and is only looked for a frame or more into each call.
+struct WaveformActivity
+{
+    uint64_t energy;
+    uint64_t crossings;
+    uint64_t samples;
+};
+
+// Per channel sums over 16-bit samples that the meter kernels add to: the
+// largest magnitude and the sum of squares. Sample 0 of each call is taken
+// as channel 0, and samples counts every channel.
+struct WaveformMeter
+{
+    uint32_t peak[WAVEFORM_CHANNEL_MAX];
+    uint64_t energy[WAVEFORM_CHANNEL_MAX];
+    uint64_t samples;
+};
+
+struct WaveformKernel
+{
+    const char* name;
+
+    // output = saturate(round(input * scale)), output may alias input
+    void (*scale)(int16_t* output, const int16_t* input, size_t samples, float scale);
+
+    // output = saturate((input * scale + 0x4000) >> 15), scale in Q15
+    void (*scaleQ15)(int16_t* output, const int16_t* input, size_t samples, int16_t scale);
+
+    // scale, adding the squares and crossings of the output to activity in
+    // the same pass, for frames of channels samples
+    void (*scaleActivity)(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformActivity* activity);
+
+    // scale, adding the peak and squares of each of channels, at most
+    // WAVEFORM_CHANNEL_MAX, of the output to meter in the same pass
+    void (*scaleMeter)(int16_t* output, const int16_t* input, size_t samples, float scale, size_t channels, WaveformMeter* meter);
+
+    // output = saturate(output + scaled input), same rounding as scale
+    void (*mix)(int16_t* output, const int16_t* input, size_t samples, float scale);
+    void (*mixQ15)(int16_t* output, const int16_t* input, size_t samples, int16_t scale);
+
+    // sum of a[i] * b[i] in 32 bits, for FIR filters with Q15 coefficients
+    int32_t (*dot)(const int16_t* a, const int16_t* b, size_t samples);
+
+    // sum of a[i] * b[i] in float, for correlations; the order of the adds
+    // differs between kernels, so results match to rounding only
+    float (*correlate)(const float* a, const float* b, size_t samples);
+
+    // output = input * scale, indexed [input format][output format]. Integer
+    // outputs are rounded and saturated, float outputs are left unclamped.
+    // The scale is applied to raw sample values, it carries no full-scale
+    // change between formats.
+    void (*convert[WAVEFORM_FORMAT_COUNT][WAVEFORM_FORMAT_COUNT])(void* output, const void* input, size_t samples, float scale);
+
+    // Interleave one plane per channel into frames, or split frames back into
+    // planes, for 16-bit and 32-bit samples. offset counts frames into every
+    // plane.
+    void (*interleave16)(void* output, const void* const* input, size_t offset, size_t channels, size_t frames);
+    void (*interleave32)(void* output, const void* const* input, size_t offset, size_t channels, size_t frames);
+    void (*deinterleave16)(void* const* output, size_t offset, const void* input, size_t channels, size_t frames);
+    void (*deinterleave32)(void* const* output, size_t offset, const void* input, size_t channels, size_t frames);
+
+    // output = input frames through a matrix, inputs channels in and outputs
+    // channels out, at most WAVEFORM_CHANNEL_MAX each. The gain of input i to
+    // output o is matrix[i * WAVEFORM_CHANNEL_MAX + o]. output must not alias
+    // input.
+    void (*remix)(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs);
+};
+
+// Kernel for the given WaveformISA, or nullptr when this CPU cannot run it.
+// A negative isa returns the best kernel for this CPU.
+STREAMAL_EXPORT const WaveformKernel* waveformKernel(int isa = -1);
+
+//==============================================================================
+// Utility
+//==============================================================================
+
+// count is in bytes
 STREAMAL_EXPORT void scaleWaveform(int16_t* waveform, size_t count, float scale);
+STREAMAL_EXPORT void scaleWaveform(int16_t* output, const int16_t* input, size_t count, float scale);
+// The same with activity measured on the output. Gains below one take the
+// float kernel here, which may round a step apart from the Q15 one above.
+STREAMAL_EXPORT void scaleWaveform(int16_t* output, const int16_t* input, size_t count, float scale, size_t channels, WaveformActivity* activity);
+// Or with the levels of each channel, up to WAVEFORM_CHANNEL_MAX, metered.
+STREAMAL_EXPORT void scaleWaveform(int16_t* output, const int16_t* input, size_t count, float scale, size_t channels, WaveformMeter* meter);
+STREAMAL_EXPORT void mixWaveform(int16_t* output, const int16_t* input, size_t count, float scale);
+
+// Sum of a[i] * b[i] over samples floats.
+STREAMAL_EXPORT float correlateWaveform(const float* a, const float* b, size_t samples);
+
+// Bytes per sample of a WaveformFormat, 0 for an unknown format.
+STREAMAL_EXPORT size_t sizeWaveform(int format);
+
+// samples counts samples, not bytes. Full scale maps to full scale before
+// scale applies. output may alias input when both formats have the same size.
+STREAMAL_EXPORT void convertWaveform(void* output, int outputFormat, const void* input, int inputFormat, size_t samples, float scale);
+
+// Planar buffers hold one plane per channel, frames counts frames and offset
+// skips that many frames into every plane.
+STREAMAL_EXPORT void interleaveWaveform(void* output, const void* const* input, size_t offset, size_t channels, size_t frames, int format);
+STREAMAL_EXPORT void deinterleaveWaveform(void* const* output, size_t offset, const void* input, size_t channels, size_t frames, int format);
+
+// Default mask for a channel count: mono, stereo, quad, 5.1 and 7.1, and the
+// lowest speakers in bit order for the other counts up to WAVEFORM_CHANNEL_MAX.
+STREAMAL_EXPORT uint32_t maskWaveform(int channel);
+
+// The usual downmix or upmix from inputMask to outputMask, in the layout of
+// the remix kernel. A speaker both masks have passes through, and one the
+// output lacks folds at -3 dB to the nearest speakers it has: center to left
+// and right, sides and backs to each other and then to the front, fronts to
+// a lone center. The LFE is dropped when the output has none.
+STREAMAL_EXPORT void matrixWaveform(float* matrix, uint32_t inputMask, uint32_t outputMask);
+STREAMAL_EXPORT void remixWaveform(float* output, const float* input, size_t frames, const float* matrix, size_t inputs, size_t outputs);
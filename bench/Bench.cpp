@@ -0,0 +1,227 @@
+//==============================================================================
+// Benchmark
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "Telemetry.h"
+#include "Waveform.h"
+#include "Bench.h"
+
+#define BENCH_BATCH 5
+
+static std::vector<BenchResult> benchResults;
+static std::vector<BenchSpread> benchSpreads;
+static const char* benchFilter = nullptr;
+static double benchMinimum = 0.02;
+static int benchFailed = 0;
+
+//------------------------------------------------------------------------------
+static double BenchSeconds(void (*body)(void* context, uint64_t count), void* context, uint64_t count)
+{
+    auto start = std::chrono::steady_clock::now();
+    body(context, count);
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(stop - start).count();
+}
+//------------------------------------------------------------------------------
+bool BenchEnabled(const char* name)
+{
+    if (benchFilter == nullptr)
+        return true;
+
+    return strstr(name, benchFilter) != nullptr;
+}
+//------------------------------------------------------------------------------
+void BenchMeasure(const char* name, uint64_t bytes, void (*body)(void* context, uint64_t count), void* context)
+{
+    if (BenchEnabled(name) == false)
+        return;
+
+    // Warm up caches and lazy setup, then grow the batch to the minimum time.
+    body(context, 1);
+    uint64_t count = 1;
+    for (;;)
+    {
+        double seconds = BenchSeconds(body, context, count);
+        if (seconds >= benchMinimum || count >= (1ull << 40))
+            break;
+        uint64_t grow = seconds > 0.0 ? (uint64_t)(count * (benchMinimum * 1.2 / seconds)) : count * 16;
+        count = std::max(count * 2, std::min(grow, count * 16));
+    }
+
+    double nano[BENCH_BATCH];
+    for (int i = 0; i < BENCH_BATCH; ++i)
+    {
+        nano[i] = BenchSeconds(body, context, count) * 1e9 / count;
+    }
+    std::sort(nano, nano + BENCH_BATCH);
+
+    BenchResult result = {};
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    result.bytes = bytes;
+    result.count = count;
+    result.nanoMin = nano[0];
+    result.nanoMedian = nano[BENCH_BATCH / 2];
+    benchResults.push_back(result);
+
+    double throughput = bytes ? bytes / result.nanoMedian : 0.0;
+    printf("%-48s %12.1f ns %12.1f ns %10.3f GB/s\n", result.name, result.nanoMin, result.nanoMedian, throughput);
+    fflush(stdout);
+}
+//------------------------------------------------------------------------------
+void BenchDistribution(const char* name, const char* unit, double* values, size_t count, uint64_t lost, const TelemetrySnapshot* telemetry)
+{
+    BenchSpread spread = {};
+    snprintf(spread.name, sizeof(spread.name), "%s", name);
+    snprintf(spread.unit, sizeof(spread.unit), "%s", unit);
+    spread.count = count;
+    spread.lost = lost;
+    if (count)
+    {
+        std::sort(values, values + count);
+        spread.min = values[0];
+        spread.p50 = values[count * 50 / 100];
+        spread.p90 = values[count * 90 / 100];
+        spread.p99 = values[count * 99 / 100];
+        spread.max = values[count - 1];
+    }
+    if (telemetry)
+    {
+        spread.telemetry = true;
+        spread.underrunBytes = telemetry->underrunBytes;
+        spread.missingBytes = telemetry->missingBytes;
+        spread.resyncs = telemetry->resyncs;
+    }
+    if (benchSpreads.empty())
+    {
+        printf("\n%-48s %8s %8s %8s %8s %8s\n", "name", "min", "p50", "p90", "p99", "max");
+    }
+    benchSpreads.push_back(spread);
+
+    printf("%-48s %8.2f %8.2f %8.2f %8.2f %8.2f %-4s %6llu lost", spread.name, spread.min, spread.p50, spread.p90, spread.p99, spread.max, spread.unit, (unsigned long long)spread.lost);
+    if (spread.telemetry)
+    {
+        printf(" %8llu underrun %8llu missing %4llu resyncs", (unsigned long long)spread.underrunBytes, (unsigned long long)spread.missingBytes, (unsigned long long)spread.resyncs);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+//------------------------------------------------------------------------------
+void BenchFail(const char* name, const char* reason)
+{
+    fprintf(stderr, "FAIL %s: %s\n", name, reason);
+    benchFailed++;
+}
+//------------------------------------------------------------------------------
+static bool BenchJSON(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr)
+        return false;
+
+    char date[32] = {};
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    const WaveformKernel* kernel = waveformKernel();
+    fprintf(file, "{\n");
+    fprintf(file, "  \"suite\": \"streamal_bench\",\n");
+    fprintf(file, "  \"date\": \"%s\",\n", date);
+    fprintf(file, "  \"isa\": \"%s\",\n", kernel ? kernel->name : "");
+#if defined(__clang__)
+    fprintf(file, "  \"compiler\": \"clang %s\",\n", __clang_version__);
+#elif defined(__GNUC__)
+    fprintf(file, "  \"compiler\": \"gcc %s\",\n", __VERSION__);
+#elif defined(_MSC_VER)
+    fprintf(file, "  \"compiler\": \"msvc %d\",\n", _MSC_VER);
+#endif
+    fprintf(file, "  \"minimum_seconds\": %g,\n", benchMinimum);
+    fprintf(file, "  \"failures\": %d,\n", benchFailed);
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < benchResults.size(); ++i)
+    {
+        const BenchResult& result = benchResults[i];
+        double throughput = result.bytes ? result.bytes / result.nanoMedian : 0.0;
+        fprintf(file, "    { \"name\": \"%s\", \"bytes\": %llu, \"count\": %llu, \"ns_min\": %.3f, \"ns_median\": %.3f, \"gb_per_s\": %.4f }%s\n",
+                result.name, (unsigned long long)result.bytes, (unsigned long long)result.count,
+                result.nanoMin, result.nanoMedian, throughput, i + 1 < benchResults.size() ? "," : "");
+    }
+    fprintf(file, "  ],\n");
+    fprintf(file, "  \"distributions\": [\n");
+    for (size_t i = 0; i < benchSpreads.size(); ++i)
+    {
+        const BenchSpread& spread = benchSpreads[i];
+        fprintf(file, "    { \"name\": \"%s\", \"unit\": \"%s\", \"count\": %llu, \"lost\": %llu, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f",
+                spread.name, spread.unit, (unsigned long long)spread.count, (unsigned long long)spread.lost,
+                spread.min, spread.p50, spread.p90, spread.p99, spread.max);
+        if (spread.telemetry)
+        {
+            fprintf(file, ", \"underrun_bytes\": %llu, \"missing_bytes\": %llu, \"resyncs\": %llu",
+                    (unsigned long long)spread.underrunBytes, (unsigned long long)spread.missingBytes, (unsigned long long)spread.resyncs);
+        }
+        fprintf(file, " }%s\n", i + 1 < benchSpreads.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    return fclose(file) == 0;
+}
+//------------------------------------------------------------------------------
+static void BenchUsage(const char* program)
+{
+    printf("usage: %s [--filter text] [--json path] [--quick]\n", program);
+    printf("  --filter text  run only the cases whose name contains text\n");
+    printf("  --json path    write every result to path as JSON\n");
+    printf("  --quick        shorter batches, for a smoke run\n");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    const char* json = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            benchFilter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json = argv[++i];
+        }
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            benchMinimum = 0.002;
+        }
+        else
+        {
+            BenchUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    printf("%-48s %15s %15s %15s\n", "name", "min", "median", "throughput");
+    BenchRing();
+    BenchWaveform();
+    BenchPipeline();
+    BenchLatency();
+    BenchConceal();
+    BenchObject();
+    BenchResampler();
+
+    if (json && BenchJSON(json) == false)
+    {
+        fprintf(stderr, "cannot write %s\n", json);
+        return 1;
+    }
+
+    return benchFailed ? 1 : 0;
+}
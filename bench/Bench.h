@@ -0,0 +1,66 @@
+//==============================================================================
+// Benchmark
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// A case is a body that runs count operations per call. BenchMeasure grows
+// count until a batch takes the minimum time, then times several batches and
+// keeps the fastest and the median. bytes is what one operation moves, for
+// the throughput column, or 0 when throughput means nothing.
+//
+// Names are slash separated, group first, so --filter can pick a subtree.
+//------------------------------------------------------------------------------
+struct BenchResult
+{
+    char name[128];
+    uint64_t bytes;
+    uint64_t count;
+    double nanoMin;
+    double nanoMedian;
+};
+
+struct BenchSpread
+{
+    char name[128];
+    char unit[16];
+    uint64_t count;
+    uint64_t lost;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    bool telemetry;
+    uint64_t underrunBytes;
+    uint64_t missingBytes;
+    uint64_t resyncs;
+};
+
+struct TelemetrySnapshot;
+
+bool BenchEnabled(const char* name);
+void BenchMeasure(const char* name, uint64_t bytes, void (*body)(void* context, uint64_t count), void* context);
+
+// A case that measures something other than its own run time reports the
+// values it saw, as percentiles in unit. lost counts the events that never
+// produced a value. values is sorted in place. A case that ran a stream
+// passes its telemetry, so what the player saw goes next to the values.
+void BenchDistribution(const char* name, const char* unit, double* values, size_t count, uint64_t lost, const TelemetrySnapshot* telemetry = nullptr);
+
+// A case that fails its own check marks the whole run as failed.
+void BenchFail(const char* name, const char* reason);
+
+void BenchRing();
+void BenchWaveform();
+void BenchPipeline();
+void BenchLatency();
+void BenchConceal();
+void BenchObject();
+void BenchResampler();
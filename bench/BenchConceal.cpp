@@ -0,0 +1,147 @@
+//==============================================================================
+// Benchmark - Conceal
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "StreamCore.h"
+#include "Bench.h"
+
+#define BENCH_CONCEAL_PERIOD    10
+
+//------------------------------------------------------------------------------
+// One operation is the device side bookkeeping of one 10 ms period, Period,
+// on a stream whose ring holds a voiced signal up to send:
+//
+//   clean    the period is all there, so only the missing check runs
+//   onset    the period starts at send, so the pitch search runs and then
+//            the whole period is generated into the output
+//   sustain  the loss is already under way, so the period is generated
+//
+// Everything past send counts as missing and is never written to the ring,
+// so repeating a case only needs the concealer put back.
+//------------------------------------------------------------------------------
+struct BenchConcealCase
+{
+    StreamCore core;
+    uint64_t pick;
+    size_t size;
+    std::vector<char> output;
+};
+//------------------------------------------------------------------------------
+static void BenchConcealClean(void* context, uint64_t count)
+{
+    BenchConcealCase& thiz = *(BenchConcealCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.core.Period(thiz.pick - thiz.size, thiz.size);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchConcealOnset(void* context, uint64_t count)
+{
+    BenchConcealCase& thiz = *(BenchConcealCase*)context;
+
+    size_t samples = thiz.size / sizeWaveform(thiz.core.format);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.core.conceal.Reset();
+        thiz.core.Period(thiz.pick, thiz.size);
+        thiz.core.Underrun(thiz.pick, thiz.output.data(), thiz.core.format, samples, 1.0f, false, nullptr);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchConcealSustain(void* context, uint64_t count)
+{
+    BenchConcealCase& thiz = *(BenchConcealCase*)context;
+
+    size_t samples = thiz.size / sizeWaveform(thiz.core.format);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.core.conceal.lost = 0;
+        thiz.core.Period(thiz.pick, thiz.size);
+        thiz.core.Underrun(thiz.pick, thiz.output.data(), thiz.core.format, samples, 1.0f, false, nullptr);
+    }
+}
+//------------------------------------------------------------------------------
+void BenchConceal()
+{
+    static const struct
+    {
+        const char* name;
+        int channel;
+        int sampleRate;
+        int format;
+    } streams[] =
+    {
+        { "s16-16000-1",    1,  16000,  WAVEFORM_S16 },
+        { "s16-48000-2",    2,  48000,  WAVEFORM_S16 },
+        { "f32-48000-2",    2,  48000,  WAVEFORM_F32 },
+    };
+    static const struct
+    {
+        const char* name;
+        void (*body)(void* context, uint64_t count);
+    } cases[] =
+    {
+        { "clean",      BenchConcealClean },
+        { "onset",      BenchConcealOnset },
+        { "sustain",    BenchConcealSustain },
+    };
+
+    for (const auto& stream : streams)
+    {
+        BenchConcealCase test;
+        if (test.core.Startup(stream.channel, stream.sampleRate, 1, false, stream.format, nullptr, nullptr) == false ||
+            test.core.EnableConceal(true) == false)
+        {
+            BenchFail(stream.name, "StreamCore");
+            continue;
+        }
+        test.core.volume = 1.0f;
+
+        // 200 ms of a vowel-like tone at 140 Hz with two harmonics, queued as
+        // one packet so send lands where the loss begins.
+        size_t frames = stream.sampleRate / 5;
+        std::vector<float> voice(frames * stream.channel);
+        for (size_t i = 0; i < frames; ++i)
+        {
+            double phase = 2.0 * M_PI * 140.0 * i / stream.sampleRate;
+            float sample = float(0.5 * sin(phase) + 0.25 * sin(2.0 * phase) + 0.125 * sin(3.0 * phase));
+            for (int c = 0; c < stream.channel; ++c)
+                voice[i * stream.channel + c] = sample;
+        }
+        size_t bufferSize = frames * stream.channel * sizeWaveform(stream.format);
+        std::vector<char> packet(bufferSize);
+        convertWaveform(packet.data(), stream.format, voice.data(), WAVEFORM_F32, voice.size(), 1.0f);
+        test.core.Queue(1000000, 1000000, 0, packet.data(), bufferSize, 0);
+        test.core.go = true;
+        test.pick = test.core.bufferQueue.LoadSend();
+        test.size = size_t(stream.sampleRate) * BENCH_CONCEAL_PERIOD / 1000 * stream.channel * sizeWaveform(stream.format);
+        test.output.resize(test.size);
+
+        for (const auto& kind : cases)
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "conceal/%s/%s", kind.name, stream.name);
+            if (BenchEnabled(name) == false)
+                continue;
+
+            TelemetrySnapshot before = {};
+            test.core.telemetry.Read(&before);
+            BenchMeasure(name, test.size, kind.body, &test);
+            TelemetrySnapshot after = {};
+            test.core.telemetry.Read(&after);
+            if (kind.body != BenchConcealClean && after.concealBytes == before.concealBytes)
+                BenchFail(name, "nothing concealed");
+            if (test.core.bufferQueue.Missing(test.pick, test.size) != test.size)
+                BenchFail(name, "wrote the ring past send");
+        }
+    }
+}
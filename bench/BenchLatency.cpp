@@ -0,0 +1,285 @@
+//==============================================================================
+// Benchmark - Latency
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "NullAudio.h"
+#include "Telemetry.h"
+#include "Bench.h"
+
+#define BENCH_LATENCY_RATE      48000
+#define BENCH_LATENCY_CABLE     5000
+#define BENCH_LATENCY_STEP      500
+#define BENCH_LATENCY_SECOND    20
+#define BENCH_LATENCY_EVERY     5
+#define BENCH_LATENCY_TAG       32
+#define BENCH_LATENCY_SPELL     5
+#define BENCH_LATENCY_TALK      1000
+#define BENCH_LATENCY_PAUSE     200
+#define BENCH_LATENCY_BOUND     10
+#define BENCH_LATENCY_PULSE     32
+
+//------------------------------------------------------------------------------
+// A player cabled to a recorder, both on one virtual clock. The sender queues
+// a packet every packet period, late by up to jitter, with an impulse in
+// every few packets. The receiver dequeues on its own packet cadence, also
+// late by up to jitter, and plays each buffer from the moment it gets it.
+// Latency is the time from an impulse's place in the sent media to its place
+// in the received one.
+//
+// With playout, the player follows the jitter with its playout delay and the
+// gap only sets where it starts.
+//
+// A spell case is a bad link that calms down: the jitter lasts for the first
+// few seconds only, and the sender talks in spurts with a pause of silence
+// between them, as a voice sender with discontinuous transmission does. A
+// fixed gap keeps whatever delay the spell left it with; playout gives the
+// excess back in the pauses once the jitter is gone.
+//
+// A skew case runs the player and the recorder on a device clock that is off
+// from the sender's by skew parts per million, as two crystals are. Without
+// drift, the fill level walks away until Queue resyncs; with drift, the trim
+// has to hold it, so the case fails on a resync or on a spread of send ahead
+// of pick wider than a device period and BENCH_LATENCY_BOUND milliseconds.
+//
+// Impulses carry a tag in their amplitude, so a lost one does not shift the
+// match of those after it. Each is a pulse of BENCH_LATENCY_PULSE frames and
+// the tag is read in its middle, where a drift resampler has not smeared it. The last second sends none, so every impulse has
+// time to arrive and lost only counts real losses. An impulse that lands in
+// a concealed or silent stretch is not lost, only late or never heard, so
+// the player's underrun, missing and resync counts are reported with it.
+//------------------------------------------------------------------------------
+struct BenchLatencyConfig
+{
+    int period;
+    int packet;
+    int gap;
+    int jitter;
+    int spell;
+    int skew;
+    bool playout;
+    bool drift;
+};
+//------------------------------------------------------------------------------
+static uint32_t BenchLatencyRandom(uint32_t& seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+//------------------------------------------------------------------------------
+static uint64_t BenchLatencyLate(const BenchLatencyConfig& config, uint64_t elapsed, uint32_t& seed)
+{
+    if (config.jitter == 0)
+        return 0;
+    if (config.spell && elapsed >= config.spell * 1000000ull)
+        return 0;
+    return BenchLatencyRandom(seed) % (config.jitter * 1000);
+}
+//------------------------------------------------------------------------------
+static void BenchLatencyRun(const BenchLatencyConfig& config, const char* name)
+{
+    struct NullAudio* player = NullAudioCreate(1, BENCH_LATENCY_RATE, 1, false);
+    struct NullAudio* recorder = NullAudioCreate(1, BENCH_LATENCY_RATE, 1, true);
+    if (player == nullptr || recorder == nullptr)
+    {
+        BenchFail(name, "NullAudioCreate");
+        NullAudioDestroy(player);
+        NullAudioDestroy(recorder);
+        return;
+    }
+
+    uint64_t start = NullAudioStep(player, 0);
+    NullAudioStep(recorder, 0);
+    NullAudioPeriod(player, config.period * BENCH_LATENCY_RATE / 1000);
+    NullAudioPeriod(recorder, config.period * BENCH_LATENCY_RATE / 1000);
+    NullAudioVolume(player, 1.0f);
+    NullAudioPlayout(player, config.playout);
+    NullAudioDrift(player, config.drift);
+    NullAudioLoopback(player, recorder, BENCH_LATENCY_CABLE);
+
+    size_t frames = config.packet * BENCH_LATENCY_RATE / 1000;
+    std::vector<int16_t> packet(frames);
+    std::vector<int16_t> capture(frames);
+    std::vector<double> latency;
+    uint64_t sent[BENCH_LATENCY_TAG] = {};
+    uint64_t impulses = 0;
+    uint64_t onset = 0;
+    size_t wait = 0;
+    bool high = false;
+    uint32_t seed = 1;
+
+    // The receiver starts half a packet out of phase with the sender.
+    uint64_t packetTime = config.packet * 1000;
+    uint64_t sendTime = start;
+    uint64_t sendDue = start;
+    uint64_t receiveTime = start + packetTime / 2;
+    uint64_t receiveDue = receiveTime;
+    uint64_t sequence = 0;
+    for (uint64_t now = start; now < start + BENCH_LATENCY_SECOND * 1000000ull; )
+    {
+        if (now >= sendDue)
+        {
+            bool pause = config.spell && (sendTime - start) % ((BENCH_LATENCY_TALK + BENCH_LATENCY_PAUSE) * 1000) >= BENCH_LATENCY_TALK * 1000;
+            if (pause)
+            {
+                NullAudioQueueSilence(player, now, sendTime, 0, frames * sizeof(int16_t), config.gap);
+            }
+            else
+            {
+                memset(packet.data(), 0, frames * sizeof(int16_t));
+                if (sequence % BENCH_LATENCY_EVERY == 0 && sendTime + 1000000 < start + BENCH_LATENCY_SECOND * 1000000ull)
+                {
+                    uint64_t tag = impulses++ % BENCH_LATENCY_TAG;
+                    size_t offset = BenchLatencyRandom(seed) % (frames - BENCH_LATENCY_PULSE);
+                    for (size_t i = 0; i < BENCH_LATENCY_PULSE; ++i)
+                        packet[offset + i] = (int16_t)((tag + 1) * 1000);
+                    sent[tag] = sendTime + offset * 1000000ull / BENCH_LATENCY_RATE;
+                }
+                NullAudioQueue(player, now, sendTime, 0, packet.data(), frames * sizeof(int16_t), config.gap);
+            }
+            sequence++;
+            sendTime += packetTime;
+            sendDue = sendTime + BenchLatencyLate(config, sendTime - start, seed);
+        }
+
+        if (now >= receiveDue)
+        {
+            uint64_t playTime = now;
+            while (NullAudioDequeue(recorder, capture.data(), frames * sizeof(int16_t)) != 0)
+            {
+                for (size_t i = 0; i < frames; ++i)
+                {
+                    int sample = capture[i];
+                    if (wait != 0)
+                    {
+                        if (--wait != 0)
+                            continue;
+                        uint64_t tag = (sample + 500) / 1000 - 1;
+                        if (tag >= BENCH_LATENCY_TAG || sent[tag] == 0)
+                            continue;
+                        latency.push_back((int64_t)(onset - sent[tag]) / 1000.0);
+                        sent[tag] = 0;
+                        continue;
+                    }
+                    if (sample < 500)
+                    {
+                        high = false;
+                        continue;
+                    }
+                    if (high)
+                        continue;
+                    high = true;
+                    onset = playTime + i * 1000000ull / BENCH_LATENCY_RATE;
+                    wait = BENCH_LATENCY_PULSE / 2;
+                }
+                playTime += packetTime;
+            }
+            receiveTime += packetTime;
+            receiveDue = receiveTime + BenchLatencyLate(config, receiveTime - start, seed);
+        }
+
+        // The device clock runs skew parts per million off the sender's.
+        uint64_t device = NullAudioNow(player);
+        uint64_t target = start + (now + BENCH_LATENCY_STEP - start) * (1000000 + config.skew) / 1000000;
+        NullAudioStep(player, target - device);
+        NullAudioStep(recorder, target - device);
+        now += BENCH_LATENCY_STEP;
+    }
+
+    TelemetrySnapshot snapshot = {};
+    NullAudioTelemetry(player, &snapshot);
+
+    BenchDistribution(name, "ms", latency.data(), latency.size(), impulses - latency.size(), &snapshot);
+    if (config.drift)
+    {
+        if (snapshot.resyncs != 0)
+            BenchFail(name, "drift does not keep the fill level from resyncing");
+        if (snapshot.offsetMax - snapshot.offsetMin > (config.period + BENCH_LATENCY_BOUND) * 1000)
+            BenchFail(name, "drift does not keep the fill level bounded");
+    }
+
+    NullAudioDestroy(player);
+    NullAudioDestroy(recorder);
+}
+//------------------------------------------------------------------------------
+void BenchLatency()
+{
+    static const int periods[] = { 5, 10, 20 };
+    static const int packets[] = { 10, 20, 40 };
+    static const int gaps[] = { 1, 2, 4 };
+    static const int jitters[] = { 0, 10, 30 };
+    static const int spells[] = { 30, 60 };
+    static const int skews[] = { -2000, 2000 };
+    static const bool drifts[] = { false, true };
+
+    for (int period : periods)
+    {
+        for (int packet : packets)
+        {
+            for (int gap : gaps)
+            {
+                for (int jitter : jitters)
+                {
+                    char name[128];
+                    snprintf(name, sizeof(name), "latency/period%d/packet%d/gap%d/jitter%d", period, packet, gap, jitter);
+                    if (BenchEnabled(name) == false)
+                        continue;
+
+                    BenchLatencyConfig config = { period, packet, gap, jitter, 0, 0, false, false };
+                    BenchLatencyRun(config, name);
+                }
+            }
+
+            for (int jitter : jitters)
+            {
+                char name[128];
+                snprintf(name, sizeof(name), "latency/period%d/packet%d/playout/jitter%d", period, packet, jitter);
+                if (BenchEnabled(name) == false)
+                    continue;
+
+                BenchLatencyConfig config = { period, packet, 1, jitter, 0, 0, true, false };
+                BenchLatencyRun(config, name);
+            }
+
+            for (int jitter : spells)
+            {
+                for (int gap : gaps)
+                {
+                    char name[128];
+                    snprintf(name, sizeof(name), "latency/period%d/packet%d/gap%d/spell%d", period, packet, gap, jitter);
+                    if (BenchEnabled(name) == false)
+                        continue;
+
+                    BenchLatencyConfig config = { period, packet, gap, jitter, BENCH_LATENCY_SPELL, 0, false, false };
+                    BenchLatencyRun(config, name);
+                }
+
+                char name[128];
+                snprintf(name, sizeof(name), "latency/period%d/packet%d/playout/spell%d", period, packet, jitter);
+                if (BenchEnabled(name) == false)
+                    continue;
+
+                BenchLatencyConfig config = { period, packet, 1, jitter, BENCH_LATENCY_SPELL, 0, true, false };
+                BenchLatencyRun(config, name);
+            }
+
+            for (int skew : skews)
+            {
+                for (bool drift : drifts)
+                {
+                    char name[128];
+                    snprintf(name, sizeof(name), "latency/period%d/packet%d/gap2/skew%+d%s", period, packet, skew, drift ? "/drift" : "");
+                    if (BenchEnabled(name) == false)
+                        continue;
+
+                    BenchLatencyConfig config = { period, packet, 2, 0, 0, skew, false, drift };
+                    BenchLatencyRun(config, name);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,238 @@
+//==============================================================================
+// Benchmark - Object
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <stdio.h>
+#include "ObjectCache.h"
+#include "Bench.h"
+
+//------------------------------------------------------------------------------
+// The objects are counters standing in for engines and players: create hands
+// out the next one and destroy marks it gone, so every check can tell what is
+// still alive and which object went where.
+//------------------------------------------------------------------------------
+#define BENCH_OBJECT_COUNT      16
+
+static int BenchObjectAlive[BENCH_OBJECT_COUNT];
+static int BenchObjectCreated;
+static int BenchObjectDestroyed;
+//------------------------------------------------------------------------------
+static void* BenchObjectCreate()
+{
+    int index = BenchObjectCreated % BENCH_OBJECT_COUNT;
+    BenchObjectCreated++;
+    BenchObjectAlive[index]++;
+    return &BenchObjectAlive[index];
+}
+//------------------------------------------------------------------------------
+static void BenchObjectDestroy(void* object)
+{
+    BenchObjectDestroyed++;
+    (*(int*)object)--;
+}
+//------------------------------------------------------------------------------
+static void BenchObjectReset()
+{
+    for (int& alive : BenchObjectAlive)
+        alive = 0;
+    BenchObjectCreated = 0;
+    BenchObjectDestroyed = 0;
+}
+//------------------------------------------------------------------------------
+static void BenchObjectShared()
+{
+    const char* name = "object/shared/check";
+    if (BenchEnabled(name) == false)
+        return;
+    BenchObjectReset();
+
+    ObjectShared shared(BenchObjectCreate, BenchObjectDestroy);
+    void* first = shared.Acquire();
+    void* second = shared.Acquire();
+    if (first == nullptr || first != second || BenchObjectCreated != 1)
+        BenchFail(name, "acquire does not share one object");
+    if (shared.Count() != 2)
+        BenchFail(name, "acquire does not count");
+
+    shared.Release();
+    if (BenchObjectDestroyed != 0 || (*(int*)first) != 1)
+        BenchFail(name, "release destroys a referenced object");
+    shared.Release();
+    if (BenchObjectDestroyed != 1 || (*(int*)first) != 0 || shared.Count() != 0)
+        BenchFail(name, "last release does not destroy");
+    shared.Release();
+    if (BenchObjectDestroyed != 1 || shared.Count() != 0)
+        BenchFail(name, "extra release is not ignored");
+
+    void* third = shared.Acquire();
+    if (third == nullptr || BenchObjectCreated != 2)
+        BenchFail(name, "acquire after release does not create");
+    shared.Release();
+}
+//------------------------------------------------------------------------------
+static void BenchObjectKey()
+{
+    const char* name = "object/cache/key";
+    if (BenchEnabled(name) == false)
+        return;
+    BenchObjectReset();
+
+    static const struct
+    {
+        int channel;
+        int sampleRate;
+        int format;
+        bool record;
+    } keys[] =
+    {
+        { 2,    48000,  1,  false },
+        { 1,    48000,  1,  false },
+        { 2,    44100,  1,  false },
+        { 2,    48000,  2,  false },
+        { 2,    48000,  1,  true },
+    };
+    static const int count = sizeof(keys) / sizeof(keys[0]);
+
+    // Every parameter on its own has to tell the objects apart.
+    ObjectCache cache(BenchObjectDestroy);
+    void* objects[count];
+    for (int i = 0; i < count; ++i)
+    {
+        objects[i] = BenchObjectCreate();
+    }
+    for (int i = 0; i < ObjectCache::CAPACITY; ++i)
+    {
+        cache.Give(ObjectCache::Key(keys[i].channel, keys[i].sampleRate, keys[i].format, keys[i].record), objects[i]);
+    }
+    if (cache.Count() != ObjectCache::CAPACITY || BenchObjectDestroyed != 0)
+        BenchFail(name, "give does not park");
+
+    int last = ObjectCache::CAPACITY;
+    if (cache.Take(ObjectCache::Key(keys[last].channel, keys[last].sampleRate, keys[last].format, keys[last].record)))
+        BenchFail(name, "take matches a key never given");
+    for (int i = ObjectCache::CAPACITY - 1; i >= 0; --i)
+    {
+        void* object = cache.Take(ObjectCache::Key(keys[i].channel, keys[i].sampleRate, keys[i].format, keys[i].record));
+        if (object != objects[i])
+        {
+            char reason[64];
+            snprintf(reason, 64, "take of key %d returns the wrong object", i);
+            BenchFail(name, reason);
+        }
+    }
+    if (cache.Count() != 0 || cache.Take(ObjectCache::Key(keys[0].channel, keys[0].sampleRate, keys[0].format, keys[0].record)))
+        BenchFail(name, "take does not remove");
+
+    // With the same key twice the newest comes back first.
+    uint64_t key = ObjectCache::Key(keys[0].channel, keys[0].sampleRate, keys[0].format, keys[0].record);
+    cache.Give(key, objects[0]);
+    cache.Give(key, objects[1]);
+    if (cache.Take(key) != objects[1] || cache.Take(key) != objects[0])
+        BenchFail(name, "take does not prefer the newest");
+    if (BenchObjectDestroyed != 0)
+        BenchFail(name, "take destroys");
+
+    for (int i = 0; i < count; ++i)
+    {
+        BenchObjectDestroy(objects[i]);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchObjectEvict()
+{
+    const char* name = "object/cache/evict";
+    if (BenchEnabled(name) == false)
+        return;
+    BenchObjectReset();
+
+    ObjectCache cache(BenchObjectDestroy);
+    void* objects[ObjectCache::CAPACITY + 2];
+    for (int i = 0; i < ObjectCache::CAPACITY + 2; ++i)
+    {
+        objects[i] = BenchObjectCreate();
+        cache.Give(ObjectCache::Key(2, 48000, 1, false), objects[i]);
+    }
+
+    // The two oldest went out, in order, and nothing else did.
+    if (cache.Count() != ObjectCache::CAPACITY || BenchObjectDestroyed != 2)
+        BenchFail(name, "give past capacity does not evict one each");
+    if ((*(int*)objects[0]) != 0 || (*(int*)objects[1]) != 0)
+        BenchFail(name, "eviction does not pick the oldest");
+    for (int i = 2; i < ObjectCache::CAPACITY + 2; ++i)
+    {
+        if ((*(int*)objects[i]) != 1)
+            BenchFail(name, "eviction destroys a newer object");
+    }
+
+    // Taking one frees its slot, so the next give evicts nothing.
+    if (cache.Take(ObjectCache::Key(2, 48000, 1, false)) != objects[ObjectCache::CAPACITY + 1])
+        BenchFail(name, "take after eviction returns the wrong object");
+    cache.Give(ObjectCache::Key(1, 16000, 1, true), objects[ObjectCache::CAPACITY + 1]);
+    if (BenchObjectDestroyed != 2)
+        BenchFail(name, "give into a free slot evicts");
+}
+//------------------------------------------------------------------------------
+static void BenchObjectFlush()
+{
+    const char* name = "object/cache/flush";
+    if (BenchEnabled(name) == false)
+        return;
+    BenchObjectReset();
+
+    {
+        ObjectCache cache(BenchObjectDestroy);
+        for (int i = 0; i < ObjectCache::CAPACITY; ++i)
+        {
+            cache.Give(ObjectCache::Key(2, 48000, 1, i & 1), BenchObjectCreate());
+        }
+        cache.Flush();
+        if (cache.Count() != 0 || BenchObjectDestroyed != ObjectCache::CAPACITY)
+            BenchFail(name, "flush does not destroy every object");
+        cache.Flush();
+        if (BenchObjectDestroyed != ObjectCache::CAPACITY)
+            BenchFail(name, "flush of an empty cache destroys");
+
+        // Whatever is parked when the cache goes away is destroyed too.
+        cache.Give(ObjectCache::Key(2, 48000, 1, false), BenchObjectCreate());
+    }
+    if (BenchObjectDestroyed != BenchObjectCreated)
+        BenchFail(name, "destructor does not flush");
+    for (int alive : BenchObjectAlive)
+    {
+        if (alive != 0)
+            BenchFail(name, "object destroyed twice");
+    }
+}
+//------------------------------------------------------------------------------
+// One operation is the stop and restart of a stream that finds its player
+// parked: Give, then Take with the same key.
+//------------------------------------------------------------------------------
+static void BenchObjectReuse(void* context, uint64_t count)
+{
+    ObjectCache& cache = *(ObjectCache*)context;
+    uint64_t key = ObjectCache::Key(2, 48000, 1, false);
+    void* object = &BenchObjectAlive[0];
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        cache.Give(key, object);
+        object = cache.Take(key);
+    }
+}
+//------------------------------------------------------------------------------
+void BenchObject()
+{
+    BenchObjectShared();
+    BenchObjectKey();
+    BenchObjectEvict();
+    BenchObjectFlush();
+
+    if (BenchEnabled("object/cache/reuse"))
+    {
+        ObjectCache cache(BenchObjectDestroy);
+        BenchMeasure("object/cache/reuse", 0, BenchObjectReuse, &cache);
+    }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,182 @@
+//==============================================================================
+// Benchmark - Pipeline
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <stdio.h>
+#include <string.h>
+#include "Mixer.h"
+#include "NullAudio.h"
+#include "StreamCore.h"
+#include "Telemetry.h"
+#include "Waveform.h"
+#include "Bench.h"
+
+#define BENCH_PIPELINE_RATE     48000
+#define BENCH_PIPELINE_CHANNEL  2
+#define BENCH_PIPELINE_STREAM   4
+#define BENCH_PIPELINE_BATCH    8
+
+//------------------------------------------------------------------------------
+// One operation is a whole packet: Queue at the sender rate, then step the
+// virtual clock by the packet length so the null device renders every period
+// that falls due and hands it to the sink. The clock never waits, so the time
+// is all CPU spent between the caller and the device buffer. A batch case
+// hands a burst of packets to one QueueBatch and steps over all of them.
+//------------------------------------------------------------------------------
+struct BenchPipelineCase
+{
+    struct NullAudio* nullAudio;
+    struct Mixer* mixer;
+    struct MixerStream* stream[BENCH_PIPELINE_STREAM];
+    int streams;
+    int batch;
+    uint64_t now;
+    uint64_t packet;
+    size_t bufferSize;
+    uint64_t sunk;
+
+    char buffer[40 * 44100 / 1000 * BENCH_PIPELINE_CHANNEL * sizeof(float)];
+};
+//------------------------------------------------------------------------------
+static void BenchPipelineSink(void* context, void*, size_t bufferSize)
+{
+    BenchPipelineCase& thiz = *(BenchPipelineCase*)context;
+
+    thiz.sunk += bufferSize;
+}
+//------------------------------------------------------------------------------
+static void BenchPipelineQueue(void* context, uint64_t count)
+{
+    BenchPipelineCase& thiz = *(BenchPipelineCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        NullAudioQueue(thiz.nullAudio, thiz.now, thiz.now, 0, thiz.buffer, thiz.bufferSize, 2);
+        thiz.now = NullAudioStep(thiz.nullAudio, thiz.packet);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchPipelineBatch(void* context, uint64_t count)
+{
+    BenchPipelineCase& thiz = *(BenchPipelineCase*)context;
+
+    StreamPacket packet[BENCH_PIPELINE_BATCH];
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        for (int b = 0; b < thiz.batch; ++b)
+        {
+            packet[b].timestamp = thiz.now + thiz.packet * b;
+            packet[b].buffer = thiz.buffer;
+            packet[b].bufferSize = thiz.bufferSize;
+        }
+        NullAudioQueueBatch(thiz.nullAudio, thiz.now, 0, packet, thiz.batch, 2);
+        thiz.now = NullAudioStep(thiz.nullAudio, thiz.packet * thiz.batch);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchPipelineMixer(void* context, uint64_t count)
+{
+    BenchPipelineCase& thiz = *(BenchPipelineCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        for (int s = 0; s < thiz.streams; ++s)
+        {
+            MixerStreamQueue(thiz.stream[s], thiz.now, thiz.now, 0, thiz.buffer, thiz.bufferSize, 2);
+        }
+        thiz.now = NullAudioStep(thiz.nullAudio, thiz.packet);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchPipelineCheck(BenchPipelineCase& thiz, const char* name, uint64_t bytesPerSecond)
+{
+    TelemetrySnapshot snapshot = {};
+    NullAudioTelemetry(thiz.nullAudio, &snapshot);
+
+    // Every packet stepped must have come out of the device, minus the gap.
+    uint64_t stepped = (thiz.now - NULLAUDIO_EPOCH) * bytesPerSecond / 1000000;
+    if (thiz.sunk + bytesPerSecond / 10 < stepped)
+        BenchFail(name, "device fell behind the clock");
+    if (snapshot.resyncs)
+        BenchFail(name, "stream resynced");
+}
+//------------------------------------------------------------------------------
+void BenchPipeline()
+{
+    static const int packets[] = { 10, 20, 40 };
+    static const struct
+    {
+        const char* name;
+        int format;
+        int inputRate;
+        int streams;
+        int batch;
+    } pipelines[] =
+    {
+        { "s16",            WAVEFORM_S16,   BENCH_PIPELINE_RATE,    0,                      0 },
+        { "s16-batch8",     WAVEFORM_S16,   BENCH_PIPELINE_RATE,    0,                      BENCH_PIPELINE_BATCH },
+        { "f32",            WAVEFORM_F32,   BENCH_PIPELINE_RATE,    0,                      0 },
+        { "mixer1-44100",   WAVEFORM_S16,   44100,                  1,                      0 },
+        { "mixer4",         WAVEFORM_S16,   BENCH_PIPELINE_RATE,    BENCH_PIPELINE_STREAM,  0 },
+    };
+    static BenchPipelineCase test;
+
+    for (const auto& pipeline : pipelines)
+    {
+        for (int packet : packets)
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "pipeline/%s/%dms", pipeline.name, packet);
+            if (BenchEnabled(name) == false)
+                continue;
+
+            memset(&test, 0, sizeof(test));
+            test.nullAudio = NullAudioCreate(BENCH_PIPELINE_CHANNEL, BENCH_PIPELINE_RATE, 1, false, pipeline.format);
+            if (test.nullAudio == nullptr)
+            {
+                BenchFail(name, "NullAudioCreate");
+                continue;
+            }
+            NullAudioSink(test.nullAudio, BenchPipelineSink, &test);
+            NullAudioVolume(test.nullAudio, 1.0f);
+
+            size_t frame = sizeWaveform(pipeline.format) * BENCH_PIPELINE_CHANNEL;
+            test.packet = packet * 1000;
+            test.bufferSize = pipeline.inputRate * packet / 1000 * frame;
+            static float ramp[sizeof(test.buffer) / sizeof(float)];
+            for (size_t i = 0; i < sizeof(ramp) / sizeof(float); ++i)
+                ramp[i] = (float)(i % 480) / 960.0f - 0.25f;
+            convertWaveform(test.buffer, pipeline.format, ramp, WAVEFORM_F32, sizeof(test.buffer) / sizeWaveform(pipeline.format), 1.0f);
+
+            // Mixer streams run at the mixer format and convert the rate on
+            // the way into their rings.
+            test.streams = pipeline.streams;
+            if (test.streams)
+            {
+                test.mixer = MixerCreate(BENCH_PIPELINE_CHANNEL, BENCH_PIPELINE_RATE);
+                NullAudioMixer(test.nullAudio, test.mixer);
+                for (int s = 0; s < test.streams; ++s)
+                {
+                    test.stream[s] = MixerStreamCreate(test.mixer, 1, pipeline.inputRate);
+                }
+            }
+
+            test.batch = pipeline.batch;
+            test.now = NullAudioStep(test.nullAudio, 0);
+            if (test.batch)
+                BenchMeasure(name, test.bufferSize * test.batch, BenchPipelineBatch, &test);
+            else
+                BenchMeasure(name, test.bufferSize * (test.streams ? test.streams : 1), test.streams ? BenchPipelineMixer : BenchPipelineQueue, &test);
+            BenchPipelineCheck(test, name, BENCH_PIPELINE_RATE * frame);
+
+            for (int s = 0; s < BENCH_PIPELINE_STREAM; ++s)
+            {
+                MixerStreamDestroy(test.stream[s]);
+            }
+            NullAudioDestroy(test.nullAudio);
+            MixerDestroy(test.mixer);
+        }
+    }
+}
@@ -0,0 +1,288 @@
+//==============================================================================
+// Benchmark - Resampler
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "NullAudio.h"
+#include "Resampler.h"
+#include "Bench.h"
+
+#define BENCH_RESAMPLER_CHANNEL 2
+#define BENCH_RESAMPLER_BLOCK   10
+#define BENCH_RESAMPLER_PHASES  64
+#define BENCH_RESAMPLER_PULSE   64
+#define BENCH_RESAMPLER_TONE    1000
+#define BENCH_RESAMPLER_PACKET  20
+#define BENCH_RESAMPLER_SECOND  2
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//------------------------------------------------------------------------------
+// One operation converts a block of BENCH_RESAMPLER_BLOCK ms of stereo
+// input, so throughput is input bytes per second at each quality.
+//------------------------------------------------------------------------------
+struct BenchResamplerRate
+{
+    const char* name;
+    int inputRate;
+    int outputRate;
+};
+
+struct BenchResamplerCase
+{
+    struct Resampler* resampler;
+    std::vector<int16_t> input;
+    std::vector<int16_t> output;
+    size_t inputFrames;
+    size_t outputFrames;
+};
+//------------------------------------------------------------------------------
+static void BenchResamplerProcess(void* context, uint64_t count)
+{
+    BenchResamplerCase& thiz = *(BenchResamplerCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        size_t used = 0;
+        ResamplerProcess(thiz.resampler, thiz.input.data(), thiz.inputFrames, thiz.output.data(), thiz.outputFrames, &used);
+    }
+}
+//------------------------------------------------------------------------------
+// The latency of a quality is where a step comes out against where it went
+// in, taken at half its height, with the step on BENCH_RESAMPLER_PHASES
+// input frames in a row so that it meets every phase of the filter. It has
+// to match ResamplerLatency within an input and an output frame.
+//------------------------------------------------------------------------------
+static void BenchResamplerLatency(const BenchResamplerRate& rate, int quality, const char* name)
+{
+    struct Resampler* resampler = ResamplerCreate(1, rate.inputRate, rate.outputRate, quality);
+    if (resampler == nullptr)
+    {
+        BenchFail(name, "ResamplerCreate");
+        return;
+    }
+
+    size_t latency = ResamplerLatency(resampler);
+    double expect = latency * 1000.0 / rate.inputRate;
+    double tolerance = 1000.0 / rate.inputRate + 1000.0 / rate.outputRate;
+    std::vector<double> values;
+    for (int phase = 0; phase < BENCH_RESAMPLER_PHASES; ++phase)
+    {
+        size_t edge = BENCH_RESAMPLER_PULSE + phase;
+        std::vector<int16_t> input(edge + BENCH_RESAMPLER_PULSE + latency * 2);
+        for (size_t i = edge; i < input.size(); ++i)
+            input[i] = 16384;
+
+        ResamplerReset(resampler);
+        size_t frames = 0;
+        const int16_t* output = ResamplerConvert(resampler, input.data(), input.size(), &frames);
+        size_t heard = 0;
+        while (heard < frames && output[heard] < 8192)
+            heard++;
+        if (heard == frames)
+            continue;
+
+        // The step lies halfway between the last silent frame and the first
+        // loud one.
+        double value = heard * 1000.0 / rate.outputRate - (edge - 0.5) * 1000.0 / rate.inputRate;
+        values.push_back(value);
+        if (fabs(value - expect) > tolerance)
+        {
+            char reason[96];
+            snprintf(reason, 96, "step out at %.3f ms, ResamplerLatency says %.3f ms", value, expect);
+            BenchFail(name, reason);
+            break;
+        }
+    }
+    ResamplerDestroy(resampler);
+
+    BenchDistribution(name, "ms", values.data(), values.size(), BENCH_RESAMPLER_PHASES - values.size());
+}
+//------------------------------------------------------------------------------
+// A stream converts through the same resampler: a player fed at inputRate
+// plays at the device rate, and a recorder at the device rate hands out
+// buffers at inputRate. Either way a tone has to keep its pitch and the
+// buffers their count.
+//------------------------------------------------------------------------------
+struct BenchResamplerTone
+{
+    double phase;
+    double step;
+    int64_t last;
+    uint64_t frames;
+    uint64_t crossings;
+};
+//------------------------------------------------------------------------------
+static void BenchResamplerToneFill(BenchResamplerTone& tone, int16_t* buffer, size_t frames)
+{
+    for (size_t i = 0; i < frames; ++i)
+    {
+        buffer[i] = int16_t(lrint(16384.0 * sin(tone.phase)));
+        tone.phase += tone.step;
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchResamplerToneCount(BenchResamplerTone& tone, const int16_t* buffer, size_t frames)
+{
+    // Counting starts with the tone, past the silence of the pre-roll and
+    // the filter.
+    for (size_t i = 0; i < frames; ++i)
+    {
+        if (tone.frames == 0 && buffer[i] == 0)
+            continue;
+        tone.frames++;
+        if (tone.last < 0 && buffer[i] >= 0)
+            tone.crossings++;
+        tone.last = buffer[i];
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchResamplerSinkPlay(void* context, void* buffer, size_t bufferSize)
+{
+    BenchResamplerToneCount(*(BenchResamplerTone*)context, (int16_t*)buffer, bufferSize / sizeof(int16_t));
+}
+//------------------------------------------------------------------------------
+static void BenchResamplerSinkRecord(void* context, void* buffer, size_t bufferSize)
+{
+    BenchResamplerToneFill(*(BenchResamplerTone*)context, (int16_t*)buffer, bufferSize / sizeof(int16_t));
+}
+//------------------------------------------------------------------------------
+static void BenchResamplerStream(const BenchResamplerRate& rate, bool record, const char* name)
+{
+    struct NullAudio* nullAudio = NullAudioCreate(1, rate.outputRate, 1, record);
+    if (nullAudio == nullptr)
+    {
+        BenchFail(name, "NullAudioCreate");
+        return;
+    }
+
+    BenchResamplerTone device = { 0.0, 2.0 * M_PI * BENCH_RESAMPLER_TONE / rate.outputRate, 0, 0, 0 };
+    BenchResamplerTone stream = { 0.0, 2.0 * M_PI * BENCH_RESAMPLER_TONE / rate.inputRate, 0, 0, 0 };
+    uint64_t start = NullAudioStep(nullAudio, 0);
+    NullAudioPeriod(nullAudio, BENCH_RESAMPLER_BLOCK * rate.outputRate / 1000);
+    NullAudioVolume(nullAudio, 1.0f);
+    NullAudioSink(nullAudio, record ? BenchResamplerSinkRecord : BenchResamplerSinkPlay, &device);
+    if (NullAudioConvert(nullAudio, rate.inputRate) == false)
+    {
+        BenchFail(name, "NullAudioConvert");
+        NullAudioDestroy(nullAudio);
+        return;
+    }
+
+    size_t frames = BENCH_RESAMPLER_PACKET * rate.inputRate / 1000;
+    std::vector<int16_t> packet(frames);
+    uint64_t packetTime = BENCH_RESAMPLER_PACKET * 1000;
+    uint64_t packets = 0;
+    for (uint64_t now = start; now < start + BENCH_RESAMPLER_SECOND * 1000000ull; now = NullAudioStep(nullAudio, packetTime))
+    {
+        if (record)
+        {
+            while (NullAudioDequeue(nullAudio, packet.data(), frames * sizeof(int16_t)) != 0)
+            {
+                BenchResamplerToneCount(stream, packet.data(), frames);
+                packets++;
+            }
+        }
+        else
+        {
+            BenchResamplerToneFill(stream, packet.data(), frames);
+            NullAudioQueue(nullAudio, now, now, 0, packet.data(), frames * sizeof(int16_t), 2);
+            packets++;
+        }
+    }
+    NullAudioDestroy(nullAudio);
+
+    // What reached the far side, as seconds at its own rate.
+    const BenchResamplerTone& heard = record ? stream : device;
+    double seconds = double(heard.frames) / (record ? rate.inputRate : rate.outputRate);
+    double pitch = seconds > 0.0 ? heard.crossings / seconds : 0.0;
+    if (fabs(pitch - BENCH_RESAMPLER_TONE) > BENCH_RESAMPLER_TONE / 50)
+    {
+        char reason[96];
+        snprintf(reason, 96, "a %d Hz tone comes out at %.1f Hz", BENCH_RESAMPLER_TONE, pitch);
+        BenchFail(name, reason);
+    }
+    if (seconds < BENCH_RESAMPLER_SECOND - 0.1 || seconds > BENCH_RESAMPLER_SECOND + 0.1)
+    {
+        char reason[96];
+        snprintf(reason, 96, "%llu packets carried %.3f s", (unsigned long long)packets, seconds);
+        BenchFail(name, reason);
+    }
+}
+//------------------------------------------------------------------------------
+void BenchResampler()
+{
+    static const BenchResamplerRate rates[] =
+    {
+        { "8k-48k",     8000,   48000 },
+        { "16k-48k",    16000,  48000 },
+        { "44.1k-48k",  44100,  48000 },
+        { "48k-44.1k",  48000,  44100 },
+    };
+    static const struct
+    {
+        const char* name;
+        int quality;
+    } qualities[] =
+    {
+        { "low",        RESAMPLER_LOW },
+        { "medium",     RESAMPLER_MEDIUM },
+        { "high",       RESAMPLER_HIGH },
+    };
+
+    for (const BenchResamplerRate& rate : rates)
+    {
+        for (const auto& quality : qualities)
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "resampler/%s/%s", rate.name, quality.name);
+            if (BenchEnabled(name) == false)
+                continue;
+
+            BenchResamplerCase test;
+            test.resampler = ResamplerCreate(BENCH_RESAMPLER_CHANNEL, rate.inputRate, rate.outputRate, quality.quality);
+            if (test.resampler == nullptr)
+            {
+                BenchFail(name, "ResamplerCreate");
+                continue;
+            }
+            test.inputFrames = BENCH_RESAMPLER_BLOCK * rate.inputRate / 1000;
+            test.outputFrames = ResamplerOutputFrames(test.resampler, test.inputFrames);
+            test.input.resize(test.inputFrames * BENCH_RESAMPLER_CHANNEL);
+            test.output.resize(test.outputFrames * BENCH_RESAMPLER_CHANNEL);
+            for (size_t i = 0; i < test.input.size(); ++i)
+                test.input[i] = int16_t(lrint(16384.0 * sin(i * 0.01)));
+
+            BenchMeasure(name, test.inputFrames * BENCH_RESAMPLER_CHANNEL * sizeof(int16_t), BenchResamplerProcess, &test);
+            ResamplerDestroy(test.resampler);
+        }
+
+        for (const auto& quality : qualities)
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "resampler/%s/%s/latency", rate.name, quality.name);
+            if (BenchEnabled(name) == false)
+                continue;
+
+            BenchResamplerLatency(rate, quality.quality, name);
+        }
+
+        static const char* const directions[] = { "play", "record" };
+        for (int record = 0; record < 2; ++record)
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "resampler/%s/%s", rate.name, directions[record]);
+            if (BenchEnabled(name) == false)
+                continue;
+
+            BenchResamplerStream(rate, record != 0, name);
+        }
+    }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,212 @@
+//==============================================================================
+// Benchmark - RingBuffer
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <functional>
+#include <thread>
+#include "RingBuffer.h"
+#include "Bench.h"
+
+#define BENCH_RING_SIZE 65536
+#define BENCH_QUEUE_SIZE 4096
+#define BENCH_QUEUE_WORDS (1 << 22)
+
+//------------------------------------------------------------------------------
+struct BenchRingCase
+{
+    RingBuffer* ring;
+    uint64_t index;
+    size_t size;
+    char data[16384];
+};
+//------------------------------------------------------------------------------
+static void BenchRingGather(void* context, uint64_t count)
+{
+    BenchRingCase& thiz = *(BenchRingCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.ring->Gather(thiz.index, thiz.data, thiz.size, true);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchRingScatter(void* context, uint64_t count)
+{
+    BenchRingCase& thiz = *(BenchRingCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.ring->Scatter(thiz.index, thiz.data, thiz.size);
+    }
+}
+//------------------------------------------------------------------------------
+// A producer thread and the calling thread as consumer pass words that count
+// up through Reserve / Commit and Peek / Release. The producer writes runs of
+// varying length and the consumer reads fixed chunks, so the two sides rarely
+// line up and the wrap is crossed at every offset. A word that does not hold
+// the count the consumer expects was torn or read out of order.
+//------------------------------------------------------------------------------
+struct BenchQueueCase
+{
+    RingQueue* queue;
+    size_t chunk;
+    uint64_t errors;
+};
+//------------------------------------------------------------------------------
+static void BenchQueueProduce(RingQueue& queue, uint64_t words, size_t chunk)
+{
+    uint64_t send = queue.LoadSend();
+    uint32_t seed = 1;
+    uint64_t next = 0;
+    while (next < words)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t count = 1 + (seed >> 16) % chunk;
+        if (count > words - next)
+            count = size_t(words - next);
+        size_t size = count * sizeof(uint32_t);
+        while (queue.Free() < size)
+            std::this_thread::yield();
+
+        char* span[2];
+        size_t spanSize[2];
+        queue.Reserve(send, size, span, spanSize);
+        for (int i = 0; i < 2; ++i)
+        {
+            uint32_t* word = (uint32_t*)span[i];
+            for (size_t j = 0; j < spanSize[i] / sizeof(uint32_t); ++j)
+                word[j] = uint32_t(next++);
+        }
+        queue.Commit();
+        send += size;
+    }
+}
+//------------------------------------------------------------------------------
+static uint64_t BenchQueueConsume(RingQueue& queue, uint64_t words, size_t chunk)
+{
+    uint64_t errors = 0;
+    uint64_t expect = 0;
+    while (expect < words)
+    {
+        size_t count = words - expect < chunk ? size_t(words - expect) : chunk;
+        size_t size = count * sizeof(uint32_t);
+
+        char* span[2];
+        size_t spanSize[2];
+        if (queue.Peek(size, span, spanSize) == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            const uint32_t* word = (uint32_t*)span[i];
+            for (size_t j = 0; j < spanSize[i] / sizeof(uint32_t); ++j)
+            {
+                if (word[j] != uint32_t(expect++))
+                    errors++;
+            }
+        }
+        queue.Release(size);
+    }
+    return errors;
+}
+//------------------------------------------------------------------------------
+static void BenchRingQueue(void* context, uint64_t count)
+{
+    BenchQueueCase& thiz = *(BenchQueueCase*)context;
+
+    uint64_t words = count * thiz.chunk;
+    std::thread producer(BenchQueueProduce, std::ref(*thiz.queue), words, thiz.chunk);
+    thiz.errors += BenchQueueConsume(*thiz.queue, words, thiz.chunk);
+    producer.join();
+}
+//------------------------------------------------------------------------------
+static void BenchRingThreads()
+{
+    static const size_t sizes[] = { 256, 4096 };
+
+    for (int mirror = 0; mirror < 2; ++mirror)
+    {
+        const char* kind = mirror ? "mirror" : "plain";
+        char name[128];
+
+        // A small ring, so the stress run wraps every few runs.
+        RingQueue stress;
+        if (stress.Startup(BENCH_QUEUE_SIZE, mirror != 0) == false)
+        {
+            BenchFail("ring/queue", "Startup");
+            return;
+        }
+        if (mirror && stress.bufferMirror == false)
+            continue;
+        snprintf(name, sizeof(name), "ring/queue/stress/%s", kind);
+        if (BenchEnabled(name))
+        {
+            BenchQueueCase test = { &stress, 64, 0 };
+            BenchRingQueue(&test, BENCH_QUEUE_WORDS / test.chunk);
+            if (test.errors)
+                BenchFail(name, "torn or out of order read");
+        }
+
+        RingQueue queue;
+        if (queue.Startup(BENCH_RING_SIZE, mirror != 0) == false)
+        {
+            BenchFail("ring/queue", "Startup");
+            return;
+        }
+        for (size_t size : sizes)
+        {
+            BenchQueueCase test = { &queue, size / sizeof(uint32_t), 0 };
+            snprintf(name, sizeof(name), "ring/queue/%s/%zu", kind, size);
+            BenchMeasure(name, size, BenchRingQueue, &test);
+            if (test.errors)
+                BenchFail(name, "torn or out of order read");
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void BenchRing()
+{
+    static const size_t sizes[] = { 64, 256, 1024, 4096, 16384 };
+    static BenchRingCase test;
+
+    for (int mirror = 0; mirror < 2; ++mirror)
+    {
+        RingBuffer ring;
+        if (ring.Startup(BENCH_RING_SIZE, mirror != 0) == false)
+        {
+            BenchFail("ring", "Startup");
+            return;
+        }
+        if (mirror && ring.bufferMirror == false)
+            continue;
+        const char* kind = mirror ? "mirror" : "plain";
+
+        for (int wrap = 0; wrap < 2; ++wrap)
+        {
+            for (size_t size : sizes)
+            {
+                // One Scatter up front stamps the blocks, so Gather finds
+                // them in the current lap as it does while a stream plays.
+                test.ring = &ring;
+                test.size = size;
+                test.index = ring.bufferSize + (wrap ? ring.bufferSize - size / 2 : (size_t)RingBuffer::BLOCK_SIZE);
+                memset(test.data, 0x55, sizeof(test.data));
+                ring.Scatter(test.index, test.data, size);
+
+                char name[128];
+                snprintf(name, sizeof(name), "ring/scatter/%s/%s/%zu", kind, wrap ? "wrap" : "linear", size);
+                BenchMeasure(name, size, BenchRingScatter, &test);
+                snprintf(name, sizeof(name), "ring/gather/%s/%s/%zu", kind, wrap ? "wrap" : "linear", size);
+                BenchMeasure(name, size, BenchRingGather, &test);
+            }
+        }
+    }
+
+    BenchRingThreads();
+}
@@ -0,0 +1,396 @@
+//==============================================================================
+// Benchmark - Waveform
+//
+// Copyright (c) 2020 TAiGA
+// https://github.com/metarutaiga/StreamAL
+//==============================================================================
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "Waveform.h"
+#include "Bench.h"
+
+#define BENCH_WAVEFORM_MAX 16384
+#define BENCH_WAVEFORM_TAPS 64
+
+//------------------------------------------------------------------------------
+struct BenchWaveformCase
+{
+    const WaveformKernel* kernel;
+    size_t samples;
+    float matrix[WAVEFORM_CHANNEL_MAX * WAVEFORM_CHANNEL_MAX];
+    int16_t taps[BENCH_WAVEFORM_TAPS];
+
+    int16_t input16[BENCH_WAVEFORM_MAX];
+    int16_t output16[BENCH_WAVEFORM_MAX];
+    float input32[BENCH_WAVEFORM_MAX];
+    float output32[BENCH_WAVEFORM_MAX];
+};
+//------------------------------------------------------------------------------
+static void BenchWaveformScale(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->scale(thiz.output16, thiz.input16, thiz.samples, 0.5f);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformScaleQ15(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->scaleQ15(thiz.output16, thiz.input16, thiz.samples, 0x4000);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformActivity(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+    WaveformActivity activity = {};
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->scaleActivity(thiz.output16, thiz.input16, thiz.samples, 0.5f, 2, &activity);
+    }
+    thiz.output32[0] += float(activity.crossings);
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformMeter(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+    WaveformMeter meter = {};
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->scaleMeter(thiz.output16, thiz.input16, thiz.samples, 0.5f, 2, &meter);
+    }
+    thiz.output32[0] += float(meter.peak[0]);
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformMix(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->mix(thiz.output16, thiz.input16, thiz.samples, 0.5f);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformMixQ15(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->mixQ15(thiz.output16, thiz.input16, thiz.samples, 0x4000);
+    }
+}
+//------------------------------------------------------------------------------
+// A FIR filter over the input, one dot product of BENCH_WAVEFORM_TAPS per
+// step, as the resampler runs it.
+static void BenchWaveformDot(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        int32_t sum = 0;
+        for (size_t j = 0; j + BENCH_WAVEFORM_TAPS <= thiz.samples; j += BENCH_WAVEFORM_TAPS)
+            sum += thiz.kernel->dot(thiz.input16 + j, thiz.taps, BENCH_WAVEFORM_TAPS) >> 15;
+        thiz.output32[0] += float(sum);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformCorrelate(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.output32[0] += thiz.kernel->correlate(thiz.input32, thiz.input32 + 1, thiz.samples);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformWiden(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->convert[WAVEFORM_S16][WAVEFORM_F32](thiz.output32, thiz.input16, thiz.samples, 1.0f / 32768.0f);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformNarrow(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->convert[WAVEFORM_F32][WAVEFORM_S16](thiz.output16, thiz.input32, thiz.samples, 32768.0f);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformInterleave(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+    const void* planes[2] = { thiz.input16, thiz.input16 + BENCH_WAVEFORM_MAX / 2 };
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->interleave16(thiz.output16, planes, 0, 2, thiz.samples / 2);
+    }
+}
+//------------------------------------------------------------------------------
+static void BenchWaveformRemix(void* context, uint64_t count)
+{
+    BenchWaveformCase& thiz = *(BenchWaveformCase*)context;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        thiz.kernel->remix(thiz.output32, thiz.input32, thiz.samples / 6, thiz.matrix, 6, 2);
+    }
+}
+//------------------------------------------------------------------------------
+// Every kernel runs once against the scalar reference on an odd count, so a
+// table that times well but answers wrong does not go unnoticed.
+static void BenchWaveformCheck(BenchWaveformCase& thiz, const WaveformKernel* scalar)
+{
+    static int16_t expect16[BENCH_WAVEFORM_MAX];
+    static int16_t extreme16[BENCH_WAVEFORM_MAX];
+    static float expect32[BENCH_WAVEFORM_MAX];
+    size_t samples = 1027 * 6;
+    char name[128];
+
+    scalar->scale(expect16, thiz.input16, samples, 0.5f);
+    thiz.kernel->scale(thiz.output16, thiz.input16, samples, 0.5f);
+    snprintf(name, sizeof(name), "waveform/scale/%s", thiz.kernel->name);
+    if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0)
+        BenchFail(name, "differs from scalar");
+
+    // A gain above one saturates most of the full scale input.
+    scalar->scale(expect16, thiz.input16, samples, 2.7f);
+    thiz.kernel->scale(thiz.output16, thiz.input16, samples, 2.7f);
+    snprintf(name, sizeof(name), "waveform/scale/%s/saturate", thiz.kernel->name);
+    if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0)
+        BenchFail(name, "differs from scalar");
+
+    // Q15 gains run at both ends of the range as well, over an input that
+    // hits both ends too, where -32768 by -32768 has to saturate.
+    static const int16_t gains[] = { 0x6000, SHRT_MIN, SHRT_MAX };
+    memcpy(extreme16, thiz.input16, (samples + 1) * sizeof(int16_t));
+    for (size_t i = 0; i <= samples; i += 7)
+        extreme16[i] = SHRT_MIN;
+    for (size_t i = 3; i <= samples; i += 11)
+        extreme16[i] = SHRT_MAX;
+    for (int16_t gain : gains)
+    {
+        scalar->scaleQ15(expect16, extreme16, samples, gain);
+        thiz.kernel->scaleQ15(thiz.output16, extreme16, samples, gain);
+        snprintf(name, sizeof(name), "waveform/scaleQ15/%s/%d", thiz.kernel->name, gain);
+        if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0)
+            BenchFail(name, "differs from scalar");
+    }
+
+    for (size_t channels = 1; channels <= WAVEFORM_CHANNEL_MAX; ++channels)
+    {
+        WaveformActivity expect = {};
+        WaveformActivity activity = {};
+        scalar->scaleActivity(expect16, thiz.input16, samples, 1.5f, channels, &expect);
+        thiz.kernel->scaleActivity(thiz.output16, thiz.input16, samples, 1.5f, channels, &activity);
+        snprintf(name, sizeof(name), "waveform/activity/%s/%zu", thiz.kernel->name, channels);
+        if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0 ||
+            expect.energy != activity.energy || expect.crossings != activity.crossings || expect.samples != activity.samples)
+            BenchFail(name, "differs from scalar");
+
+        WaveformMeter expectMeter = {};
+        WaveformMeter meter = {};
+        scalar->scaleMeter(expect16, thiz.input16, samples, 1.5f, channels, &expectMeter);
+        thiz.kernel->scaleMeter(thiz.output16, thiz.input16, samples, 1.5f, channels, &meter);
+        snprintf(name, sizeof(name), "waveform/meter/%s/%zu", thiz.kernel->name, channels);
+        if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0 || memcmp(&expectMeter, &meter, sizeof(meter)) != 0)
+            BenchFail(name, "differs from scalar");
+    }
+
+    memcpy(expect16, thiz.input16, samples * sizeof(int16_t));
+    memcpy(thiz.output16, thiz.input16, samples * sizeof(int16_t));
+    scalar->mix(expect16, thiz.input16 + 1, samples, 0.5f);
+    thiz.kernel->mix(thiz.output16, thiz.input16 + 1, samples, 0.5f);
+    snprintf(name, sizeof(name), "waveform/mix/%s", thiz.kernel->name);
+    if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0)
+        BenchFail(name, "differs from scalar");
+
+    for (int16_t gain : gains)
+    {
+        memcpy(expect16, thiz.input16, samples * sizeof(int16_t));
+        memcpy(thiz.output16, thiz.input16, samples * sizeof(int16_t));
+        scalar->mixQ15(expect16, extreme16 + 1, samples, gain);
+        thiz.kernel->mixQ15(thiz.output16, extreme16 + 1, samples, gain);
+        snprintf(name, sizeof(name), "waveform/mixQ15/%s/%d", thiz.kernel->name, gain);
+        if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0)
+            BenchFail(name, "differs from scalar");
+    }
+
+    // Every length up to the taps, at odd offsets, so each tail is covered.
+    snprintf(name, sizeof(name), "waveform/dot/%s", thiz.kernel->name);
+    for (size_t length = 1; length <= BENCH_WAVEFORM_TAPS; ++length)
+    {
+        const int16_t* input = thiz.input16 + length * 3;
+        if (scalar->dot(input, thiz.taps, length) != thiz.kernel->dot(input, thiz.taps, length))
+        {
+            BenchFail(name, "differs from scalar");
+            break;
+        }
+    }
+
+    // Sums only match to rounding, relative to the energy of the inputs.
+    float correlate = scalar->correlate(thiz.input32, thiz.input32 + 1, samples);
+    float energy = scalar->correlate(thiz.input32, thiz.input32, samples);
+    snprintf(name, sizeof(name), "waveform/correlate/%s", thiz.kernel->name);
+    if (fabsf(correlate - thiz.kernel->correlate(thiz.input32, thiz.input32 + 1, samples)) > energy * 1e-5f)
+        BenchFail(name, "differs from scalar");
+
+    scalar->convert[WAVEFORM_S16][WAVEFORM_F32](expect32, thiz.input16, samples, 1.0f / 32768.0f);
+    thiz.kernel->convert[WAVEFORM_S16][WAVEFORM_F32](thiz.output32, thiz.input16, samples, 1.0f / 32768.0f);
+    snprintf(name, sizeof(name), "waveform/widen/%s", thiz.kernel->name);
+    if (memcmp(expect32, thiz.output32, samples * sizeof(float)) != 0)
+        BenchFail(name, "differs from scalar");
+
+    scalar->convert[WAVEFORM_F32][WAVEFORM_S16](expect16, thiz.input32, samples, 32768.0f);
+    thiz.kernel->convert[WAVEFORM_F32][WAVEFORM_S16](thiz.output16, thiz.input32, samples, 32768.0f);
+    snprintf(name, sizeof(name), "waveform/narrow/%s", thiz.kernel->name);
+    if (memcmp(expect16, thiz.output16, samples * sizeof(int16_t)) != 0)
+        BenchFail(name, "differs from scalar");
+
+    // An odd frame count and a plane offset, so the tails and the offset
+    // arithmetic are covered. Whatever a kernel does not write stays zero in
+    // both buffers.
+    static const size_t layouts[] = { 2, 6, 8 };
+    for (size_t channels : layouts)
+    {
+        size_t frames = 1021;
+        size_t offset = 5;
+        size_t plane = frames + offset;
+        const void* input16[WAVEFORM_CHANNEL_MAX];
+        const void* input32[WAVEFORM_CHANNEL_MAX];
+        void* expectPlanes16[WAVEFORM_CHANNEL_MAX];
+        void* expectPlanes32[WAVEFORM_CHANNEL_MAX];
+        void* outputPlanes16[WAVEFORM_CHANNEL_MAX];
+        void* outputPlanes32[WAVEFORM_CHANNEL_MAX];
+        for (size_t i = 0; i < channels; ++i)
+        {
+            input16[i] = thiz.input16 + i * plane;
+            input32[i] = thiz.input32 + i * plane;
+            expectPlanes16[i] = expect16 + i * plane;
+            expectPlanes32[i] = expect32 + i * plane;
+            outputPlanes16[i] = thiz.output16 + i * plane;
+            outputPlanes32[i] = thiz.output32 + i * plane;
+        }
+
+        scalar->interleave16(expect16, input16, offset, channels, frames);
+        thiz.kernel->interleave16(thiz.output16, input16, offset, channels, frames);
+        snprintf(name, sizeof(name), "waveform/interleave16/%s/%zu", thiz.kernel->name, channels);
+        if (memcmp(expect16, thiz.output16, frames * channels * sizeof(int16_t)) != 0)
+            BenchFail(name, "differs from scalar");
+
+        scalar->interleave32(expect32, input32, offset, channels, frames);
+        thiz.kernel->interleave32(thiz.output32, input32, offset, channels, frames);
+        snprintf(name, sizeof(name), "waveform/interleave32/%s/%zu", thiz.kernel->name, channels);
+        if (memcmp(expect32, thiz.output32, frames * channels * sizeof(float)) != 0)
+            BenchFail(name, "differs from scalar");
+
+        memset(expect16, 0, plane * channels * sizeof(int16_t));
+        memset(thiz.output16, 0, plane * channels * sizeof(int16_t));
+        scalar->deinterleave16(expectPlanes16, offset, thiz.input16, channels, frames);
+        thiz.kernel->deinterleave16(outputPlanes16, offset, thiz.input16, channels, frames);
+        snprintf(name, sizeof(name), "waveform/deinterleave16/%s/%zu", thiz.kernel->name, channels);
+        if (memcmp(expect16, thiz.output16, plane * channels * sizeof(int16_t)) != 0)
+            BenchFail(name, "differs from scalar");
+
+        memset(expect32, 0, plane * channels * sizeof(float));
+        memset(thiz.output32, 0, plane * channels * sizeof(float));
+        scalar->deinterleave32(expectPlanes32, offset, thiz.input32, channels, frames);
+        thiz.kernel->deinterleave32(outputPlanes32, offset, thiz.input32, channels, frames);
+        snprintf(name, sizeof(name), "waveform/deinterleave32/%s/%zu", thiz.kernel->name, channels);
+        if (memcmp(expect32, thiz.output32, plane * channels * sizeof(float)) != 0)
+            BenchFail(name, "differs from scalar");
+    }
+
+    scalar->remix(expect32, thiz.input32, samples / 6, thiz.matrix, 6, 2);
+    thiz.kernel->remix(thiz.output32, thiz.input32, samples / 6, thiz.matrix, 6, 2);
+    snprintf(name, sizeof(name), "waveform/remix/%s", thiz.kernel->name);
+    for (size_t i = 0; i < samples / 3; ++i)
+    {
+        if (fabsf(expect32[i] - thiz.output32[i]) > 1e-5f)
+        {
+            BenchFail(name, "differs from scalar");
+            break;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void BenchWaveform()
+{
+    static const size_t sizes[] = { 64, 256, 1024, 4096, 16384 };
+    static const struct
+    {
+        const char* name;
+        void (*body)(void* context, uint64_t count);
+        size_t sampleSize;
+    } kernels[] =
+    {
+        { "scale",          BenchWaveformScale,         sizeof(int16_t) },
+        { "scaleQ15",       BenchWaveformScaleQ15,      sizeof(int16_t) },
+        { "activity",       BenchWaveformActivity,      sizeof(int16_t) },
+        { "meter",          BenchWaveformMeter,         sizeof(int16_t) },
+        { "mix",            BenchWaveformMix,           sizeof(int16_t) },
+        { "mixQ15",         BenchWaveformMixQ15,        sizeof(int16_t) },
+        { "dot",            BenchWaveformDot,           sizeof(int16_t) },
+        { "correlate",      BenchWaveformCorrelate,     sizeof(float) },
+        { "widen",          BenchWaveformWiden,         sizeof(int16_t) },
+        { "narrow",         BenchWaveformNarrow,        sizeof(float) },
+        { "interleave",     BenchWaveformInterleave,    sizeof(int16_t) },
+        { "remix",          BenchWaveformRemix,         sizeof(float) },
+    };
+    static BenchWaveformCase test;
+
+    uint32_t seed = 1;
+    for (size_t i = 0; i < BENCH_WAVEFORM_MAX; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        test.input16[i] = (int16_t)(seed >> 16);
+        test.input32[i] = (int16_t)(seed >> 16) / 24576.0f;
+    }
+    matrixWaveform(test.matrix, WAVEFORM_5POINT1, WAVEFORM_STEREO);
+
+    // Taps a sixty-fourth of full scale keep a sum of BENCH_WAVEFORM_TAPS
+    // products inside 32 bits.
+    for (size_t i = 0; i < BENCH_WAVEFORM_TAPS; ++i)
+        test.taps[i] = test.input16[i] / 64;
+
+    const WaveformKernel* scalar = waveformKernel(WAVEFORM_SCALAR);
+    for (int isa = 0; isa < WAVEFORM_ISA_COUNT; ++isa)
+    {
+        test.kernel = waveformKernel(isa);
+        if (test.kernel == nullptr)
+            continue;
+        BenchWaveformCheck(test, scalar);
+
+        for (const auto& kernel : kernels)
+        {
+            for (size_t samples : sizes)
+            {
+                char name[128];
+                snprintf(name, sizeof(name), "waveform/%s/%s/%zu", kernel.name, test.kernel->name, samples);
+                test.samples = samples;
+                BenchMeasure(name, samples * kernel.sampleSize, kernel.body, &test);
+            }
+        }
+    }
+}
@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "Waveform.h"
 
 #ifndef STREAMAL_EXPORT
 #define STREAMAL_EXPORT
@@ -17,9 +18,28 @@ STREAMAL_EXPORT extern bool iAudioUnitAvailable;
 //==============================================================================
 // AudioUnit Utility
 //==============================================================================
-STREAMAL_EXPORT struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBuffer, bool record = false);
+STREAMAL_EXPORT struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBuffer, bool record = false, int format = WAVEFORM_S16);
 STREAMAL_EXPORT uint64_t iAudioUnitQueue(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t iAudioUnitQueuePlanar(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap);
+STREAMAL_EXPORT uint64_t iAudioUnitQueueBatch(struct iAudioUnit* audioUnit, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap);
+STREAMAL_EXPORT uint64_t iAudioUnitQueueSilence(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap);
+STREAMAL_EXPORT size_t iAudioUnitQueueReserve(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2]);
+STREAMAL_EXPORT uint64_t iAudioUnitQueueCommit(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int gap);
 STREAMAL_EXPORT size_t iAudioUnitDequeue(struct iAudioUnit* audioUnit, void* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t iAudioUnitDequeuePlanar(struct iAudioUnit* audioUnit, void* const* buffer, size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT size_t iAudioUnitDequeuePeek(struct iAudioUnit* audioUnit, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop = false);
+STREAMAL_EXPORT void iAudioUnitDequeueRelease(struct iAudioUnit* audioUnit, size_t bufferSize);
+STREAMAL_EXPORT bool iAudioUnitMixer(struct iAudioUnit* audioUnit, struct Mixer* mixer);
+STREAMAL_EXPORT bool iAudioUnitConvert(struct iAudioUnit* audioUnit, int sampleRate);
+STREAMAL_EXPORT bool iAudioUnitDrift(struct iAudioUnit* audioUnit, bool enable);
+STREAMAL_EXPORT bool iAudioUnitConceal(struct iAudioUnit* audioUnit, bool enable);
+STREAMAL_EXPORT bool iAudioUnitPlayout(struct iAudioUnit* audioUnit, bool enable);
+STREAMAL_EXPORT bool iAudioUnitVoice(struct iAudioUnit* audioUnit, bool enable, bool collapse = false);
+STREAMAL_EXPORT bool iAudioUnitSpeech(struct iAudioUnit* audioUnit, uint64_t* collapsed = nullptr);
+STREAMAL_EXPORT bool iAudioUnitMeter(struct iAudioUnit* audioUnit, bool enable);
+STREAMAL_EXPORT bool iAudioUnitTelemetry(struct iAudioUnit* audioUnit, struct TelemetrySnapshot* snapshot);
+STREAMAL_EXPORT bool iAudioUnitLayout(struct iAudioUnit* audioUnit, uint32_t channelMask, uint32_t* deviceMask = nullptr);
+STREAMAL_EXPORT bool iAudioUnitMatrix(struct iAudioUnit* audioUnit, const float* matrix);
 STREAMAL_EXPORT void iAudioUnitReset(struct iAudioUnit* audioUnit);
 STREAMAL_EXPORT void iAudioUnitVolume(struct iAudioUnit* audioUnit, float volume);
 STREAMAL_EXPORT void iAudioUnitDestroy(struct iAudioUnit* audioUnit);
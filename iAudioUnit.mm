@@ -8,8 +8,9 @@
 #include <TargetConditionals.h>
 #include <AudioToolbox/AudioToolbox.h>
 #include <AVFoundation/AVFoundation.h>
-#include "RingBuffer.h"
+#include "StreamCore.h"
 #include "Waveform.h"
+#include "Mixer.h"
 #include "iAudioUnit.h"
 
 #define kBusSpeaker     0
@@ -23,24 +24,10 @@ struct iAudioUnit
 {
     AudioComponentInstance instance;
 
-    RingBuffer bufferQueue;
-    uint64_t bufferQueueSend;
-    uint64_t bufferQueuePick;
-    int64_t bufferQueueSendAdjust;
-    int64_t bufferQueuePickAdjust;
-
-    uint32_t channel;
-    uint32_t sampleRate;
-    uint32_t bytesPerSecond;
-
-    float volume;
+    StreamCore core;
 
     bool cancel;
-    bool ready;
-    bool go;
-    bool record;
 
-    int bufferSize;
     short temp[8192];
 };
 //------------------------------------------------------------------------------
@@ -57,20 +44,12 @@ static OSStatus playerCallback(void* inRefCon,
     {
         short* output = (short*)ioData->mBuffers[0].mData;
         size_t outputSize = ioData->mBuffers[0].mDataByteSize;
-        if (thiz.go)
-        {
-            thiz.bufferQueuePick += thiz.bufferQueue.Gather(thiz.bufferQueuePick, output, outputSize, true);
-            scaleWaveform(output, outputSize, thiz.volume);
-        }
-        else
-        {
-            memset(output, 0, outputSize);
-        }
+        thiz.core.Play(output, outputSize);
 
         return noErr;
     }
 
-    thiz.ready = false;
+    thiz.core.ready = false;
     return noErr;
 };
 //------------------------------------------------------------------------------
@@ -100,14 +79,13 @@ static OSStatus recorderCallback(void* inRefCon,
         {
             short* input = (short*)bufferList.mBuffers[0].mData;
             size_t inputSize = bufferList.mBuffers[0].mDataByteSize;
-            scaleWaveform(input, inputSize, thiz.volume);
-            thiz.bufferQueueSend += thiz.bufferQueue.Scatter(thiz.bufferQueueSend, input, inputSize);
+            thiz.core.Record(input, inputSize);
         }
 
         return noErr;
     }
 
-    thiz.ready = false;
+    thiz.core.ready = false;
     return noErr;
 }
 //------------------------------------------------------------------------------
@@ -121,7 +99,41 @@ static OSStatus dummyCallback(void* inRefCon,
     return noErr;
 }
 //------------------------------------------------------------------------------
-struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBuffer, bool record)
+// Core Audio takes every stream format as is. An unpacked 24-bit description
+// is low-aligned in 32 bits, which is what S24 holds.
+static void iAudioUnitDescribe(AudioStreamBasicDescription& description, const StreamCore& core)
+{
+    description.mSampleRate = core.sampleRate;
+    description.mFormatID = kAudioFormatLinearPCM;
+    description.mFramesPerPacket = 1;
+    description.mChannelsPerFrame = core.deviceChannel;
+    switch (core.deviceFormat)
+    {
+    case WAVEFORM_S24:
+        description.mFormatFlags = kLinearPCMFormatFlagIsSignedInteger;
+        description.mBitsPerChannel = 24;
+        break;
+    case WAVEFORM_F32:
+        description.mFormatFlags = kLinearPCMFormatFlagIsFloat | kLinearPCMFormatFlagIsPacked;
+        description.mBitsPerChannel = 32;
+        break;
+    default:
+        description.mFormatFlags = kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
+        description.mBitsPerChannel = 16;
+        break;
+    }
+    description.mBytesPerFrame = sizeWaveform(core.deviceFormat) * description.mChannelsPerFrame;
+    description.mBytesPerPacket = description.mBytesPerFrame * description.mFramesPerPacket;
+}
+//------------------------------------------------------------------------------
+static void iAudioUnitStart(void* context)
+{
+    iAudioUnit& thiz = *(iAudioUnit*)context;
+
+    AudioOutputUnitStart(thiz.instance);
+}
+//------------------------------------------------------------------------------
+struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBuffer, bool record, int format)
 {
     iAudioUnit* audioUnit = nullptr;
 
@@ -130,18 +142,20 @@ struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBu
         if (iAudioUnitAvailable == false)
             break;
 
-        if (channel == 0)
-            break;
-        if (sampleRate == 0)
-            break;
-
         audioUnit = new iAudioUnit{};
         if (audioUnit == nullptr)
             break;
         iAudioUnit& thiz = (*audioUnit);
 
-        if (thiz.bufferQueue.Startup(sampleRate * sizeof(int16_t) * channel * secondPerBuffer) == false)
+        if (thiz.core.Startup(channel, sampleRate, secondPerBuffer, record, format, iAudioUnitStart, audioUnit) == false)
+            break;
+
+#if TARGET_OS_IPHONE
+        // The voice processing unit stops at stereo, so wider streams fold
+        // down in Play and Record.
+        if (channel > 2 && thiz.core.DeviceLayout(2, nullptr) == false)
             break;
+#endif
 
         if (record)
         {
@@ -161,29 +175,22 @@ struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBu
             if (AudioComponentInstanceNew(inputComponent, &thiz.instance) != noErr)
                 break;
 
-            AudioStreamBasicDescription format = {};
-            format.mSampleRate = sampleRate;
-            format.mFormatID = kAudioFormatLinearPCM;
-            format.mFormatFlags = kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
-            format.mFramesPerPacket = 1;
-            format.mChannelsPerFrame = channel;
-            format.mBitsPerChannel = 16;
-            format.mBytesPerFrame = format.mBitsPerChannel / 8 * format.mChannelsPerFrame;
-            format.mBytesPerPacket = format.mBytesPerFrame * format.mFramesPerPacket;
+            AudioStreamBasicDescription inputFormat = {};
+            iAudioUnitDescribe(inputFormat, thiz.core);
             if (AudioUnitSetProperty(thiz.instance,
                                      kAudioUnitProperty_StreamFormat,
                                      kAudioUnitScope_Input,
                                      kBusSpeaker,
-                                     &format,
-                                     sizeof(format)) != noErr)
+                                     &inputFormat,
+                                     sizeof(inputFormat)) != noErr)
                 break;
 
             if (AudioUnitSetProperty(thiz.instance,
                                      kAudioUnitProperty_StreamFormat,
                                      kAudioUnitScope_Output,
                                      kBusMicrophone,
-                                     &format,
-                                     sizeof(format)) != noErr)
+                                     &inputFormat,
+                                     sizeof(inputFormat)) != noErr)
                 break;
 
             UInt32 enable = 1;
@@ -273,14 +280,7 @@ struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBu
                 break;
 
             AudioStreamBasicDescription outputFormat = {};
-            outputFormat.mSampleRate = sampleRate;
-            outputFormat.mFormatID = kAudioFormatLinearPCM;
-            outputFormat.mFormatFlags = kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
-            outputFormat.mFramesPerPacket = 1;
-            outputFormat.mChannelsPerFrame = channel;
-            outputFormat.mBitsPerChannel = 16;
-            outputFormat.mBytesPerFrame = outputFormat.mBitsPerChannel / 8 * outputFormat.mChannelsPerFrame;
-            outputFormat.mBytesPerPacket = outputFormat.mBytesPerFrame * outputFormat.mFramesPerPacket;
+            iAudioUnitDescribe(outputFormat, thiz.core);
             if (AudioUnitSetProperty(thiz.instance,
                                      kAudioUnitProperty_StreamFormat,
                                      kAudioUnitScope_Input,
@@ -326,12 +326,6 @@ struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBu
             AudioOutputUnitStart(thiz.instance);
         }
 
-        thiz.channel = channel;
-        thiz.sampleRate = sampleRate;
-        thiz.bytesPerSecond = sampleRate * sizeof(int16_t) * channel;
-        thiz.volume = record ? 1.0f : 0.0f;
-        thiz.record = record;
-
         return audioUnit;
     }
     iAudioUnitDestroy(audioUnit);
@@ -339,56 +333,76 @@ struct iAudioUnit* iAudioUnitCreate(int channel, int sampleRate, int secondPerBu
     return nullptr;
 }
 //------------------------------------------------------------------------------
-uint64_t iAudioUnitQueue(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+size_t iAudioUnitQueueReserve(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, void* span[2], size_t spanSize[2])
 {
     if (audioUnit == nullptr)
         return 0;
     iAudioUnit& thiz = (*audioUnit);
-    if (thiz.record)
-        return 0;
-    if (bufferSize == 0)
+
+    return thiz.core.QueueReserve(now, timestamp, adjust, bufferSize, span, spanSize);
+}
+//------------------------------------------------------------------------------
+uint64_t iAudioUnitQueueCommit(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int gap)
+{
+    if (audioUnit == nullptr)
         return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-    if (thiz.ready)
-    {
-        if (thiz.bufferQueueSend < thiz.bufferQueuePick || thiz.bufferQueueSend > thiz.bufferQueuePick + thiz.bytesPerSecond / 2)
-        {
-            thiz.bufferQueueSend = 0;
-            timestamp = now + thiz.bufferQueuePickAdjust;
-        }
-    }
+    return thiz.core.QueueCommit(now, timestamp, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t iAudioUnitQueue(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, const void* buffer, size_t bufferSize, int gap)
+{
+    if (audioUnit == nullptr)
+        return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-    if (thiz.bufferQueueSend == 0 || thiz.bufferQueueSendAdjust != adjust)
-    {
-        thiz.bufferQueueSend = (timestamp + adjust) * thiz.bytesPerSecond / 1000000;
-        thiz.bufferQueueSend = thiz.bufferQueueSend - (thiz.bufferQueueSend % bufferSize);
-        thiz.bufferQueueSendAdjust = adjust;
-    }
-    thiz.bufferQueueSend += thiz.bufferQueue.Scatter(thiz.bufferQueueSend, buffer, bufferSize);
+    return thiz.core.Queue(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t iAudioUnitQueuePlanar(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, const void* const* buffer, size_t bufferSize, int gap)
+{
+    if (audioUnit == nullptr)
+        return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-    if (thiz.ready == false)
-    {
-        thiz.ready = true;
+    return thiz.core.QueuePlanar(now, timestamp, adjust, buffer, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t iAudioUnitQueueBatch(struct iAudioUnit* audioUnit, uint64_t now, int64_t adjust, const struct StreamPacket* packet, size_t count, int gap)
+{
+    if (audioUnit == nullptr)
+        return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-        adjust = 0;
-        if (now > timestamp)
-        {
-            adjust = timestamp - now;
-        }
+    return thiz.core.QueueBatch(now, adjust, packet, count, gap);
+}
+//------------------------------------------------------------------------------
+uint64_t iAudioUnitQueueSilence(struct iAudioUnit* audioUnit, uint64_t now, uint64_t timestamp, int64_t adjust, size_t bufferSize, int gap)
+{
+    if (audioUnit == nullptr)
+        return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-        thiz.bufferSize = bufferSize;
-        thiz.bufferQueuePick = (now + adjust) * thiz.bytesPerSecond / 1000000 - bufferSize * gap;
-        thiz.bufferQueuePick = thiz.bufferQueuePick - (thiz.bufferQueuePick % bufferSize);
-        thiz.bufferQueuePickAdjust = adjust;
+    return thiz.core.QueueSilence(now, timestamp, adjust, bufferSize, gap);
+}
+//------------------------------------------------------------------------------
+size_t iAudioUnitDequeuePeek(struct iAudioUnit* audioUnit, const void* span[2], size_t spanSize[2], size_t bufferSize, bool drop)
+{
+    if (audioUnit == nullptr)
+        return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-        AudioOutputUnitStart(thiz.instance);
-    }
-    else
-    {
-        thiz.go = true;
-    }
+    return thiz.core.DequeuePeek(span, spanSize, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+void iAudioUnitDequeueRelease(struct iAudioUnit* audioUnit, size_t bufferSize)
+{
+    if (audioUnit == nullptr)
+        return;
+    iAudioUnit& thiz = (*audioUnit);
 
-    return thiz.bufferQueuePick * 1000000 / thiz.bytesPerSecond;
+    thiz.core.DequeueRelease(bufferSize);
 }
 //------------------------------------------------------------------------------
 size_t iAudioUnitDequeue(struct iAudioUnit* audioUnit, void* buffer, size_t bufferSize, bool drop)
@@ -396,31 +410,130 @@ size_t iAudioUnitDequeue(struct iAudioUnit* audioUnit, void* buffer, size_t buff
     if (audioUnit == nullptr)
         return 0;
     iAudioUnit& thiz = (*audioUnit);
-    if (thiz.record == false)
-        return 0;
 
-    if (thiz.ready == false)
-    {
-        thiz.ready = true;
+    return thiz.core.Dequeue(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+size_t iAudioUnitDequeuePlanar(struct iAudioUnit* audioUnit, void* const* buffer, size_t bufferSize, bool drop)
+{
+    if (audioUnit == nullptr)
+        return 0;
+    iAudioUnit& thiz = (*audioUnit);
 
-        AudioOutputUnitStart(thiz.instance);
-    }
+    return thiz.core.DequeuePlanar(buffer, bufferSize, drop);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitMixer(struct iAudioUnit* audioUnit, struct Mixer* mixer)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+    if (thiz.core.record)
+        return false;
 
-    if (drop)
+    // Detaching stops the unit before the core forgets the mixer.
+    if (mixer == nullptr)
     {
-        uint64_t available = thiz.bufferQueueSend - thiz.bufferQueuePick;
-        while (available > thiz.bytesPerSecond)
-        {
-            thiz.bufferQueuePick += thiz.bytesPerSecond;
-            available = thiz.bufferQueueSend - thiz.bufferQueuePick;
-        }
+        iAudioUnitReset(audioUnit);
     }
 
-    if (thiz.bufferQueueSend < thiz.bufferQueuePick + bufferSize)
-        return 0;
-    thiz.bufferQueuePick += thiz.bufferQueue.Gather(thiz.bufferQueuePick, buffer, bufferSize, true);
+    return thiz.core.Attach(mixer, 0);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitConvert(struct iAudioUnit* audioUnit, int sampleRate)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.Convert(sampleRate);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitDrift(struct iAudioUnit* audioUnit, bool enable)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.EnableDrift(enable);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitConceal(struct iAudioUnit* audioUnit, bool enable)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.EnableConceal(enable);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitPlayout(struct iAudioUnit* audioUnit, bool enable)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.EnablePlayout(enable);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitVoice(struct iAudioUnit* audioUnit, bool enable, bool collapse)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.EnableVoice(enable, collapse);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitSpeech(struct iAudioUnit* audioUnit, uint64_t* collapsed)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.Speech(collapsed);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitMeter(struct iAudioUnit* audioUnit, bool enable)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    return thiz.core.EnableMeter(enable);
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitTelemetry(struct iAudioUnit* audioUnit, struct TelemetrySnapshot* snapshot)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    thiz.core.telemetry.Read(snapshot);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitLayout(struct iAudioUnit* audioUnit, uint32_t channelMask, uint32_t* deviceMask)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
+
+    if (thiz.core.Layout(channelMask) == false)
+        return false;
+    if (deviceMask)
+        (*deviceMask) = thiz.core.deviceMask;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+bool iAudioUnitMatrix(struct iAudioUnit* audioUnit, const float* matrix)
+{
+    if (audioUnit == nullptr)
+        return false;
+    iAudioUnit& thiz = (*audioUnit);
 
-    return bufferSize;
+    return thiz.core.Matrix(matrix);
 }
 //------------------------------------------------------------------------------
 void iAudioUnitReset(struct iAudioUnit* audioUnit)
@@ -429,18 +542,8 @@ void iAudioUnitReset(struct iAudioUnit* audioUnit)
         return;
     iAudioUnit& thiz = (*audioUnit);
 
-    if (thiz.record)
-    {
-        AudioOutputUnitStop(thiz.instance);
-        thiz.ready = false;
-        thiz.go = false;
-    }
-    else
-    {
-        AudioOutputUnitStop(thiz.instance);
-        thiz.ready = false;
-        thiz.go = false;
-    }
+    AudioOutputUnitStop(thiz.instance);
+    thiz.core.Reset();
 }
 //------------------------------------------------------------------------------
 void iAudioUnitVolume(struct iAudioUnit* audioUnit, float volume)
@@ -449,14 +552,7 @@ void iAudioUnitVolume(struct iAudioUnit* audioUnit, float volume)
         return;
     iAudioUnit& thiz = (*audioUnit);
 
-    if (thiz.record)
-    {
-        thiz.volume = volume;
-    }
-    else
-    {
-        thiz.volume = volume;
-    }
+    thiz.core.volume = volume;
 }
 //------------------------------------------------------------------------------
 void iAudioUnitDestroy(struct iAudioUnit* audioUnit)